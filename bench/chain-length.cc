@@ -0,0 +1,142 @@
+/** @file chain-length.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Parses sources with ever longer sibling chains (commands in a block,
+ * functions in a file, declarations in a var_local and arguments in a call)
+ * and checks that the time per element stays flat, i.e. that building the
+ * chains is linear. Exits with failure if the cost per element of the longest
+ * chain is more than `tolerance` times the one of the shortest.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "driver.hh"
+
+namespace {
+
+constexpr auto tolerance = 4.0;
+
+constexpr std::size_t sizes[] = { 1 << 12, 1 << 13, 1 << 14, 1 << 15, 1 << 16 };
+
+struct shape {
+    char const*                                     name;
+    std::function<void(std::ofstream&, std::size_t)> write;
+};
+
+// identifiers are letters only, so numbers are spelled in base 26
+auto name(char const* prefix, std::size_t number) -> std::string
+{
+    std::string result = prefix;
+
+    do {
+        result += static_cast<char>('a' + number % 26);
+        number /= 26;
+    } while (number != 0);
+
+    return result;
+}
+
+// every source is valid, names declared once and before they are used
+shape const shapes[] = {
+    { "commands",
+        [](std::ofstream& out, std::size_t length) {
+            out << "int main() {\n  int x <= 0;\n";
+            for (std::size_t i = 0; i < length; ++i)
+                out << "  x = x + 1;\n";
+            out << "}\n";
+        } },
+    { "functions",
+        [](std::ofstream& out, std::size_t length) {
+            for (std::size_t i = 0; i < length; ++i)
+                out << "int " << name("f", i) << "() { return 1; }\n";
+        } },
+    { "declarations",
+        [](std::ofstream& out, std::size_t length) {
+            out << "int main() {\n  int " << name("x", 0) << " <= 0";
+            for (std::size_t i = 1; i < length; ++i)
+                out << ", " << name("x", i) << " <= 0";
+            out << ";\n}\n";
+        } },
+    { "arguments",
+        [](std::ofstream& out, std::size_t length) {
+            out << "int f(int " << name("p", 0);
+            for (std::size_t i = 1; i < length; ++i)
+                out << ", int " << name("p", i);
+            out << ") { return 1; }\n";
+            out << "int main() {\n  f(1";
+            for (std::size_t i = 1; i < length; ++i)
+                out << ", 1";
+            out << ");\n}\n";
+        } },
+};
+
+auto time_parse(std::string const& path) -> double
+{
+    hcpsilva::driver driver(path);
+
+    auto const begin  = std::chrono::steady_clock::now();
+    auto const result = driver.parse();
+    auto const end    = std::chrono::steady_clock::now();
+
+    if (result != 0)
+        throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+}
+
+auto main(void) -> int
+{
+    auto const path = (std::filesystem::temp_directory_path() / "chain-length.txt").string();
+
+    auto linear = true;
+
+    fmt::print("{:<14} {:>8} {:>12} {:>14}\n", "shape", "length", "seconds", "ns/element");
+
+    for (auto const& [name, write] : shapes) {
+        std::vector<double> per_element;
+
+        for (auto const length : sizes) {
+            {
+                std::ofstream out(path);
+                write(out, length);
+            }
+
+            auto const seconds = time_parse(path);
+
+            per_element.push_back(seconds * 1e9 / length);
+
+            fmt::print("{:<14} {:>8} {:>12.6f} {:>14.2f}\n", name, length, seconds, per_element.back());
+        }
+
+        if (per_element.back() > tolerance * per_element.front()) {
+            fmt::print(stderr, "{}: cost per element grew {:.1f}x, chains are no longer linear\n",
+                name, per_element.back() / per_element.front());
+            linear = false;
+        }
+    }
+
+    std::filesystem::remove(path);
+
+    return linear ? 0 : 1;
+}
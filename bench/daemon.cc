@@ -0,0 +1,230 @@
+/** @file daemon.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The latency of printing the tree of a generated program from a process
+ * started cold (stage-3) against asking a compiler started with --serve
+ * through cpp-compiler-client, with the file unchanged between requests and
+ * touched before each of them (so it is parsed again). Both must print the
+ * same tree. Takes the paths of cpp-compiler, cpp-compiler-client and stage-3,
+ * the number of requests of each kind and the program shape options of
+ * generator.hh, and prints one JSON object per line and kind of request.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+#include "generator.hh"
+
+namespace {
+
+auto elapsed(std::chrono::steady_clock::time_point begin) -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// starts arguments as a process, its standard input and output redirected to
+// the given files (if any)
+auto spawn(std::vector<std::string> const& arguments, std::string const& input, std::string const& output) -> pid_t
+{
+    std::fflush(stdout);
+
+    auto const child = fork();
+
+    if (child < 0)
+        throw std::runtime_error("benchmark error, could not fork\n");
+
+    if (child == 0) {
+        if (!input.empty()) {
+            auto const in = open(input.c_str(), O_RDONLY);
+
+            dup2(in, STDIN_FILENO);
+            close(in);
+        }
+
+        auto const out = open(output.empty() ? "/dev/null" : output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+        dup2(out, STDOUT_FILENO);
+        close(out);
+
+        std::vector<char*> argv;
+
+        for (auto const& argument : arguments)
+            argv.push_back(const_cast<char*>(argument.c_str()));
+
+        argv.push_back(nullptr);
+
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    return child;
+}
+
+auto finish(pid_t child, std::string_view what) -> void
+{
+    int status = 0;
+
+    waitpid(child, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error(fmt::format("benchmark error, {} failed\n", what));
+}
+
+// runs arguments to completion, giving how long it took
+auto run(std::vector<std::string> const& arguments, std::string const& input, std::string const& output) -> double
+{
+    auto const begin = std::chrono::steady_clock::now();
+
+    finish(spawn(arguments, input, output), arguments.front());
+
+    return elapsed(begin);
+}
+
+auto read_file(std::string const& path) -> std::string
+{
+    std::ifstream      in(path);
+    std::ostringstream text;
+
+    text << in.rdbuf();
+
+    return text.str();
+}
+
+auto report(std::string_view kind, std::vector<double> seconds, hcpsilva::bench::program_size const& size) -> void
+{
+    std::ranges::sort(seconds);
+
+    auto mean = 0.0;
+
+    for (auto const time : seconds)
+        mean += time / static_cast<double>(seconds.size());
+
+    fmt::print("{{\"requests\": \"{}\", \"runs\": {}, \"bytes\": {}, \"tokens\": {}, \"mean_ms\": {:.3f}, "
+               "\"median_ms\": {:.3f}, \"p99_ms\": {:.3f}}}\n",
+        kind, seconds.size(), size.bytes, size.tokens, mean * 1e3, seconds[seconds.size() / 2] * 1e3,
+        seconds[std::min(seconds.size() - 1, seconds.size() * 99 / 100)] * 1e3);
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc < 4) {
+        fmt::print(stderr, "usage: daemon CPP-COMPILER CPP-COMPILER-CLIENT STAGE-3 [RUNS] [SHAPE OPTIONS]\n");
+        return 2;
+    }
+
+    std::string const server = argv[1], client = argv[2], stage = argv[3];
+
+    auto const runs  = argc > 4 ? std::max(1, std::atoi(argv[4])) : 200;
+    auto const shape = hcpsilva::bench::parse_shape(argc, argv, 5);
+
+    auto const directory = std::filesystem::temp_directory_path();
+    auto const prefix    = fmt::format("daemon-{}", getpid());
+    auto const source    = (directory / (prefix + ".txt")).string();
+    auto const socket    = (directory / (prefix + ".sock")).string();
+    auto const cold_tree = (directory / (prefix + ".cold")).string();
+    auto const warm_tree = (directory / (prefix + ".warm")).string();
+
+    hcpsilva::bench::program_size size;
+
+    {
+        std::ofstream out(source);
+
+        size = hcpsilva::bench::generate(out, shape);
+    }
+
+    auto const daemon  = spawn({ server, "--serve", socket }, "", "");
+    auto       success = true;
+
+    try {
+        // up once it answers
+        auto const ask = std::vector<std::string> { client, "--socket", socket, "ast", source };
+
+        for (auto tries = 0;; ++tries) {
+            if (std::filesystem::exists(socket)) {
+                auto const child  = spawn(ask, "", warm_tree);
+                int        status = 0;
+
+                waitpid(child, &status, 0);
+
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+                    break;
+            }
+
+            if (tries == 100)
+                throw std::runtime_error("benchmark error, the server never came up\n");
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        run({ stage }, source, cold_tree);
+
+        if (read_file(cold_tree) != read_file(warm_tree))
+            throw std::runtime_error("benchmark error, the server printed another tree than stage-3\n");
+
+        std::vector<double> cold, warm, touched;
+
+        for (auto i = 0; i < runs; ++i)
+            cold.push_back(run({ stage }, source, ""));
+
+        for (auto i = 0; i < runs; ++i)
+            warm.push_back(run(ask, "", ""));
+
+        for (auto i = 0; i < runs; ++i) {
+            // a new modification time, which is all the server looks at
+            utimensat(AT_FDCWD, source.c_str(), nullptr, 0);
+
+            touched.push_back(run(ask, "", ""));
+        }
+
+        report("cold", cold, size);
+        report("server", warm, size);
+        report("server-touched", touched, size);
+    } catch (std::exception const& error) {
+        fmt::print(stderr, "{}", error.what());
+
+        success = false;
+    }
+
+    try {
+        run({ client, "--socket", socket, "shutdown" }, "", "");
+        finish(daemon, server);
+    } catch (std::exception const& error) {
+        fmt::print(stderr, "{}", error.what());
+
+        success = false;
+    }
+
+    for (auto const& path : { source, cold_tree, warm_tree })
+        std::filesystem::remove(path);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+/** @file flat-ast.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Compares the tree of nodes linked by pointers with the same tree laid out
+ * flat (see flat_ast.hh), over a generated program: the memory each takes per
+ * node, the time it takes to lay it out and the time a pass over every node
+ * takes in each. The pass counts the operators and adds up the integer
+ * literals, which looks at the kind and the payload of every node, as most
+ * later passes do. Takes the program shape options of generator.hh and prints
+ * a JSON object.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include "driver.hh"
+#include "flat_ast.hh"
+#include "generator.hh"
+
+namespace {
+
+constexpr auto repetitions = 5;
+
+struct tally {
+    std::size_t  operators = 0;
+    std::int64_t integers  = 0;
+
+    auto operator==(tally const&) const -> bool = default;
+};
+
+auto elapsed(std::chrono::steady_clock::time_point begin) -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template <typename pass>
+auto best_of(pass&& run, tally& result) -> double
+{
+    auto best = 1e300;
+
+    for (auto i = 0; i < repetitions; ++i) {
+        auto const begin = std::chrono::steady_clock::now();
+
+        result = run();
+
+        best = std::min(best, elapsed(begin));
+    }
+
+    return best;
+}
+
+auto walk_linked(hcpsilva::ast_node const* root) -> tally
+{
+    tally result;
+
+    for (auto const& node : root->preorder()) {
+        if (std::holds_alternative<hcpsilva::operations>(node.value.value))
+            ++result.operators;
+        else if (auto const integer = std::get_if<int>(&node.value.value))
+            result.integers += *integer;
+    }
+
+    return result;
+}
+
+auto walk_flat(hcpsilva::flat_ast const& tree) -> tally
+{
+    using hcpsilva::node_kind;
+
+    tally result;
+
+    auto const& kinds    = tree.all_kinds();
+    auto const& payloads = tree.all_payloads();
+
+    for (std::size_t i = 0; i < kinds.size(); ++i) {
+        auto const kind = kinds[i];
+
+        if (kind >= node_kind::ATTRIBUTION && kind <= node_kind::INDEX_SEP)
+            ++result.operators;
+        else if (kind == node_kind::INTEGER)
+            result.integers += static_cast<std::int32_t>(payloads[i]);
+    }
+
+    return result;
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    auto const shape = hcpsilva::bench::parse_shape(argc, argv);
+    auto const path  = (std::filesystem::temp_directory_path() / fmt::format("flat-ast-{}.txt", getpid())).string();
+
+    try {
+        hcpsilva::bench::program_size size;
+
+        {
+            std::ofstream out(path);
+
+            size = hcpsilva::bench::generate(out, shape);
+        }
+
+        hcpsilva::driver driver(path);
+
+        if (driver.parse() != 0)
+            throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+
+        std::filesystem::remove(path);
+
+        auto const nodes = driver.node_count();
+
+        auto const begin   = std::chrono::steady_clock::now();
+        auto const flat    = driver.flatten();
+        auto const flatten = elapsed(begin);
+
+        tally linked_tally, flat_tally;
+
+        auto const linked_seconds = best_of([&] { return walk_linked(driver.tree()); }, linked_tally);
+        auto const flat_seconds   = best_of([&] { return walk_flat(flat); }, flat_tally);
+
+        if (linked_tally != flat_tally)
+            throw std::runtime_error("benchmark error, the passes disagree\n");
+
+        fmt::print("{{\"functions\": {}, \"commands\": {}, \"depth\": {}, \"dimensions\": {}, \"tokens\": {}, "
+                   "\"nodes\": {}, \"linked_bytes_per_node\": {:.2f}, \"flat_bytes_per_node\": {:.2f}, "
+                   "\"flat_hot_bytes_per_node\": {:.2f}, \"flatten_seconds\": {:.6f}, \"linked_pass_seconds\": {:.6f}, "
+                   "\"flat_pass_seconds\": {:.6f}, \"speedup\": {:.2f}}}\n",
+            shape.functions, shape.commands, shape.depth, shape.dimensions, size.tokens, nodes,
+            static_cast<double>(driver.node_bytes()) / nodes, static_cast<double>(flat.bytes()) / nodes,
+            static_cast<double>(flat.hot_bytes()) / nodes, flatten, linked_seconds, flat_seconds,
+            linked_seconds / flat_seconds);
+    } catch (std::exception const& error) {
+        std::filesystem::remove(path);
+
+        fmt::print(stderr, "{}", error.what());
+        return 1;
+    }
+
+    return 0;
+}
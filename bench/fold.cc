@@ -0,0 +1,139 @@
+/** @file fold.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Folds constants in the tree of a generated program (see ast_folder.hh),
+ * reporting how many nodes that took out of it, how long it took, and how long
+ * the phases after it take over the tree as parsed and as folded: printing it
+ * and laying it out flat. Takes the program shape options of generator.hh and
+ * prints a JSON object.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include "driver.hh"
+#include "generator.hh"
+
+namespace {
+
+constexpr auto repetitions = 5;
+
+auto elapsed(std::chrono::steady_clock::time_point begin) -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template <typename pass>
+auto best_of(pass&& run) -> double
+{
+    auto best = 1e300;
+
+    for (auto i = 0; i < repetitions; ++i) {
+        auto const begin = std::chrono::steady_clock::now();
+
+        run();
+
+        best = std::min(best, elapsed(begin));
+    }
+
+    return best;
+}
+
+// what the phases after folding take over a tree
+struct later_phases {
+    double print_seconds   = 0;
+    double flatten_seconds = 0;
+};
+
+auto time_later_phases(hcpsilva::driver& driver, std::FILE* sink) -> later_phases
+{
+    driver.redirect(sink, stderr);
+
+    later_phases result;
+
+    result.print_seconds   = best_of([&] { driver.print_ast(); });
+    result.flatten_seconds = best_of([&] { driver.flatten(); });
+
+    driver.redirect(stdout, stderr);
+
+    return result;
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    auto const shape = hcpsilva::bench::parse_shape(argc, argv);
+    auto const path  = (std::filesystem::temp_directory_path() / fmt::format("fold-{}.txt", getpid())).string();
+
+    auto const sink   = std::fopen("/dev/null", "w");
+    auto       status = 0;
+
+    try {
+        if (sink == nullptr)
+            throw std::runtime_error("benchmark error, could not open /dev/null\n");
+
+        hcpsilva::bench::program_size size;
+
+        {
+            std::ofstream out(path);
+
+            size = hcpsilva::bench::generate(out, shape);
+        }
+
+        // folding is done in place, so each tree gets a driver of its own
+        hcpsilva::driver parsed(path), folded(path);
+
+        if (parsed.parse() != 0 || folded.parse() != 0)
+            throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+
+        std::filesystem::remove(path);
+
+        // the warnings of generated programs are no news
+        folded.redirect(stdout, sink);
+
+        auto const begin      = std::chrono::steady_clock::now();
+        auto const statistics = folded.optimize();
+        auto const fold       = elapsed(begin);
+
+        auto const before = time_later_phases(parsed, sink);
+        auto const after  = time_later_phases(folded, sink);
+
+        fmt::print("{{\"functions\": {}, \"commands\": {}, \"depth\": {}, \"dimensions\": {}, \"tokens\": {}, "
+                   "\"nodes\": {}, \"removed\": {}, \"folded\": {}, \"simplified\": {}, \"pruned\": {}, "
+                   "\"fold_seconds\": {:.6f}, \"print_seconds\": {:.6f}, \"folded_print_seconds\": {:.6f}, "
+                   "\"flatten_seconds\": {:.6f}, \"folded_flatten_seconds\": {:.6f}}}\n",
+            shape.functions, shape.commands, shape.depth, shape.dimensions, size.tokens, parsed.node_count(),
+            statistics.removed, statistics.folded, statistics.simplified, statistics.pruned, fold,
+            before.print_seconds, after.print_seconds, before.flatten_seconds, after.flatten_seconds);
+    } catch (std::exception const& error) {
+        std::filesystem::remove(path);
+
+        fmt::print(stderr, "{}", error.what());
+        status = 1;
+    }
+
+    if (sink != nullptr)
+        std::fclose(sink);
+
+    return status;
+}
@@ -0,0 +1,143 @@
+/** @file function-threads.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Types and lowers the functions of a generated program over 1, 2, 4... up to
+ * the given number of threads (0 for one per hardware thread), checking that
+ * the code is the same as with a single one. Parsing itself is not spread, so
+ * it's timed along with the typing that follows it, and the speedup is that of
+ * both phases together. Takes the number of threads and then the program shape
+ * options of generator.hh, and prints a JSON object per number of threads.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include "driver.hh"
+#include "generator.hh"
+
+namespace {
+
+constexpr auto repetitions = 5;
+
+auto elapsed(std::chrono::steady_clock::time_point begin) -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+struct timings {
+    double                 parse_seconds = 1e300; // typing included
+    double                 lower_seconds = 1e300;
+    hcpsilva::iloc_program program;
+};
+
+// the best of a few runs, each parsing the file anew
+auto time_threads(std::string const& path, std::size_t threads) -> timings
+{
+    timings result;
+
+    for (auto i = 0; i < repetitions; ++i) {
+        hcpsilva::driver driver(path);
+
+        driver.use_threads(threads);
+
+        auto begin = std::chrono::steady_clock::now();
+
+        if (driver.parse() != 0)
+            throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+
+        result.parse_seconds = std::min(result.parse_seconds, elapsed(begin));
+
+        begin = std::chrono::steady_clock::now();
+
+        auto program = driver.lower();
+
+        result.lower_seconds = std::min(result.lower_seconds, elapsed(begin));
+        result.program       = std::move(program);
+    }
+
+    return result;
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc < 2) {
+        fmt::print(stderr, "usage: function-threads THREADS [shape options]\n");
+        return 2;
+    }
+
+    auto const shape = hcpsilva::bench::parse_shape(argc, argv, 2);
+    auto const path  = (std::filesystem::temp_directory_path() / fmt::format("function-threads-{}.txt", getpid())).string();
+
+    auto most = static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10));
+
+    if (most == 0)
+        most = std::max(1u, std::thread::hardware_concurrency());
+
+    // powers of two, and the most asked for even if it's not one
+    std::vector<std::size_t> counts;
+
+    for (std::size_t threads = 1; threads < most; threads *= 2)
+        counts.push_back(threads);
+
+    counts.push_back(most);
+
+    try {
+        hcpsilva::bench::program_size size;
+
+        {
+            std::ofstream out(path);
+
+            size = hcpsilva::bench::generate(out, shape);
+        }
+
+        auto const single = time_threads(path, 1);
+
+        for (auto const threads : counts) {
+            auto const measured = threads == 1 ? single : time_threads(path, threads);
+
+            if (measured.program != single.program)
+                throw std::runtime_error(
+                    fmt::format("benchmark error, the code lowered over {} threads is not that over one\n", threads));
+
+            auto const speedup = (single.parse_seconds + single.lower_seconds)
+                / (measured.parse_seconds + measured.lower_seconds);
+
+            fmt::print("{{\"functions\": {}, \"commands\": {}, \"depth\": {}, \"dimensions\": {}, \"tokens\": {}, "
+                       "\"threads\": {}, \"parse_seconds\": {:.6f}, \"lower_seconds\": {:.6f}, \"speedup\": {:.3f}}}\n",
+                shape.functions, shape.commands, shape.depth, shape.dimensions, size.tokens, threads,
+                measured.parse_seconds, measured.lower_seconds, speedup);
+        }
+
+        std::filesystem::remove(path);
+    } catch (std::exception const& error) {
+        std::filesystem::remove(path);
+
+        fmt::print(stderr, "{}", error.what());
+        return 1;
+    }
+
+    return 0;
+}
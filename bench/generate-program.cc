@@ -0,0 +1,41 @@
+/** @file generate-program.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Writes the same programs the benchmarks run over to the standard output,
+ * taking the program shape options of generator.hh, so a slow case can be
+ * reproduced and profiled with the stage executables themselves.
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#include "generator.hh"
+
+auto main(int argc, char** argv) -> int
+{
+    try {
+        auto const size = hcpsilva::bench::generate(std::cout, hcpsilva::bench::parse_shape(argc, argv));
+
+        std::cout.flush();
+
+        fmt::print(stderr, "{} bytes, {} tokens\n", size.bytes, size.tokens);
+    } catch (std::runtime_error const& error) {
+        fmt::print(stderr, "{}", error.what());
+        return 1;
+    }
+
+    return 0;
+}
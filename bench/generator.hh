@@ -0,0 +1,320 @@
+/** @file generator.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Writes synthetic, syntactically valid programs of a configurable shape for
+ * the benchmarks: how many functions, how many commands in each, how deep the
+ * nested expression of each function goes and how many dimensions its global
+ * array (and so every index expression) has. The output only depends on the
+ * shape and the seed, so runs with the same arguments are comparable.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+namespace hcpsilva::bench {
+
+struct program_shape {
+    std::size_t   functions  = 1000;
+    std::size_t   commands   = 100;
+    std::size_t   depth      = 64;
+    std::size_t   dimensions = 3;
+    std::uint32_t seed       = 42;
+};
+
+/** @brief what was written, counted as it was written */
+struct program_size {
+    std::size_t bytes  = 0;
+    std::size_t tokens = 0;
+};
+
+/** @brief reads "--functions N", "--commands N", "--depth N", "--dimensions N"
+ * and "--seed N" from argv, starting at first. anything else is an error */
+inline auto parse_shape(int argc, char** argv, int first = 1) -> program_shape
+{
+    program_shape shape;
+
+    for (auto i = first; i < argc; i += 2) {
+        std::string_view const option = argv[i];
+
+        if (i + 1 == argc)
+            throw std::runtime_error(fmt::format("benchmark error, missing value for \"{}\"\n", option));
+
+        auto const value = std::strtoull(argv[i + 1], nullptr, 10);
+
+        if (option == "--functions")
+            shape.functions = value;
+        else if (option == "--commands")
+            shape.commands = value;
+        else if (option == "--depth")
+            shape.depth = value;
+        else if (option == "--dimensions")
+            shape.dimensions = value == 0 ? 1 : value;
+        else if (option == "--seed")
+            shape.seed = static_cast<std::uint32_t>(value);
+        else
+            throw std::runtime_error(fmt::format("benchmark error, unknown option \"{}\"\n", option));
+    }
+
+    return shape;
+}
+
+class generator {
+public:
+    generator(std::ostream& out, program_shape const& shape)
+        : out(out)
+        , shape(shape)
+        , random(shape.seed)
+    {
+    }
+
+    auto write() -> program_size
+    {
+        // the global array every index expression refers to
+        this->token("int");
+        this->token("matrix");
+        this->token("[");
+        for (std::size_t d = 0; d < this->shape.dimensions; ++d) {
+            if (d != 0)
+                this->token("^");
+            this->token("16");
+        }
+        this->token("]");
+        this->token(";");
+        this->line();
+
+        for (std::size_t f = 0; f < this->shape.functions; ++f)
+            this->function(f);
+
+        return this->size;
+    }
+
+private:
+    // identifiers are letters only, so numbers are spelled in base 26
+    static auto name(char const* prefix, std::size_t number) -> std::string
+    {
+        std::string result = prefix;
+
+        do {
+            result += static_cast<char>('a' + number % 26);
+            number /= 26;
+        } while (number != 0);
+
+        return result;
+    }
+
+    auto token(std::string_view text) -> void
+    {
+        this->out << text << ' ';
+        this->size.bytes += text.size() + 1;
+        ++this->size.tokens;
+    }
+
+    auto line() -> void
+    {
+        this->out << '\n';
+        ++this->size.bytes;
+    }
+
+    auto pick(std::size_t count) -> std::size_t { return this->random() % count; }
+
+    auto function(std::size_t number) -> void
+    {
+        this->token("int");
+        this->token(name("fn", number));
+        this->token("(");
+        this->token("int");
+        this->token("a");
+        this->token(",");
+        this->token("float");
+        this->token("b");
+        this->token(")");
+        this->token("{");
+        this->line();
+
+        this->token("int");
+        this->token("x");
+        this->token("<=");
+        this->token("0");
+        this->token(",");
+        this->token("y");
+        this->token("<=");
+        this->token("1");
+        this->token(";");
+        this->line();
+
+        for (std::size_t c = 0; c < this->shape.commands; ++c) {
+            this->command(number);
+            this->token(";");
+            this->line();
+        }
+
+        // one expression per function nested as deep as asked for
+        this->token("x");
+        this->token("=");
+        this->expression(this->shape.depth);
+        this->token(";");
+        this->line();
+
+        this->token("return");
+        this->token("x");
+        this->token(";");
+        this->line();
+
+        this->token("}");
+        this->line();
+    }
+
+    auto command(std::size_t function) -> void
+    {
+        switch (this->pick(8)) {
+        case 0:
+            this->index();
+            this->token("=");
+            this->expression(3);
+            break;
+        case 1:
+            this->token("if");
+            this->token("(");
+            this->expression(2);
+            this->token(")");
+            this->token("then");
+            this->token("{");
+            this->token("x");
+            this->token("=");
+            this->expression(2);
+            this->token(";");
+            this->token("}");
+            this->token("else");
+            this->token("{");
+            this->token("output");
+            this->token("x");
+            this->token(";");
+            this->token("}");
+            break;
+        case 2:
+            this->token("while");
+            this->token("(");
+            this->token("x");
+            this->token("<");
+            this->token("a");
+            this->token(")");
+            this->token("{");
+            this->token("x");
+            this->token("=");
+            this->token("x");
+            this->token("+");
+            this->token("1");
+            this->token(";");
+            this->token("}");
+            break;
+        case 3:
+            this->token("input");
+            this->token("y");
+            break;
+        case 4:
+            // calls go to functions already written
+            this->token(name("fn", this->pick(function + 1)));
+            this->token("(");
+            this->expression(2);
+            this->token(",");
+            this->expression(1);
+            this->token(")");
+            break;
+        default:
+            this->token(this->pick(2) ? "x" : "y");
+            this->token("=");
+            this->expression(4);
+            break;
+        }
+    }
+
+    auto index() -> void
+    {
+        this->token("matrix");
+        this->token("[");
+        for (std::size_t d = 0; d < this->shape.dimensions; ++d) {
+            if (d != 0)
+                this->token("^");
+            this->expression(1, false);
+        }
+        this->token("]");
+    }
+
+    auto leaf() -> void
+    {
+        // no chars, which mix with nothing else in an expression
+        static constexpr std::string_view literals[] = { "1", "42", "1.5e3", "0.25", "true", "false" };
+        static constexpr std::string_view variables[] = { "a", "b", "x", "y" };
+
+        switch (this->pick(4)) {
+        case 0:
+            this->token(literals[this->pick(std::size(literals))]);
+            break;
+        case 1:
+            this->token("-");
+            this->token(variables[this->pick(std::size(variables))]);
+            break;
+        default:
+            this->token(variables[this->pick(std::size(variables))]);
+            break;
+        }
+    }
+
+    // nests along a single spine, so the size grows linearly with the depth.
+    // indices don't nest other indices, or a program with many dimensions
+    // could grow without bound
+    auto expression(std::size_t depth, bool indexing = true) -> void
+    {
+        static constexpr std::string_view operators[] = { "+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=", "&&", "||" };
+
+        for (std::size_t level = 0; level < depth; ++level) {
+            if (indexing && this->pick(8) == 0)
+                this->index();
+            else
+                this->leaf();
+
+            this->token(operators[this->pick(std::size(operators))]);
+            this->token("(");
+        }
+
+        this->leaf();
+
+        for (std::size_t level = 0; level < depth; ++level)
+            this->token(")");
+    }
+
+    std::ostream&       out;
+    program_shape const shape;
+    std::mt19937        random;
+    program_size        size;
+};
+
+/** @brief writes a program of the given shape to out */
+inline auto generate(std::ostream& out, program_shape const& shape) -> program_size
+{
+    return generator(out, shape).write();
+}
+
+}
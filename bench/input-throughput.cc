@@ -0,0 +1,128 @@
+/** @file input-throughput.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Compares how fast the scanner gets through a large source when it's mapped
+ * into memory and scanned in place against reading it through an ifstream.
+ * Takes the size of the generated source in MiB as its only argument.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <fmt/core.h>
+
+#include "driver.hh"
+
+namespace {
+
+constexpr auto repetitions = 3;
+
+struct measure {
+    double      seconds;
+    std::size_t tokens;
+};
+
+auto scan_all(hcpsilva::driver& driver) -> measure
+{
+    std::size_t tokens = 0;
+
+    auto const begin = std::chrono::steady_clock::now();
+
+    while (driver.yylex().kind() != yy::parser::symbol_kind::S_YYEOF)
+        ++tokens;
+
+    auto const end = std::chrono::steady_clock::now();
+
+    return { std::chrono::duration<double>(end - begin).count(), tokens };
+}
+
+auto write_source(std::string const& path, std::size_t bytes) -> void
+{
+    std::ofstream out(path);
+
+    for (std::size_t written = 0, function = 0; written < bytes; ++function) {
+        auto const text = fmt::format(
+            "int function{:c}(int a, float b) {{\n"
+            "  // keep the scanner honest with some comments\n"
+            "  int counter <= 0, limit <= 1000;\n"
+            "  while (counter < limit) {{ counter = counter + a * 2 - (limit / 3); }};\n"
+            "  /* and a block comment spanning\n"
+            "     a couple of lines */\n"
+            "  if (b >= 1.5e3) then {{ output counter; }} else {{ return counter; }};\n"
+            "  return limit;\n"
+            "}}\n",
+            'a' + static_cast<char>(function % 26));
+
+        out << text;
+        written += text.size();
+    }
+}
+
+auto report(char const* name, measure best, std::size_t bytes) -> void
+{
+    fmt::print("{:<8} {:>10.4f} {:>12.1f} {:>14.0f}\n",
+        name, best.seconds, bytes / best.seconds / (1 << 20), best.tokens / best.seconds);
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    std::size_t const megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+
+    auto const path = (std::filesystem::temp_directory_path() / "input-throughput.txt").string();
+
+    write_source(path, megabytes << 20);
+
+    auto const bytes = std::filesystem::file_size(path);
+
+    measure mapped { 1e300, 0 }, stream { 1e300, 0 };
+
+    for (auto i = 0; i < repetitions; ++i) {
+        {
+            hcpsilva::driver driver(path);
+
+            auto result = scan_all(driver);
+
+            if (result.seconds < mapped.seconds)
+                mapped = result;
+        }
+
+        {
+            hcpsilva::driver driver;
+            std::ifstream    input(path);
+
+            driver.swap_input(input);
+
+            auto result = scan_all(driver);
+
+            if (result.seconds < stream.seconds)
+                stream = result;
+        }
+    }
+
+    std::filesystem::remove(path);
+
+    fmt::print("{:<8} {:>10} {:>12} {:>14}\n", "input", "seconds", "MiB/s", "tokens/s");
+
+    report("mmap", mapped, bytes);
+    report("ifstream", stream, bytes);
+
+    fmt::print("speedup  {:>10.2f}x\n", stream.seconds / mapped.seconds);
+
+    return mapped.tokens == stream.tokens ? 0 : 1;
+}
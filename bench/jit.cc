@@ -0,0 +1,150 @@
+/** @file jit.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Compiles and runs many tiny programs, each a loop calling a couple of
+ * functions and printing its result, as the test runs do. Each one is run in
+ * process (see jit.hh) and on the virtual machine (see vm.hh), from the same
+ * tree, so the latency of getting from a tree to what its main returns can be
+ * compared:
+ *
+ *     jit COUNT
+ *
+ * Prints a JSON object with the mean latency per program on each, split in
+ * compiling and running, and the bytes of machine code translated.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include "bytecode.hh"
+#include "driver.hh"
+#include "jit.hh"
+#include "vm.hh"
+
+namespace {
+
+auto source_of(unsigned number) -> std::string
+{
+    return fmt::format("int twice(int x) {{ return x + x; }}\n"
+                       "int step(int x, int y) {{ return twice(x) - y / 3; }}\n"
+                       "int main() {{\n"
+                       "  int i <= 0, sum <= {0};\n"
+                       "  while (i < {1}) {{ sum = sum + step(i, sum % 7); i = i + 1; }};\n"
+                       "  output sum;\n"
+                       "  return sum;\n"
+                       "}}\n",
+        number, 1 + number % 64);
+}
+
+auto seconds_since(std::chrono::steady_clock::time_point start) -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc != 2) {
+        fmt::print(stderr, "usage: jit COUNT\n");
+        return 1;
+    }
+
+    auto const count = static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10));
+    auto const path  = (std::filesystem::temp_directory_path() / fmt::format("jit-{}.txt", getpid())).string();
+
+    auto* const sink = std::fopen("/dev/null", "w");
+
+    double parse = 0, jit_compile = 0, jit_run = 0, vm_compile = 0, vm_run = 0;
+
+    std::size_t code_bytes = 0;
+
+    try {
+        if (sink == nullptr)
+            throw std::runtime_error("benchmark error, could not open /dev/null\n");
+
+        std::optional<hcpsilva::driver> driver;
+
+        for (unsigned i = 0; i < count; ++i) {
+            {
+                std::ofstream out(path);
+
+                out << source_of(i);
+            }
+
+            auto const parsing = std::chrono::steady_clock::now();
+
+            if (driver)
+                driver->swap_input(path);
+            else
+                driver.emplace(path);
+
+            if (driver->parse() != 0)
+                throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+
+            parse += seconds_since(parsing);
+
+            auto start = std::chrono::steady_clock::now();
+
+            hcpsilva::jit program(driver->lower());
+
+            jit_compile += seconds_since(start);
+            start = std::chrono::steady_clock::now();
+
+            auto const returned = program.run(sink, sink);
+
+            jit_run += seconds_since(start);
+            code_bytes += program.statistics().code_bytes;
+            start = std::chrono::steady_clock::now();
+
+            hcpsilva::virtual_machine machine(hcpsilva::compile_bytecode(driver->lower()));
+
+            vm_compile += seconds_since(start);
+            start = std::chrono::steady_clock::now();
+
+            if (machine.run("main", sink, sink) != returned)
+                throw std::runtime_error(fmt::format("benchmark error, program {} returns differently\n", i));
+
+            vm_run += seconds_since(start);
+        }
+
+        std::filesystem::remove(path);
+    } catch (std::exception const& error) {
+        std::filesystem::remove(path);
+
+        fmt::print(stderr, "{}", error.what());
+        return 1;
+    }
+
+    std::fclose(sink);
+
+    auto const mean = [count](double seconds) { return count == 0 ? 0 : seconds / count; };
+
+    fmt::print("{{\"programs\": {}, \"parse_seconds\": {:.9f}, \"jit_compile_seconds\": {:.9f}, "
+               "\"jit_run_seconds\": {:.9f}, \"vm_compile_seconds\": {:.9f}, \"vm_run_seconds\": {:.9f}, "
+               "\"jit_code_bytes\": {}}}\n",
+        count, mean(parse), mean(jit_compile), mean(jit_run), mean(vm_compile), mean(vm_run),
+        count == 0 ? 0 : code_bytes / count);
+
+    return 0;
+}
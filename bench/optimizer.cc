@@ -0,0 +1,128 @@
+/** @file optimizer.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Runs one of the programs of programs.hh on the virtual machine (see vm.hh)
+ * with its code through no passes, through each pass of optimizer.hh alone and
+ * through all of them, so what each one is worth can be told apart:
+ *
+ *     optimizer fib|sieve|matrix N
+ *
+ * Prints a JSON object per choice of passes, with the instructions of the code
+ * before and after them, what they did, and the best of a few runs.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include "bytecode.hh"
+#include "driver.hh"
+#include "optimizer.hh"
+#include "programs.hh"
+#include "vm.hh"
+
+namespace {
+
+constexpr auto repetitions = 3;
+
+// as parse_optimizer_passes takes them
+constexpr std::string_view choices[] = { "none", "sccp", "licm", "gvn", "dce", "all" };
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc != 3) {
+        fmt::print(stderr, "usage: optimizer fib|sieve|matrix N\n");
+        return 1;
+    }
+
+    std::string_view const program = argv[1];
+
+    auto const size = static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10));
+    auto const path = (std::filesystem::temp_directory_path() / fmt::format("optimizer-{}.txt", getpid())).string();
+
+    try {
+        {
+            std::ofstream out(path);
+
+            out << hcpsilva::bench::source_of(program, size);
+        }
+
+        hcpsilva::driver driver(path);
+
+        if (driver.parse() != 0)
+            throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+
+        std::filesystem::remove(path);
+
+        std::optional<std::int32_t> expected;
+
+        for (auto const name : choices) {
+            driver.optimize_code(*hcpsilva::parse_optimizer_passes(name));
+
+            auto const optimize = std::chrono::steady_clock::now();
+            auto       code     = driver.code();
+
+            std::chrono::duration<double> const optimize_time = std::chrono::steady_clock::now() - optimize;
+
+            auto const& counts = driver.code_statistics();
+
+            hcpsilva::virtual_machine machine(hcpsilva::compile_bytecode(std::move(code)));
+
+            auto best   = 1e300;
+            auto result = 0;
+
+            for (auto i = 0; i < repetitions; ++i) {
+                auto const begin = std::chrono::steady_clock::now();
+
+                result = machine.run();
+
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+            }
+
+            if (expected && *expected != result)
+                throw std::runtime_error(fmt::format("benchmark error, \"{}\" returns differently\n", name));
+
+            expected = result;
+
+            fmt::print("{{\"program\": \"{}\", \"size\": {}, \"passes\": \"{}\", \"before\": {}, \"after\": {}, "
+                       "\"constants\": {}, \"branches\": {}, \"unreachable\": {}, \"redundant\": {}, \"copies\": {}, "
+                       "\"hoisted\": {}, \"dead\": {}, \"result\": {}, \"optimize_seconds\": {:.6f}, "
+                       "\"run_seconds\": {:.6f}}}\n",
+                program, size, name, counts.before, counts.after, counts.constants, counts.branches,
+                counts.unreachable, counts.redundant, counts.copies, counts.hoisted, counts.dead, result,
+                optimize_time.count(), best);
+        }
+    } catch (std::exception const& error) {
+        std::filesystem::remove(path);
+
+        fmt::print(stderr, "{}", error.what());
+        return 1;
+    }
+
+    return 0;
+}
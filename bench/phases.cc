@@ -0,0 +1,215 @@
+/** @file phases.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Times each phase of the front end over a generated program, so regressions
+ * can be tracked between releases:
+ *
+ *  - scan: the token loop alone, as stage-1 does
+ *  - parse: the whole parse, as stage-2 does
+ *  - print: print_ast over the parsed tree, as stage-3 does
+ *
+ * The grammar builds the tree from within its actions, so building it is timed
+ * as part of parse, which also reports it in nodes per second along with the
+ * memory the nodes take.
+ *
+ * Takes the phase ("all" runs every one of them) followed by the program shape
+ * options of generator.hh, and prints one JSON object per line and phase. Each
+ * phase runs in a process of its own, so its peak RSS isn't polluted by the
+ * ones before it.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+#include "driver.hh"
+#include "generator.hh"
+
+namespace {
+
+constexpr auto repetitions = 3;
+
+constexpr std::string_view phase_names[] = { "scan", "parse", "print" };
+
+struct measure {
+    double      seconds = 1e300;
+    std::size_t nodes   = 0;
+    std::size_t bytes   = 0;
+};
+
+auto elapsed(std::chrono::steady_clock::time_point begin) -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+auto parse(hcpsilva::driver& driver, std::string const& path) -> void
+{
+    if (driver.parse() != 0)
+        throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+}
+
+auto run_once(std::string_view phase, std::string const& path) -> measure
+{
+    hcpsilva::driver driver(path);
+    measure          result;
+
+    if (phase == "scan") {
+        auto const begin = std::chrono::steady_clock::now();
+
+        while (driver.yylex().kind() != yy::parser::symbol_kind::S_YYEOF)
+            ;
+
+        result.seconds = elapsed(begin);
+    } else if (phase == "parse") {
+        auto const begin = std::chrono::steady_clock::now();
+
+        parse(driver, path);
+
+        result.seconds = elapsed(begin);
+    } else {
+        parse(driver, path);
+
+        // keep the tree out of the terminal, but not out of the measure
+        std::fflush(stdout);
+
+        auto const saved = dup(STDOUT_FILENO);
+        auto const sink  = open("/dev/null", O_WRONLY);
+
+        dup2(sink, STDOUT_FILENO);
+        close(sink);
+
+        auto const begin = std::chrono::steady_clock::now();
+
+        driver.print_ast();
+        std::fflush(stdout);
+
+        result.seconds = elapsed(begin);
+
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+
+    result.nodes = driver.node_count();
+    result.bytes = driver.node_bytes();
+
+    return result;
+}
+
+auto peak_rss_kib() -> long
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+auto run_phase(std::string_view phase, std::string const& path, hcpsilva::bench::program_shape const& shape,
+    hcpsilva::bench::program_size const& size) -> void
+{
+    measure best;
+
+    for (auto i = 0; i < repetitions; ++i) {
+        auto const result = run_once(phase, path);
+
+        if (result.seconds < best.seconds)
+            best = result;
+    }
+
+    fmt::print("{{\"phase\": \"{}\", \"functions\": {}, \"commands\": {}, \"depth\": {}, \"dimensions\": {}, "
+               "\"bytes\": {}, \"tokens\": {}, \"nodes\": {}, \"node_bytes\": {}, \"wall_seconds\": {:.6f}, "
+               "\"tokens_per_second\": {:.0f}, \"nodes_per_second\": {:.0f}, \"peak_rss_kib\": {}}}\n",
+        phase, shape.functions, shape.commands, shape.depth, shape.dimensions,
+        size.bytes, size.tokens, best.nodes, best.bytes, best.seconds,
+        size.tokens / best.seconds, best.nodes / best.seconds, peak_rss_kib());
+}
+
+// runs the phase in a child process, which is where its peak RSS is taken
+auto spawn_phase(std::function<void()> const& phase) -> bool
+{
+    std::fflush(stdout);
+
+    auto const child = fork();
+
+    if (child < 0)
+        return false;
+
+    if (child == 0) {
+        auto code = 0;
+
+        try {
+            phase();
+        } catch (std::exception const& error) {
+            fmt::print(stderr, "{}", error.what());
+            code = 1;
+        }
+
+        std::fflush(stdout);
+        _exit(code);
+    }
+
+    int status = 0;
+
+    waitpid(child, &status, 0);
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    std::string_view const phase = argc > 1 ? argv[1] : "all";
+
+    if (phase != "all" && std::ranges::find(phase_names, phase) == std::end(phase_names)) {
+        fmt::print(stderr, "benchmark error, unknown phase \"{}\"\n", phase);
+        return 1;
+    }
+
+    auto const shape = hcpsilva::bench::parse_shape(argc, argv, 2);
+    auto const path  = (std::filesystem::temp_directory_path() / fmt::format("phases-{}.txt", getpid())).string();
+
+    hcpsilva::bench::program_size size;
+
+    {
+        std::ofstream out(path);
+
+        size = hcpsilva::bench::generate(out, shape);
+    }
+
+    auto success = true;
+
+    for (auto const name : phase_names) {
+        if (phase != "all" && phase != name)
+            continue;
+
+        success = spawn_phase([&] { run_phase(name, path, shape, size); }) && success;
+    }
+
+    std::filesystem::remove(path);
+
+    return success ? 0 : 1;
+}
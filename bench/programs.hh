@@ -0,0 +1,91 @@
+/** @file programs.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Programs heavy on calls or on loops, which the benchmarks of running code
+ * share:
+ *
+ *  - fib N: the naive recursive fibonacci of N
+ *  - sieve N: the primes up to N, sieved in a global array
+ *  - matrix N: the product of two N by N matrices, in two dimensional arrays
+ */
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+
+namespace hcpsilva::bench {
+
+inline auto source_of(std::string_view program, unsigned size) -> std::string
+{
+    if (program == "fib")
+        return fmt::format("int fib(int n) {{\n"
+                           "  if (n < 2) then {{ return n; }};\n"
+                           "  return fib(n - 1) + fib(n - 2);\n"
+                           "}}\n"
+                           "int main() {{\n"
+                           "  return fib({});\n"
+                           "}}\n",
+            size);
+
+    if (program == "sieve")
+        return fmt::format("int composite[{0}];\n"
+                           "int main() {{\n"
+                           "  int i <= 2, j, count <= 0;\n"
+                           "  while (i < {0}) {{\n"
+                           "    if (composite[i] == 0) then {{\n"
+                           "      count = count + 1;\n"
+                           "      j = i + i;\n"
+                           "      while (j < {0}) {{ composite[j] = 1; j = j + i; }};\n"
+                           "    }};\n"
+                           "    i = i + 1;\n"
+                           "  }};\n"
+                           "  return count;\n"
+                           "}}\n",
+            size);
+
+    if (program == "matrix")
+        return fmt::format("int a[{0}^{0}];\n"
+                           "int b[{0}^{0}];\n"
+                           "int c[{0}^{0}];\n"
+                           "int main() {{\n"
+                           "  int i <= 0, j, k, sum;\n"
+                           "  while (i < {0}) {{\n"
+                           "    j = 0;\n"
+                           "    while (j < {0}) {{ a[i^j] = i + j; b[i^j] = i - j; j = j + 1; }};\n"
+                           "    i = i + 1;\n"
+                           "  }};\n"
+                           "  i = 0;\n"
+                           "  while (i < {0}) {{\n"
+                           "    j = 0;\n"
+                           "    while (j < {0}) {{\n"
+                           "      sum = 0;\n"
+                           "      k = 0;\n"
+                           "      while (k < {0}) {{ sum = sum + a[i^k] * b[k^j]; k = k + 1; }};\n"
+                           "      c[i^j] = sum;\n"
+                           "      j = j + 1;\n"
+                           "    }};\n"
+                           "    i = i + 1;\n"
+                           "  }};\n"
+                           "  return c[{1}^{1}];\n"
+                           "}}\n",
+            size, size / 2);
+
+    throw std::runtime_error(fmt::format("benchmark error, unknown program \"{}\"\n", program));
+}
+
+}
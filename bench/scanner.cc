@@ -0,0 +1,252 @@
+/** @file scanner.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The flex scanner against the hand written one of simd_scanner.hh. Both must
+ * give the very same tokens, values, locations and errors, first over a set
+ * of sources made to hit the corners of scanner.ll (comments, carriage
+ * returns, bad sequences, runs longer than a vector) and then over a generated
+ * program, before their token loops are timed over that program. Takes the
+ * program shape options of generator.hh, and prints one JSON object per line
+ * and scanner.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+#include "driver.hh"
+#include "generator.hh"
+
+namespace {
+
+constexpr auto repetitions = 5;
+
+using kind = yy::parser::symbol_kind;
+
+// sources whose tokens the scanners could tell apart, if they ever differ.
+// each ends at its first error, so errors get a source of their own
+std::string const corners[] = {
+    "int a; // a comment\r\n  b /* a block * ** comment */ c",
+    "/*\r\r  */ a /*\rtext*/ b /*\r \t\r*/ c",
+    "/**/ d /***/ e /* * / **x/ */ f /*\n\n\n \t*/ g",
+    "a /* never closed",
+    "a // never broken",
+    "a\n\n\t b\r\n  c \r\r\n\n  \t\n d",
+    "1.5e10 2.25E-3 7.5e 3.5e+ 0042 1.25abc",
+    "12abc",
+    "abc12",
+    "3.",
+    "'a' '' ' ' 'b'",
+    "'\n'",
+    "<= >= == != && || < > = ! + - * / % ^ , ; ( ) { } [ ]",
+    "a & b",
+    "a | b",
+    "@",
+    "iff if ifx then else whilex while input output return true false int float bool char intx",
+    std::string(100, 'x') + " " + std::string(80, '7') + std::string(70, ' ') + "\n\n" + std::string(40, '\t') + "z",
+    "/*" + std::string(100, 'c') + std::string(50, ' ') + std::string(30, '*') + "*/ a",
+    "// " + std::string(200, '/') + "\n" + std::string(33, '\n') + "b",
+    std::string(64, 'q') + std::string(3, '5'),
+};
+
+struct token {
+    yy::parser::symbol_kind_type type;
+    std::string                  value;
+    yy::location                 where;
+};
+
+auto operator==(token const& lhs, token const& rhs) -> bool
+{
+    return lhs.type == rhs.type && lhs.value == rhs.value && lhs.where.begin == rhs.where.begin
+        && lhs.where.end == rhs.where.end;
+}
+
+auto describe(yy::parser::symbol_type const& symbol, hcpsilva::driver const& driver) -> std::string
+{
+    switch (symbol.kind()) {
+    case kind::S_INTEGER:
+        return fmt::format("{}", symbol.value.as<int>());
+    case kind::S_FLOATING_POINT:
+        return fmt::format("{}", symbol.value.as<double>());
+    case kind::S_TRUE:
+    case kind::S_FALSE:
+        return fmt::format("{}", symbol.value.as<bool>());
+    case kind::S_CHARACTER:
+        return fmt::format("{}", static_cast<int>(symbol.value.as<char>()));
+    case kind::S_IDENTIFIER:
+        return std::string(driver.name(symbol.value.as<hcpsilva::identifier>()));
+    case kind::S_INT:
+    case kind::S_FLOAT:
+    case kind::S_BOOL:
+    case kind::S_CHAR:
+        return fmt::format("{}", static_cast<int>(symbol.value.as<hcpsilva::types>()));
+    case kind::S_IF:
+    case kind::S_WHILE:
+    case kind::S_INPUT:
+    case kind::S_OUTPUT:
+    case kind::S_RETURN:
+        return fmt::format("{}", static_cast<int>(symbol.value.as<hcpsilva::keywords>()));
+    case kind::S_PLUS:
+    case kind::S_MINUS:
+    case kind::S_STAR:
+    case kind::S_SLASH:
+    case kind::S_PERCENT:
+    case kind::S_BANG:
+    case kind::S_CARET:
+    case kind::S_LESS_THAN:
+    case kind::S_GREATER_THAN:
+    case kind::S_EQUAL:
+    case kind::S_OC_LESS_EQUAL:
+    case kind::S_OC_GREATER_EQUAL:
+    case kind::S_OC_EQUAL:
+    case kind::S_OC_NOT_EQUAL:
+    case kind::S_OC_AND:
+    case kind::S_OC_OR:
+        return fmt::format("{}", static_cast<int>(symbol.value.as<hcpsilva::operations>()));
+    default:
+        return "";
+    }
+}
+
+// every token of the file, up to the end or to the first error, which is
+// taken down as a token of kind YYerror
+auto tokens_of(std::string const& path, hcpsilva::scanner_kind scanner) -> std::vector<token>
+{
+    hcpsilva::driver driver(path);
+
+    driver.use_scanner(scanner);
+
+    std::vector<token> tokens;
+
+    try {
+        for (;;) {
+            auto const symbol = driver.yylex();
+
+            tokens.push_back({ symbol.kind(), describe(symbol, driver), symbol.location });
+
+            if (symbol.kind() == kind::S_YYEOF)
+                break;
+        }
+    } catch (yy::parser::syntax_error const& error) {
+        tokens.push_back({ kind::S_YYerror, error.what(), error.location });
+    }
+
+    return tokens;
+}
+
+auto show(token const& token) -> std::string
+{
+    return fmt::format("{} \"{}\" at bytes {}-{} of input {}", static_cast<int>(token.type), token.value,
+        token.where.begin, token.where.end, token.where.file);
+}
+
+auto compare(std::string const& path, std::string_view what) -> std::size_t
+{
+    auto const flex = tokens_of(path, hcpsilva::scanner_kind::FLEX);
+    auto const simd = tokens_of(path, hcpsilva::scanner_kind::SIMD);
+
+    for (std::size_t i = 0; i < flex.size() || i < simd.size(); ++i) {
+        if (i < flex.size() && i < simd.size() && flex[i] == simd[i])
+            continue;
+
+        throw std::runtime_error(fmt::format("benchmark error, the scanners differ on token {} of {}: {} against {}\n", i,
+            what, i < flex.size() ? show(flex[i]) : "nothing", i < simd.size() ? show(simd[i]) : "nothing"));
+    }
+
+    return flex.size();
+}
+
+auto elapsed(std::chrono::steady_clock::time_point begin) -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// the best of a few runs of the token loop, as the scan phase of phases.cc
+auto time_scan(std::string const& path, hcpsilva::scanner_kind scanner) -> double
+{
+    auto best = 1e300;
+
+    for (auto i = 0; i < repetitions; ++i) {
+        hcpsilva::driver driver(path);
+
+        driver.use_scanner(scanner);
+
+        auto const begin = std::chrono::steady_clock::now();
+
+        while (driver.yylex().kind() != kind::S_YYEOF)
+            ;
+
+        best = std::min(best, elapsed(begin));
+    }
+
+    return best;
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    auto const shape = hcpsilva::bench::parse_shape(argc, argv, 1);
+    auto const path  = (std::filesystem::temp_directory_path() / fmt::format("scanner-{}.txt", getpid())).string();
+
+    auto success = true;
+
+    try {
+        for (std::size_t i = 0; i < std::size(corners); ++i) {
+            std::ofstream(path) << corners[i];
+
+            compare(path, fmt::format("corner case {}", i));
+        }
+
+        hcpsilva::bench::program_size size;
+
+        {
+            std::ofstream out(path);
+
+            size = hcpsilva::bench::generate(out, shape);
+        }
+
+        auto const tokens = compare(path, "the generated program");
+
+        auto const flex = time_scan(path, hcpsilva::scanner_kind::FLEX);
+        auto const simd = time_scan(path, hcpsilva::scanner_kind::SIMD);
+
+        for (auto const& [name, seconds] : { std::pair { "flex", flex }, std::pair { "simd", simd } }) {
+            fmt::print("{{\"scanner\": \"{}\", \"functions\": {}, \"commands\": {}, \"depth\": {}, \"dimensions\": {}, "
+                       "\"bytes\": {}, \"tokens\": {}, \"wall_seconds\": {:.6f}, \"tokens_per_second\": {:.0f}, "
+                       "\"bytes_per_second\": {:.0f}, \"speedup\": {:.2f}}}\n",
+                name, shape.functions, shape.commands, shape.depth, shape.dimensions, size.bytes, tokens, seconds,
+                tokens / seconds, size.bytes / seconds, flex / seconds);
+        }
+    } catch (std::exception const& error) {
+        fmt::print(stderr, "{}", error.what());
+
+        success = false;
+    }
+
+    std::filesystem::remove(path);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+/** @file vm.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Runs programs heavy on calls or on loops on the virtual machine (see vm.hh),
+ * so the cost of dispatching instructions can be tracked. The programs are
+ * those of programs.hh:
+ *
+ *     vm fib|sieve|matrix N
+ *
+ * Prints a JSON object with the size of the bytecode, what main returned and
+ * the best of a few runs.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include "bytecode.hh"
+#include "driver.hh"
+#include "programs.hh"
+#include "vm.hh"
+
+namespace {
+
+constexpr auto repetitions = 5;
+
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc != 3) {
+        fmt::print(stderr, "usage: vm fib|sieve|matrix N\n");
+        return 1;
+    }
+
+    std::string_view const program = argv[1];
+
+    auto const size = static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10));
+    auto const path = (std::filesystem::temp_directory_path() / fmt::format("vm-{}.txt", getpid())).string();
+
+    try {
+        {
+            std::ofstream out(path);
+
+            out << hcpsilva::bench::source_of(program, size);
+        }
+
+        hcpsilva::driver driver(path);
+
+        if (driver.parse() != 0)
+            throw std::runtime_error(fmt::format("benchmark error, could not parse \"{}\"\n", path));
+
+        std::filesystem::remove(path);
+
+        auto const compile  = std::chrono::steady_clock::now();
+        auto       bytecode = hcpsilva::compile_bytecode(driver.lower());
+        auto const words    = bytecode.code.size();
+
+        std::chrono::duration<double> const compile_time = std::chrono::steady_clock::now() - compile;
+
+        hcpsilva::virtual_machine machine(std::move(bytecode));
+
+        auto best   = 1e300;
+        auto result = 0;
+
+        for (auto i = 0; i < repetitions; ++i) {
+            auto const begin = std::chrono::steady_clock::now();
+
+            result = machine.run();
+
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+        }
+
+        fmt::print("{{\"program\": \"{}\", \"size\": {}, \"words\": {}, \"result\": {}, \"compile_seconds\": {:.6f}, "
+                   "\"run_seconds\": {:.6f}}}\n",
+            program, size, words, result, compile_time.count(), best);
+    } catch (std::exception const& error) {
+        std::filesystem::remove(path);
+
+        fmt::print(stderr, "{}", error.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/** @file arena.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * A bump allocator that hands out memory from large contiguous chunks. Nothing
+ * allocated from it is freed individually: everything goes away at once when
+ * the arena itself is destroyed, or everything since a mark when rewound to it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace hcpsilva {
+
+class arena {
+public:
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    explicit arena(std::size_t chunk_size = default_chunk_size) noexcept
+        : chunk_size(chunk_size)
+    {
+    }
+
+    arena(arena const&) = delete;
+
+    auto operator=(arena const&) -> arena& = delete;
+
+    ~arena();
+
+    auto allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) -> void*
+    {
+        auto const address = reinterpret_cast<std::uintptr_t>(this->cursor);
+        auto const aligned = (address + alignment - 1) & ~(alignment - 1);
+
+        if (this->cursor == nullptr || aligned + size > reinterpret_cast<std::uintptr_t>(this->limit))
+            return this->grow(size, alignment);
+
+        this->cursor = reinterpret_cast<std::byte*>(aligned + size);
+        this->used += size;
+
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    template <typename T, typename... Args>
+    auto make(Args&&... arguments) -> T*
+    {
+        auto object = ::new (this->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(arguments)...);
+
+        // trivially destructible objects (the common case) cost nothing else,
+        // the rest get their destructor called when the arena goes away
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            this->register_finalizer(object, [](void* pointer) { std::destroy_at(static_cast<T*>(pointer)); });
+
+        return object;
+    }
+
+    /** @brief destroys every object and makes the memory available again. the
+     * last chunk is kept around, so an arena reused for inputs of similar size
+     * stops asking the system for memory */
+    auto reset() -> void;
+
+    /** @brief where the arena stands, to be rewound to later */
+    struct marker {
+        void*       chunk;
+        std::byte*  cursor;
+        void*       finalizers;
+        void*       oversized;
+        std::size_t used;
+    };
+
+    auto mark() const noexcept -> marker
+    {
+        return { this->chunks, this->cursor, this->finalizers, this->oversized, this->used };
+    }
+
+    /** @brief destroys every object made since mark was taken and makes their
+     * memory available again, as in a stack. marks taken after it are lost */
+    auto rewind(marker const& mark) -> void;
+
+    /** @brief bytes handed out to callers so far */
+    auto bytes_used() const noexcept -> std::size_t { return this->used; }
+
+    /** @brief bytes requested from the system so far */
+    auto bytes_reserved() const noexcept -> std::size_t { return this->reserved; }
+
+private:
+    struct chunk {
+        chunk*      previous;
+        std::size_t size;
+    };
+
+    struct finalizer {
+        void (*destroy)(void*);
+        void*      object;
+        finalizer* previous;
+    };
+
+    auto grow(std::size_t size, std::size_t alignment) -> void*;
+
+    /** @brief a chunk of its own for a request larger than a chunk, kept off
+     * to the side so the current one is still bumped through afterwards */
+    auto allocate_oversized(std::size_t size, std::size_t alignment) -> void*;
+
+    static auto release(chunk* chunks) -> void;
+
+    auto register_finalizer(void* object, void (*destroy)(void*)) -> void;
+
+    auto finalize() -> void;
+
+    std::byte*  cursor     = nullptr;
+    std::byte*  limit      = nullptr;
+    chunk*      chunks     = nullptr;
+    chunk*      oversized  = nullptr;
+    finalizer*  finalizers = nullptr;
+    std::size_t chunk_size;
+    std::size_t used     = 0;
+    std::size_t reserved = 0;
+};
+
+}
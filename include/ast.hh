@@ -19,29 +19,37 @@
 
 namespace hcpsilva {
 
+/** @brief what each node of the tree holds: the value that originated it,
+ * where in the source it was found and, for expressions, the type of what
+ * they compute (see type_checker.hh) */
 struct ast_value {
     lexic_value  value;
     yy::location location;
+    types        type = types::INT;
 };
 
-using ast_node = tree_node<lexic_value>;
+using ast_node = tree_node<ast_value>;
 
-}
+using ast_chain = tree_chain<ast_value>;
+
+/** @brief the blocks of an if, either of them nullptr if empty */
+struct if_branches {
+    ast_node* then_block = nullptr;
+    ast_node* else_block = nullptr;
+};
+
+/** @brief the blocks hanging from an if node, after its condition. an empty
+ * block isn't in the tree, so a single one is told apart by whether it's
+ * within the if, which spans up to the end of its then */
+auto branches_of(ast_node const& node) -> if_branches;
 
-namespace fmt {
+}
 
 template <>
-struct formatter<hcpsilva::ast_value> {
-    template <typename ParseContext>
-    constexpr auto parse(ParseContext& ctx)
+struct fmt::formatter<hcpsilva::ast_value> : formatter<hcpsilva::lexic_value> {
+    template <typename FormatContext>
+    auto format(hcpsilva::ast_value const& value, FormatContext& ctx) const -> decltype(ctx.out())
     {
-        return ctx.begin();
+        return formatter<hcpsilva::lexic_value>::format(value.value, ctx);
     }
 };
-
-template <typename FormatContext>
-auto format(hcpsilva::ast_value const& value, FormatContext& ctx)
-{
-    return format_to(ctx.begin(), "{}", &value, value.value);
-}
-}
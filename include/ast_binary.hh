@@ -0,0 +1,70 @@
+/** @file ast_binary.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * A binary image of a tree, so it can be parsed once and loaded by any number
+ * of later tools. The file has, in order and in the byte order of the machine
+ * that wrote it:
+ *
+ *  - a header, with a magic string, the format version and where the rest is
+ *  - a table of names, an offset and length into the text for each
+ *  - the text: every name, followed by the name of the source file
+ *  - one fixed size record per node, in the order they are reached depth
+ *    first, linked to each other by their indices
+ *
+ * Loading maps the file and builds every node in a single block taken from an
+ * arena, with names interned into a string pool as it goes.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "arena.hh"
+#include "ast.hh"
+#include "source_buffer.hh"
+#include "string_pool.hh"
+
+namespace hcpsilva {
+
+/** @brief writes the tree rooted at root (and the chain after it) to path */
+auto save_ast(std::string const& path, ast_node const* root, string_pool const& strings, std::string_view source_name)
+    -> void;
+
+/** @brief a mapped tree file, already checked to be complete and well formed */
+class ast_file {
+public:
+    // 2: an if spans up to the end of its then block
+    // 3: locations are byte offsets alone
+    // 4: nodes carry their type, and conversions are nodes of their own
+    static constexpr std::uint32_t version = 4;
+
+    static auto open(std::string const& path) -> ast_file;
+
+    auto source_name() const -> std::string_view;
+
+    auto node_count() const -> std::size_t { return this->nodes; }
+
+    /** @brief builds the tree out of storage, interning its names in strings.
+     * the locations of its nodes are taken to be in the given file */
+    auto load(arena& storage, string_pool& strings, yy::location::file_type file) const -> ast_node*;
+
+private:
+    source_buffer contents;
+    std::size_t   nodes = 0;
+};
+
+}
@@ -0,0 +1,66 @@
+/** @file ast_emitter.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Writes out a tree in a single walk. Nodes are numbered in the order they are
+ * reached (depth first, children before the next node in the chain), so the
+ * same tree always comes out the same, byte for byte. The formats are:
+ *
+ *  - legacy: the one expected of stage 3, every node with its label followed
+ *    by every edge, as in `3 [label="+"]` and `2, 3`
+ *  - dot: a Graphviz digraph
+ *  - edges: a compact listing, `id<TAB>label` per node, an empty line and
+ *    `from<TAB>to` per edge
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <optional>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "ast.hh"
+#include "string_pool.hh"
+
+namespace hcpsilva {
+
+enum class ast_format {
+    LEGACY,
+    DOT,
+    EDGES
+};
+
+/** @brief the format with the given name, as listed above */
+auto parse_ast_format(std::string_view name) -> std::optional<ast_format>;
+
+class ast_emitter {
+public:
+    ast_emitter(string_pool const& strings, ast_format format = ast_format::LEGACY)
+        : strings(strings)
+        , format(format)
+    {
+    }
+
+    /** @brief writes the tree rooted at root, and the chain that follows it */
+    auto emit(ast_node const* root, std::FILE* out) -> void;
+
+private:
+    auto label(lexic_value const& value, fmt::memory_buffer& buffer) const -> void;
+
+    string_pool const& strings;
+    ast_format         format;
+};
+
+}
@@ -0,0 +1,81 @@
+/** @file ast_folder.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The first optimization over the tree (stage E7), done in place in a single
+ * bottom up walk:
+ *
+ *  - operations over literals alone are replaced by their result, following C:
+ *    chars and bools are taken as ints, and anything with a float is a float.
+ *    a division (or rest) by zero is left to happen, with a warning
+ *  - conversions of literals between ints and floats are replaced by the
+ *    value converted, as it would be at run time
+ *  - identities are dropped: x * 1, x / 1, x + 0, x - 0 (ints or floats alike),
+ *    and double negations, logical and and or with a constant side where the
+ *    result stays the same
+ *  - if and while with a constant condition are replaced by the branch taken,
+ *    or removed altogether
+ *
+ * Nothing that could have a side effect (i.e. a call) is ever thrown away.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ast.hh"
+#include "location.hh"
+
+namespace hcpsilva {
+
+struct fold_warning {
+    yy::location location;
+    std::string  message;
+};
+
+struct fold_statistics {
+    std::size_t folded     = 0; // operations replaced by their result
+    std::size_t simplified = 0; // identities dropped
+    std::size_t pruned     = 0; // ifs and whiles replaced or removed
+    std::size_t removed    = 0; // nodes no longer in the tree
+};
+
+class ast_folder {
+public:
+    /** @brief folds the tree under root (and the chain after it) in place.
+     * the root itself is never removed */
+    auto fold(ast_node* root) -> void;
+
+    auto statistics() const -> fold_statistics const& { return this->counts; }
+
+    auto warnings() const -> std::vector<fold_warning> const& { return this->found; }
+
+private:
+    auto fold_operation(ast_node& node) -> void;
+    auto fold_conversion(ast_node& node) -> void;
+    auto prune_if(ast_node& node) -> void;
+    auto prune_while(ast_node& node) -> void;
+
+    /** @brief node takes the place of what remains of it: replacement's value
+     * and children, or nothing at all if there's no replacement */
+    auto replace(ast_node& node, ast_node* replacement) -> void;
+
+    auto remove_empty(ast_node* root) -> void;
+
+    fold_statistics           counts;
+    std::vector<fold_warning> found;
+};
+
+}
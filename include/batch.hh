@@ -0,0 +1,73 @@
+/** @file batch.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Compiles many files within a single process, spread over a thread pool with
+ * a driver per worker. What each compilation writes is kept apart, so it can
+ * be shown in the order the files were given no matter which finished first.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ast_emitter.hh"
+#include "ast_folder.hh"
+#include "instrumentation.hh"
+#include "optimizer.hh"
+#include "parse_cache.hh"
+#include "simd_scanner.hh"
+
+namespace hcpsilva {
+
+struct compilation {
+    std::string file_name;
+    std::string output; // what the driver printed
+    std::string errors; // and what it complained about
+    int         status = 0;
+
+    fold_statistics folded; // what optimizing took out of the tree
+
+    optimizer_statistics optimized; // what the passes did to the code, when run
+
+    // when run: what main returned, and how long getting there and running took
+    std::int32_t returned        = 0;
+    double       compile_seconds = 0;
+    double       run_seconds     = 0;
+
+    compile_report report; // where the time went, when measured
+};
+
+struct batch_options {
+    std::size_t  threads  = 0; // 0 for one per hardware thread
+    ast_format   format   = ast_format::LEGACY;
+    bool         save_ast = false; // writes the tree of each file to <file>.ast
+    bool         optimize = false; // folds the tree after saving it, see ast_folder.hh
+    parse_cache* cache    = nullptr; // where functions are looked up, if anywhere and not run
+    bool         run      = false; // runs each program on the jit instead of printing its tree
+
+    optimizer_passes passes           = optimizer_passes::none(); // over the code of the programs run
+    bool             measure          = false; // fills the report of each compilation in
+    scanner_kind     scanner          = default_scanner;
+    std::size_t      function_threads = 1; // typing and lowering the functions of each file, 0 as above
+};
+
+/** @brief compiles each file, where files ending in .ast are loaded instead of
+ * parsed. the results are in the same order as the files. programs run read
+ * their input from <file>.in, if there is one, and nothing otherwise */
+auto compile_batch(std::vector<std::string> const& files, batch_options const& options = {}) -> std::vector<compilation>;
+
+}
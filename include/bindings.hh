@@ -0,0 +1,78 @@
+/** @file bindings.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * What the names in the tree stand for. The tree keeps the names alone, and
+ * declarations without an initial value leave nothing in it at all, so the
+ * variables each name refers to are taken down while parsing, with the scopes
+ * still around:
+ *
+ *  - every global, numbered in the order they were declared, with where it is
+ *    among the others and its dimensions (if an array)
+ *  - every function, in the same order as in the tree, with how many of its
+ *    variables are parameters (those come first) and the type of each
+ *  - every variable found in a function, by where in the source its name is,
+ *    which stays put however the tree around it changes
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lexic_values.hh"
+
+namespace hcpsilva {
+
+struct global_variable {
+    identifier                 name;
+    types                      type;
+    std::uint32_t              offset; // in words, from the start of the globals
+    std::vector<std::uint32_t> dimensions; // empty for anything but arrays
+};
+
+struct function_info {
+    identifier         name;
+    types              type;
+    std::uint32_t      parameters = 0;
+    std::vector<types> variables  = {}; // the parameters included
+};
+
+struct variable_ref {
+    bool          global = false;
+    std::uint32_t number = 0; // among the globals, or the variables of its function
+};
+
+struct binding {
+    std::size_t  offset; // of the name, in the source
+    variable_ref variable;
+};
+
+struct program_bindings {
+    std::vector<global_variable> globals;
+    std::uint32_t                global_words = 0;
+    std::vector<function_info>   functions;
+    std::vector<binding>         uses;
+
+    // whether all of the tree was parsed as a whole, as nothing is taken down
+    // for trees loaded from a file or a cache
+    bool complete = true;
+
+    auto clear() -> void
+    {
+        *this = program_bindings {};
+    }
+};
+
+}
@@ -0,0 +1,116 @@
+/** @file bytecode.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The code run by the virtual machine (see vm.hh): the code of iloc.hh packed
+ * into a single array of words, each instruction an opcode followed by its
+ * operands and nothing else. Labels are gone, the jumps going straight to where
+ * they were, and so are the uses of rbss, which is where the memory of the
+ * program starts: the globals are addressed from 0 on.
+ *
+ * Registers are numbered from the start of the frame of their function, which
+ * holds as many of them as the function uses, the parameters first.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "iloc.hh"
+
+namespace hcpsilva {
+
+/** @brief each instruction, with its operands (registers r, constants c,
+ * addresses in the code @) in order */
+enum class bytecode_op : std::int32_t {
+    // r1 r2 r3, for r3 = r1 op r2
+    ADD,
+    SUB,
+    MULT,
+    DIV,
+    MOD,
+    CMP_LT,
+    CMP_LE,
+    CMP_EQ,
+    CMP_GE,
+    CMP_GT,
+    CMP_NE,
+    FADD,
+    FSUB,
+    FMULT,
+    FDIV,
+    FCMP_LT,
+    FCMP_LE,
+    FCMP_EQ,
+    FCMP_GE,
+    FCMP_GT,
+    FCMP_NE,
+
+    // r1 c2 r3
+    ADDI,
+    MULTI,
+    RSUBI,
+
+    // c1 r3 (floats loaded as their bits), and r1 r3
+    LOADI,
+    MOVE,
+    I2F,
+    F2I,
+
+    // c1 r3 and r1 r3, for r3 = memory[c1] or memory[r1]
+    LOAD,
+    LOADX,
+
+    // r1 c2 and r1 r2, for memory[c2] or memory[r2] = r1
+    STORE,
+    STOREX,
+
+    // @1 and r1 @2 @3
+    JUMP,
+    BRANCH,
+
+    // function, the result register, how many arguments and their registers
+    CALL,
+
+    // r1
+    RET,
+    INPUT,
+    OUTPUT,
+    FINPUT,
+    FOUTPUT,
+};
+
+struct bytecode_function {
+    std::string   name;
+    std::uint32_t parameters = 0;
+    std::uint32_t registers  = 0;
+    std::uint32_t entry      = 0; // where its code starts
+};
+
+struct bytecode_program {
+    std::uint32_t                  memory = 0; // in words
+    std::vector<bytecode_function> functions;
+    std::vector<std::int32_t>      code;
+};
+
+/** @brief how many words an instruction takes, given the words of the code
+ * from its opcode on */
+auto instruction_size(std::int32_t const* code) -> std::size_t;
+
+/** @brief packs program into bytecode, complaining (with std::runtime_error)
+ * about memory addressed from anything but rbss */
+auto compile_bytecode(iloc_program const& program) -> bytecode_program;
+
+}
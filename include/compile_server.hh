@@ -0,0 +1,135 @@
+/** @file compile_server.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * A compiler that stays up, answering over a Unix domain socket, so the cost
+ * of starting a process is paid once instead of at every file. Each file asked
+ * about is parsed once and kept (its driver, and so its tree and symbols) for
+ * as long as its modification time, size and inode stay the same, the least
+ * recently used files being dropped past a given count.
+ *
+ * Each connection carries a single request, a line naming what is wanted and
+ * the absolute path of the file, the path going last so it may hold spaces:
+ *
+ *  - "parse PATH": parses the file, answering with the error messages, as
+ *    stage-2 would
+ *  - "ast FORMAT PATH": the tree of the file, printed in the given format (see
+ *    ast_emitter.hh), as stage-3 would
+ *  - "diagnostics PATH": the error messages, or if there are none, the
+ *    warnings about what is sure to go wrong at run time (see ast_folder.hh)
+ *  - "shutdown": stops the server, once every request taken is answered
+ *
+ * The answer is a line with the status (0 for success), the size of the
+ * output and the size of the error messages, followed by both.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <fmt/core.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hcpsilva {
+
+/** @brief where the client looks for the server unless told otherwise: the
+ * CPP_COMPILER_SOCKET environment variable if set, or the runtime directory
+ * of its user (XDG_RUNTIME_DIR), which nobody else can write to. only without
+ * one is it a path of its user under /tmp */
+inline auto default_socket_path() -> std::string
+{
+    if (auto const* const path = std::getenv("CPP_COMPILER_SOCKET"))
+        return path;
+
+    if (auto const* const runtime = std::getenv("XDG_RUNTIME_DIR"); runtime != nullptr && *runtime != '\0')
+        return fmt::format("{}/cpp-compiler.sock", runtime);
+
+    return fmt::format("/tmp/cpp-compiler-{}.sock", getuid());
+}
+
+/** @brief whether there is nothing at path, or a socket of the calling user.
+ * anything else may have been put there by another user, to be answered by
+ * or to take the place of a server of theirs */
+inline auto socket_path_trusted(std::string const& path) -> bool
+{
+    struct stat status {};
+
+    if (lstat(path.c_str(), &status) != 0)
+        return errno == ENOENT;
+
+    return S_ISSOCK(status.st_mode) && status.st_uid == getuid();
+}
+
+struct server_statistics {
+    std::size_t requests    = 0;
+    std::size_t hits        = 0; // answered from a file already parsed
+    std::size_t parses      = 0;
+    std::size_t invalidated = 0; // parsed again, the file having changed
+    std::size_t evicted     = 0;
+};
+
+class compile_server {
+public:
+    /** @brief listens on socket_path, replacing a socket left there by a
+     * server no longer running. keeps up to capacity files */
+    explicit compile_server(std::string socket_path, std::size_t capacity = 256);
+
+    compile_server(compile_server const&) = delete;
+
+    auto operator=(compile_server const&) -> compile_server& = delete;
+
+    ~compile_server();
+
+    /** @brief answers requests on the given number of threads (0 for one per
+     * hardware thread) until a shutdown request */
+    auto serve(std::size_t threads = 0) -> void;
+
+    auto statistics() const -> server_statistics;
+
+private:
+    struct entry;
+
+    struct response {
+        int         status = 0;
+        std::string output;
+        std::string errors;
+    };
+
+    auto handle(int connection) -> void;
+
+    auto answer(std::string const& request) -> response;
+
+    /** @brief the file at path, parsed, parsing it (again) if needed */
+    auto lookup(std::string const& path) -> std::shared_ptr<entry>;
+
+    std::string socket_path;
+    std::size_t capacity;
+    int         listener = -1;
+
+    // guards the entries and the statistics
+    mutable std::mutex                                      lock;
+    std::unordered_map<std::string, std::shared_ptr<entry>> entries;
+    std::size_t                                             clock = 0; // of the last use of each entry
+    server_statistics                                       counts;
+    std::atomic<bool>                                       stopping = false;
+};
+
+}
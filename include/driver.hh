@@ -13,49 +13,234 @@
 
 #pragma once
 
+#include <cstdio>
 #include <fstream>
 #include <istream>
 #include <map>
-#include <optional>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "arena.hh"
 #include "ast.hh"
+#include "ast_binary.hh"
+#include "ast_emitter.hh"
+#include "ast_folder.hh"
+#include "bindings.hh"
+#include "flat_ast.hh"
+#include "iloc.hh"
+#include "iloc_generator.hh"
+#include "instrumentation.hh"
+#include "jit.hh"
 #include "lexic_values.hh"
+#include "line_index.hh"
 #include "location.hh"
+#include "optimizer.hh"
+#include "parse_cache.hh"
 #include "parser.hh"
 #include "scanner.hh"
+#include "simd_scanner.hh"
+#include "source_buffer.hh"
+#include "string_pool.hh"
 #include "symbol.hh"
+#include "thread_pool.hh"
 #include "tree.hh"
+#include "type_checker.hh"
+#include "vm.hh"
+#include "x86_64.hh"
 
 namespace hcpsilva {
 
 class driver {
 public:
+    /** @brief reads the given file, mapping it into memory */
     driver(std::string const& file_name);
 
-    driver() = default;
+    /** @brief reads the standard input */
+    driver();
 
     auto parse() -> int;
 
-    auto yylex() -> yy::parser::symbol_type { return this->scanner.lex(*this); }
+    /** @brief same as above, but each function found in cache is loaded
+     * instead of parsed, and each one parsed is stored there. the input must
+     * be a file (or a mapped standard input), anything else is just parsed */
+    auto parse(parse_cache& cache) -> int;
 
+    auto yylex() -> yy::parser::symbol_type
+    {
+        sampled_timer timing(this->report, phase::SCAN);
+
+        auto token = this->scanning == scanner_kind::SIMD && this->simd.ready() ? this->simd.lex(*this)
+                                                                                : this->scanner.lex(*this);
+
+        if (this->report != nullptr && token.kind() != yy::parser::symbol_kind::S_YYEOF)
+            ++this->report->tokens;
+
+        return token;
+    }
+
+    /** @brief scans what is parsed from then on with the given scanner, see
+     * simd_scanner.hh. sources read through a stream are always left to flex */
+    auto use_scanner(scanner_kind kind) -> void { this->scanning = kind; }
+
+    /** @brief each of these starts over with a new input, dropping the tree
+     * and symbols of the previous one, so a driver can be reused */
     auto swap_input(std::string const& file_name) -> void;
     auto swap_input(std::ifstream& input) -> void;
     auto swap_input() -> void;
 
-    auto print_ast() -> void;
+    /** @brief where print_ast and the error messages go, which are the
+     * standard output and error unless redirected */
+    auto redirect(std::FILE* output, std::FILE* errors) -> void;
+
+    /** @brief types and lowers the functions of what is parsed from then on
+     * over the given number of threads (0 for one per hardware thread), their
+     * results coming out in the order of the source however many there are.
+     * a tree already parsed stays as it is */
+    auto use_threads(std::size_t threads) -> void;
+
+    /** @brief counts the tokens of what is parsed from then on into report,
+     * if any, timing the parts of its parse, see instrumentation.hh */
+    auto measure(compile_report* report) -> void { this->report = report; }
+
+    /** @brief writes the tree out in a single pass, see ast_emitter.hh */
+    auto print_ast(ast_format format = ast_format::LEGACY) -> void;
+
+    /** @brief folds constants in the tree, see ast_folder.hh, warning about
+     * what is sure to go wrong at run time */
+    auto optimize() -> fold_statistics;
+
+    /** @brief the code of the tree, see iloc_generator.hh. only a tree parsed
+     * as a whole can be lowered, as the others miss what their names are */
+    auto lower() -> iloc_program;
+
+    /** @brief has the code of the tree go through the passes given from
+     * then on, see optimizer.hh, before being printed or run */
+    auto optimize_code(optimizer_passes const& passes) -> void { this->passes = passes; }
+
+    /** @brief the code of the tree, through the passes chosen (if any) */
+    auto code() -> iloc_program;
+
+    /** @brief what the passes did to the code last given */
+    auto code_statistics() const -> optimizer_statistics const& { return this->optimized; }
+
+    /** @brief writes the code of the tree out, see iloc.hh */
+    auto print_iloc() -> void;
+
+    /** @brief writes the code of the tree out as x86-64 assembly, see
+     * x86_64.hh */
+    auto print_asm() -> void;
+
+    /** @brief runs the code of the tree on the virtual machine, see vm.hh,
+     * reading input from in, and gives what main returns */
+    auto run(std::FILE* in = stdin) -> std::int32_t;
+
+    /** @brief the same, but on machine code translated in process, see
+     * jit.hh */
+    auto jit(std::FILE* in = stdin) -> std::int32_t;
+
+    /** @brief writes the tree to path, in the format of ast_binary.hh */
+    auto save_ast(std::string const& path) const -> void;
+
+    /** @brief replaces the tree with the one saved at path, as if its source
+     * had just been parsed */
+    auto load_ast(std::string const& path) -> void;
+
+    /** @brief the tree of the input, once parsed (or loaded) */
+    auto tree() const -> ast_node const* { return this->ast; }
+
+    /** @brief the same tree, laid out as in flat_ast.hh */
+    auto flatten() const -> flat_ast { return flat_ast::from(this->ast, this->built_nodes); }
+
+    /** @brief how many nodes were built so far, and the memory holding them */
+    auto node_count() const -> std::size_t { return this->built_nodes; }
+    auto node_bytes() const -> std::size_t;
+
+    auto intern(std::string_view name) -> identifier { return this->strings.intern(name); }
+
+    auto name(identifier id) const -> std::string_view { return this->strings.name(id); }
+
+    /** @brief declares name in the current scope, with the given dimensions
+     * if an array, complaining if it was already there. see bindings.hh for
+     * what is taken down about it */
+    auto declare(identifier name, symbol_kinds kind, types type, yy::location const& location,
+        std::vector<std::uint32_t> dimensions = {}) -> void;
+
+    /** @brief looks name up, complaining if it isn't there or if it was
+     * declared as something else than kind, and gives its type */
+    auto use(identifier name, symbol_kinds kind, yy::location const& location) -> types;
+
+    /** @brief the line and column where location begins, worked out of the
+     * source only now (see line_index.hh). line 0 if its source is gone */
+    auto position(yy::location const& location) -> line_column;
+
+    /** @brief what the names in the tree stand for, see bindings.hh */
+    auto names() const -> program_bindings const& { return this->bindings; }
+
+    /** @brief builds a node inside the driver's arena, which owns every node
+     * of the tree and releases them all at once when the driver goes away */
+    template <typename... nodes>
+    auto make_node(lexic_value value, yy::location const& location, nodes... children) -> ast_node*
+    {
+        sampled_timer timing(this->report, phase::AST);
+
+        ++this->built_nodes;
+
+        return this->storage.make<ast_node>(ast_value { std::move(value), location }, children...);
+    }
 
     friend class yy::scanner;
+    friend class yy::simd_scanner;
     friend class yy::parser;
 
 private:
-    yy::location            location;
-    std::string             file_name;
-    std::ifstream           input;
-    yy::scanner             scanner;
-    std::optional<ast_node> ast;
-    symbol_hash_table       symbol_table;
-    yy::parser              parser = yy::parser(*this);
+    auto reset() -> void;
+
+    /** @brief parses a single top level declaration of the source, as if it
+     * were all there is, leaving its tree (if any) in ast */
+    auto parse_span(source_span const& span) -> bool;
+
+    /** @brief types the expressions of the functions given, see
+     * type_checker.hh, once the whole source is parsed: the global scope is
+     * done by then, so each function only reads it, and they are spread over
+     * the threads if there are any. complains about the first semantic error
+     * in the order of the source */
+    auto check_functions(std::vector<ast_node*> const& functions) -> bool;
+
+    /** @brief declares a function loaded from a cache, given its header,
+     * which its type and those of its parameters are read from */
+    auto declare_cached(ast_node const* function, std::string_view header) -> bool;
+
+    arena            storage;
+    string_pool      strings;
+    yy::location     location;
+    std::string      file_name;
+    std::ifstream    input;
+    source_buffer    source;
+    line_index       lines;
+    source_buffer    loaded_source; // of a loaded tree, once lines are asked for
+    bool             loaded = false;
+    std::uint32_t    inputs = 0; // so far, numbering the files of the locations
+    yy::scanner      scanner;
+    yy::simd_scanner simd;
+    scanner_kind     scanning    = default_scanner;
+    ast_node*        ast         = nullptr;
+    std::size_t      built_nodes = 0;
+    std::FILE*       output      = stdout;
+    std::FILE*       errors      = stderr;
+    symbol_table     symbols;
+    program_bindings bindings;
+    types            declared_type = types::INT; // of the declaration being read
+    yy::parser       parser        = yy::parser(*this);
+
+    optimizer_passes     passes = optimizer_passes::none(); // what code() runs through
+    optimizer_statistics optimized;                         // by the last of them
+    compile_report*      report = nullptr;                  // where the parts of the parse are timed
+
+    // where functions are typed and lowered, if not on the calling thread,
+    // and what each worker builds in the meantime
+    std::unique_ptr<thread_pool>        workers;
+    std::vector<std::unique_ptr<arena>> worker_storage;
 };
 
 }
@@ -1,7 +0,0 @@
-#pragma once
-
-#include "driver.hh"
-
-hcpsilva::driver driver;
-
-#define yyparse() driver.parse()
@@ -0,0 +1,134 @@
+/** @file flat_ast.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The tree laid out as a structure of arrays, for passes that go over all of
+ * it. Nodes are numbered breadth first, so the children of each node (its next
+ * being the last of them) take a contiguous range of numbers, always greater
+ * than its own. Going up the numbers walks the tree top down, going down walks
+ * it bottom up, neither chasing a single pointer.
+ *
+ * Each node is, in separate arrays:
+ *
+ *  - a dense tag of what it is, a single byte
+ *  - the range of its children
+ *  - a 32 bit payload, with the literal or name it holds (floating point
+ *    literals are kept apart, the payload being their index)
+ *  - its location, which most passes never look at
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ast.hh"
+#include "lexic_values.hh"
+#include "location.hh"
+
+namespace hcpsilva {
+
+/** @brief every kind of node there is, one per enumerator of the enums that
+ * make up lexic_value, in their order, and one per other alternative */
+enum class node_kind : std::uint8_t {
+    NONE,
+
+    // types
+    INT,
+    FLOAT,
+    CHAR,
+    BOOL,
+
+    // keywords
+    IF,
+    WHILE,
+    INPUT,
+    OUTPUT,
+    RETURN,
+
+    // operations
+    ATTRIBUTION,
+    INITIALIZATION,
+    DIVISION,
+    MULTIPLICATION,
+    REST,
+    LESS_THAN,
+    GREATER_THAN,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    EQUAL,
+    NOT_EQUAL,
+    AND,
+    OR,
+    NEGATION,
+    POSITIVE,
+    NEGATIVE,
+    INDEX,
+    INDEX_SEP,
+
+    // literals and names
+    INTEGER,
+    BOOLEAN,
+    FLOATING_POINT,
+    CHARACTER,
+    IDENTIFIER,
+    CALL
+};
+
+/** @brief the kind of node holding value */
+auto kind_of(lexic_value const& value) -> node_kind;
+
+struct child_range {
+    std::uint32_t first   = 0;
+    std::uint16_t count   = 0;
+    std::uint16_t chained = 0; // whether the last child is the next of the node
+};
+
+class flat_ast {
+public:
+    /** @brief lays out the tree under root, the chain after it included.
+     * room is made for nodes up front, if their amount is known */
+    static auto from(ast_node const* root, std::size_t nodes = 0) -> flat_ast;
+
+    auto size() const -> std::size_t { return this->kinds.size(); }
+
+    auto kind(std::size_t node) const -> node_kind { return this->kinds[node]; }
+
+    auto children(std::size_t node) const -> child_range { return this->ranges[node]; }
+
+    auto payload(std::size_t node) const -> std::uint32_t { return this->payloads[node]; }
+
+    auto location(std::size_t node) const -> yy::location const& { return this->locations[node]; }
+
+    /** @brief the value the node was made from */
+    auto value(std::size_t node) const -> lexic_value;
+
+    /** @brief the arrays themselves, to be scanned linearly */
+    auto all_kinds() const -> std::vector<node_kind> const& { return this->kinds; }
+    auto all_ranges() const -> std::vector<child_range> const& { return this->ranges; }
+    auto all_payloads() const -> std::vector<std::uint32_t> const& { return this->payloads; }
+
+    /** @brief memory taken by the arrays, without and with the locations */
+    auto hot_bytes() const -> std::size_t;
+    auto bytes() const -> std::size_t;
+
+private:
+    std::vector<node_kind>     kinds;
+    std::vector<child_range>   ranges;
+    std::vector<std::uint32_t> payloads;
+    std::vector<double>        floats;
+    std::vector<yy::location>  locations;
+};
+
+}
@@ -0,0 +1,170 @@
+/** @file iloc.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The intermediate representation (stage E5): three address code after ILOC,
+ * over as many virtual registers and labels as needed. Every value is a 32 bit
+ * word, as in ILOC: chars and bools are their codes, and floats are single
+ * precision, worked on by instructions of their own (those starting with f)
+ * and converted to and from ints where the types of the source say so. Scalar
+ * parameters and locals live in registers of their own
+ * (the parameters being the first ones), globals live in memory from rbss on,
+ * a word each, arrays laid out row by row.
+ *
+ * The code of each function is a single array of fixed size instructions,
+ * labels being instructions of their own, so walking it never leaves the
+ * array. What doesn't fit an instruction (the arguments of a call) goes in an
+ * array beside it.
+ *
+ * Its textual form is the one printed, and reading it back gives the same
+ * program:
+ *
+ *     globals 3
+ *     function main 1
+ *         loadI 2 => r1
+ *         cmp_LT r0, r1 => r2
+ *         cbr r2 -> L0, L1
+ *     L0:
+ *         call fn, r0 => r3
+ *         storeAI r3 => rbss, 2
+ *     L1:
+ *         ret r0
+ *     end
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hcpsilva {
+
+/** @brief each instruction and its operands, as in r1, r2 => r3 */
+enum class opcode : std::uint8_t {
+    NOP,
+
+    // r1, r2 => r3
+    ADD,
+    SUB,
+    MULT,
+    DIV,
+    MOD,
+    CMP_LT,
+    CMP_LE,
+    CMP_EQ,
+    CMP_GE,
+    CMP_GT,
+    CMP_NE,
+
+    // r1, r2 => r3, over floats
+    FADD,
+    FSUB,
+    FMULT,
+    FDIV,
+    FCMP_LT,
+    FCMP_LE,
+    FCMP_EQ,
+    FCMP_GE,
+    FCMP_GT,
+    FCMP_NE,
+
+    // r1, c2 => r3
+    ADDI,
+    MULTI,
+    RSUBI, // c2 - r1
+
+    // c1 => r3, and the bits of a float constant (written as such) => r3
+    LOADI,
+    LOADF,
+
+    // r1 => r3, the last two converting between ints and floats
+    I2I,
+    I2F,
+    F2I,
+
+    // memory: base r1 plus a word offset, c2 or r2, => r3 or r3 =>
+    LOADAI,
+    LOADAO,
+    STOREAI,
+    STOREAO,
+
+    // -> l1, r1 -> l2, l3 and l1: where a label is
+    JUMPI,
+    CBR,
+    LABEL,
+
+    // call function c1 with the arguments from c2 on (see iloc_function) => r3
+    CALL,
+    RET,
+
+    // io, => r3 and r1 =>, of ints and of floats
+    INPUT,
+    OUTPUT,
+    FINPUT,
+    FOUTPUT,
+};
+
+/** @brief the operands an opcode takes, in a, b and c. registers are numbered
+ * from 0, special ones are negative (see rbss) */
+struct instruction {
+    opcode       op = opcode::NOP;
+    std::int32_t a  = 0;
+    std::int32_t b  = 0;
+    std::int32_t c  = 0;
+
+    auto operator==(instruction const&) const -> bool = default;
+};
+
+/** @brief where the globals start */
+constexpr std::int32_t rbss = -1;
+
+struct iloc_function {
+    std::string   name;
+    std::uint32_t parameters = 0;
+    std::uint32_t registers  = 0; // how many are used, the parameters included
+    std::uint32_t labels     = 0;
+
+    std::vector<instruction> code;
+
+    // for each call, how many arguments it has followed by their registers
+    std::vector<std::int32_t> arguments;
+
+    auto operator==(iloc_function const&) const -> bool = default;
+};
+
+struct iloc_program {
+    std::uint32_t              globals = 0; // in words
+    std::vector<iloc_function> functions;
+
+    auto operator==(iloc_program const&) const -> bool = default;
+};
+
+/** @brief the name of op in the textual form */
+auto mnemonic(opcode op) -> std::string_view;
+
+/** @brief how many registers the code of function uses, which is at least its
+ * parameters */
+auto used_registers(iloc_function const& function) -> std::uint32_t;
+
+/** @brief writes program in its textual form */
+auto print_iloc(iloc_program const& program, std::FILE* out = stdout) -> void;
+
+/** @brief reads a program back from its textual form, complaining (with
+ * std::runtime_error) about the first line it can't make sense of */
+auto read_iloc(std::string_view text) -> iloc_program;
+
+}
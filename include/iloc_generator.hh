@@ -0,0 +1,46 @@
+/** @file iloc_generator.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Lowers the tree into the code of iloc.hh, a function at a time. Each value
+ * is computed into a register of its own, and conditions are lowered straight
+ * into branches: && and || jump over their right side once their left decides
+ * the result, and they compute a value (by branching to a 1 or a 0) only where
+ * one is needed. What is left to lower is kept in a stack of its own, so the
+ * call stack stays put however deep the expressions nest.
+ */
+
+#pragma once
+
+#include <functional>
+
+#include "ast.hh"
+#include "bindings.hh"
+#include "iloc.hh"
+#include "string_pool.hh"
+#include "thread_pool.hh"
+
+namespace hcpsilva {
+
+/** @brief the line where a location begins, which only the driver knows */
+using line_resolver = std::function<int(yy::location const&)>;
+
+/** @brief the code of the functions chained from root, given what their names
+ * stand for. complains (with std::runtime_error, at the line given by line_of)
+ * about arrays indexed with the wrong number of dimensions. given a pool, the
+ * functions are lowered on its workers (line_of then being called from any of
+ * them), their code coming out in the same order all the same */
+auto generate_iloc(ast_node const* root, program_bindings const& bindings, string_pool const& strings,
+    line_resolver const& line_of, thread_pool* pool = nullptr) -> iloc_program;
+
+}
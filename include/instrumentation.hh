@@ -0,0 +1,206 @@
+/** @file instrumentation.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Where the time of a compile goes, phase by phase, along with how many
+ * tokens and nodes it went through and how much memory it took. Each phase is
+ * timed by a phase_timer over its scope, in wall and CPU time of the thread
+ * running it, and the bytes allocated by that thread meanwhile:
+ *
+ *  - parse: scanning, parsing, building the tree and its semantic analysis,
+ *    all of it, as measured
+ *  - fold, code, print, run: folding the tree, lowering (and optimizing) its
+ *    code, printing and running it
+ *
+ * The parts of the parse happen token by token, interleaved with each other,
+ * so they can't be told apart by timing a scope: scan (the scanner), ast
+ * (building the nodes) and semantic (declaring and looking names up, and then
+ * typing the functions). Each call to the first ones takes about as long as
+ * reading the clock, so only one in sampled_timer::period is timed and scaled
+ * up to all of them. The parts are reported under the parse as estimates, in
+ * wall time only, and never taken out of it.
+ *
+ * All of it is only built in with the instrumentation option (see
+ * build-configurations.hh), otherwise timers do nothing and no allocation is
+ * counted. Even when built in, nothing is measured unless asked for.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+#include "build-configurations.hh"
+
+namespace hcpsilva {
+
+enum class phase : std::uint8_t {
+    SCAN,
+    PARSE,
+    SEMANTIC,
+    AST,
+    FOLD,
+    CODE,
+    PRINT,
+    RUN,
+};
+
+inline constexpr std::size_t phase_count = 8;
+
+auto phase_name(phase which) -> std::string_view;
+
+/** @brief whether a phase is a part of parse, its time an estimate */
+constexpr auto part_of_parse(phase which) -> bool
+{
+    return which == phase::SCAN || which == phase::SEMANTIC || which == phase::AST;
+}
+
+struct phase_measure {
+    double      wall_seconds = 0;
+    double      cpu_seconds  = 0;
+    std::size_t allocated    = 0; // bytes
+};
+
+struct compile_report {
+    std::array<phase_measure, phase_count> phases;
+
+    std::size_t tokens = 0;
+    std::size_t nodes  = 0;
+
+    // of the sampled phases, which calls are timed goes by these
+    std::array<std::uint32_t, phase_count> calls {};
+
+    auto operator[](phase which) -> phase_measure& { return this->phases[static_cast<std::size_t>(which)]; }
+    auto operator[](phase which) const -> phase_measure const& { return this->phases[static_cast<std::size_t>(which)]; }
+
+    auto operator+=(compile_report const& other) -> compile_report&;
+};
+
+/** @brief the CPU time the calling thread has taken so far, in seconds */
+auto thread_cpu_seconds() -> double;
+
+/** @brief the bytes the calling thread has allocated so far, 0 when not built
+ * in */
+auto allocated_bytes() -> std::size_t;
+
+/** @brief the peak resident set of the process, in bytes */
+auto peak_rss() -> std::size_t;
+
+/** @brief writes a report out as a table, for people */
+auto print_time_report(compile_report const& report, std::size_t files, std::FILE* out) -> void;
+
+/** @brief the same, as a single JSON object */
+auto print_stats(compile_report const& report, std::size_t files, std::FILE* out) -> void;
+
+#ifdef INSTRUMENTATION
+
+/** @brief adds the time (and allocations) of its scope to a phase of report,
+ * if any. fine ones, timing a part of another phase, skip the CPU clock and
+ * the allocations, which are only told for whole phases */
+class phase_timer {
+public:
+    phase_timer(compile_report* report, phase which, bool fine = false)
+        : report(report)
+        , which(which)
+        , fine(fine)
+    {
+        if (this->report == nullptr)
+            return;
+
+        this->wall      = std::chrono::steady_clock::now();
+        this->cpu       = fine ? 0 : thread_cpu_seconds();
+        this->allocated = fine ? 0 : allocated_bytes();
+    }
+
+    phase_timer(phase_timer const&) = delete;
+
+    auto operator=(phase_timer const&) -> phase_timer& = delete;
+
+    ~phase_timer()
+    {
+        if (this->report == nullptr)
+            return;
+
+        auto& measure = (*this->report)[this->which];
+
+        measure.wall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - this->wall).count();
+
+        if (!this->fine) {
+            measure.cpu_seconds += thread_cpu_seconds() - this->cpu;
+            measure.allocated += allocated_bytes() - this->allocated;
+        }
+    }
+
+private:
+    compile_report*                       report;
+    phase                                 which;
+    bool                                  fine;
+    std::chrono::steady_clock::time_point wall;
+    double                                cpu       = 0;
+    std::size_t                           allocated = 0;
+};
+
+/** @brief times one call in period of those made within a phase of report,
+ * if any, adding it period times over: an estimate of the time of all of them,
+ * where timing each would take longer than what is timed */
+class sampled_timer {
+public:
+    static constexpr std::uint32_t period = 64;
+
+    sampled_timer(compile_report* report, phase which)
+        : report(report != nullptr && ++report->calls[static_cast<std::size_t>(which)] % period == 0 ? report : nullptr)
+        , which(which)
+    {
+        if (this->report != nullptr)
+            this->wall = std::chrono::steady_clock::now();
+    }
+
+    sampled_timer(sampled_timer const&) = delete;
+
+    auto operator=(sampled_timer const&) -> sampled_timer& = delete;
+
+    ~sampled_timer()
+    {
+        if (this->report == nullptr)
+            return;
+
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->wall).count();
+
+        (*this->report)[this->which].wall_seconds += elapsed * period;
+    }
+
+private:
+    compile_report*                       report;
+    phase                                 which;
+    std::chrono::steady_clock::time_point wall;
+};
+
+#else
+
+class phase_timer {
+public:
+    phase_timer(compile_report*, phase, bool = false) { }
+};
+
+class sampled_timer {
+public:
+    sampled_timer(compile_report*, phase) { }
+};
+
+#endif
+
+}
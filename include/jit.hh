@@ -0,0 +1,72 @@
+/** @file jit.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Runs the code of iloc.hh in process, as x86-64 machine code written straight
+ * into memory of its own, laid out as the assembly of x86_64.hh is: a slot in
+ * the frame for each virtual register, values worked on in eax and xmm0.
+ *
+ * Functions are translated only once they are first called. Until then, each
+ * call goes through a stub of its callee, which translates it and patches the
+ * call that got there to go straight to it from then on. The memory is only
+ * writable while that happens, and only executable otherwise.
+ *
+ * Input and output go through helpers of the runtime, and so do the errors:
+ * dividing by zero, reaching out of the globals and calling too deep stop the
+ * program and are complained about, as on the virtual machine (see vm.hh),
+ * instead of bringing the whole process down.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+#include "iloc.hh"
+
+namespace hcpsilva {
+
+struct jit_statistics {
+    std::size_t translated = 0; // functions
+    std::size_t patched    = 0; // calls
+    std::size_t code_bytes = 0;
+};
+
+class jit {
+public:
+    /** @brief maps memory for the code of program, complaining (with
+     * std::runtime_error) about what can't be translated */
+    explicit jit(iloc_program program);
+
+    jit(jit const&) = delete;
+
+    auto operator=(jit const&) -> jit& = delete;
+
+    ~jit();
+
+    /** @brief calls main and gives what it returns, reading input from in and
+     * writing output to out, a number per line. the globals start zeroed on
+     * each run, but what was translated stays so */
+    auto run(std::FILE* in = stdin, std::FILE* out = stdout) -> std::int32_t;
+
+    auto statistics() const -> jit_statistics;
+
+    struct state;
+
+private:
+    std::unique_ptr<state> self;
+};
+
+}
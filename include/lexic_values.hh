@@ -27,6 +27,8 @@
 #include <fmt/std.h>
 #include <magic_enum.hpp>
 
+#include "string_pool.hh"
+
 namespace hcpsilva {
 
 enum class keywords {
@@ -65,7 +67,21 @@ enum class operations {
     INDEX_SEP
 };
 
-using lexic_value = std::variant<std::monostate, types, keywords, operations, int, bool, double, char, std::string>;
+/** @brief the callee of a function call, printed as "call <name>" */
+struct function_call {
+    identifier callee;
+
+    auto operator<=>(function_call const& rhs) const = default;
+};
+
+using lexic_value = std::variant<std::monostate, types, keywords, operations, int, bool, double, char, identifier, function_call>;
+
+/** @brief a lexic value paired with the pool its names were interned in, so
+ * it can be printed with the names instead of their ids */
+struct named_value {
+    lexic_value const& value;
+    string_pool const& strings;
+};
 
 template <typename type_to_check, typename... types_to_check_against>
 concept type_in = (std::same_as<std::remove_cvref_t<type_to_check>, types_to_check_against> || ...);
@@ -92,6 +108,24 @@ struct fmt::formatter<T> : formatter<std::string> {
     }
 };
 
+template <>
+struct fmt::formatter<hcpsilva::identifier> : formatter<std::string_view> {
+    template <typename FormatContext>
+    auto format(hcpsilva::identifier const& name, FormatContext& ctx) const -> decltype(ctx.out())
+    {
+        return fmt::format_to(ctx.out(), "#{}", name.id);
+    }
+};
+
+template <>
+struct fmt::formatter<hcpsilva::function_call> : formatter<std::string_view> {
+    template <typename FormatContext>
+    auto format(hcpsilva::function_call const& call, FormatContext& ctx) const -> decltype(ctx.out())
+    {
+        return fmt::format_to(ctx.out(), "call #{}", call.callee.id);
+    }
+};
+
 template <>
 struct fmt::formatter<hcpsilva::lexic_value> {
     template <typename ParseContext>
@@ -111,6 +145,27 @@ struct fmt::formatter<hcpsilva::lexic_value> {
     }
 };
 
+template <>
+struct fmt::formatter<hcpsilva::named_value> {
+    template <typename ParseContext>
+    auto parse(ParseContext& ctx) -> decltype(ctx.begin())
+    {
+        return ctx.begin();
+    }
+
+    template <typename FormatContext>
+    auto format(hcpsilva::named_value const& named, FormatContext& ctx) const -> decltype(ctx.out())
+    {
+        if (auto name = std::get_if<hcpsilva::identifier>(&named.value))
+            return fmt::format_to(ctx.out(), "{}", named.strings.name(*name));
+
+        if (auto call = std::get_if<hcpsilva::function_call>(&named.value))
+            return fmt::format_to(ctx.out(), "call {}", named.strings.name(call->callee));
+
+        return fmt::format_to(ctx.out(), "{}", named.value);
+    }
+};
+
 template <>
 struct fmt::formatter<hcpsilva::operations> : formatter<std::string> {
     template <typename FormatContext>
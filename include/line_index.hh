@@ -0,0 +1,51 @@
+/** @file line_index.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Where each line of a source begins, so the byte offsets of a location can be
+ * turned into a line and column with a binary search. Nothing is indexed until
+ * the first of those is asked for, which only ever happens for diagnostics, so
+ * a source parsed without complaints never pays for it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace hcpsilva {
+
+/** @brief both counted from 1, columns in bytes */
+struct line_column {
+    int line   = 1;
+    int column = 1;
+};
+
+class line_index {
+public:
+    /** @brief where offset falls in text. text must be the same source at
+     * every call until clear, though it may have grown since the last one (as
+     * a source read through a stream does) */
+    auto at(std::string_view text, std::uint32_t offset) -> line_column;
+
+    /** @brief forgets the source indexed so far, for another one */
+    auto clear() -> void;
+
+private:
+    std::vector<std::uint32_t> starts { 0 }; // of each line
+    std::size_t                indexed = 0;  // bytes of the source gone over
+};
+
+}
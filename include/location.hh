@@ -0,0 +1,83 @@
+/** @file location.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The location type used by the parser, in place of the one bison generates:
+ * the file it was read from and the byte offsets where it begins and ends,
+ * 12 bytes in all. Every token and node carries one, but only diagnostics ever
+ * need lines and columns, which a line_index (see line_index.hh) works out
+ * from the offsets once asked for.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace yy {
+
+class location {
+public:
+    using file_type   = std::uint32_t; // which input of the driver, see driver.hh
+    using offset_type = std::uint32_t;
+
+    explicit location(file_type file = 0, offset_type begin = 0, offset_type end = 0)
+        : file(file)
+        , begin(begin)
+        , end(end)
+    {
+    }
+
+    /** @brief from where first begins up to where last ends */
+    location(location const& first, location const& last)
+        : file(first.file)
+        , begin(first.begin)
+        , end(last.end)
+    {
+    }
+
+    auto initialize(file_type file = 0, offset_type offset = 0) -> void
+    {
+        this->file  = file;
+        this->begin = offset;
+        this->end   = offset;
+    }
+
+    /** @brief starts a new location where this one ends */
+    auto step() -> void { this->begin = this->end; }
+
+    /** @brief extends the location over the next count bytes, line breaks
+     * included */
+    auto columns(int count = 1) -> void { this->end += static_cast<offset_type>(count); }
+
+    /** @brief how many bytes of the source this location spans */
+    auto size() const -> std::size_t { return this->end - this->begin; }
+
+    file_type   file;
+    offset_type begin;
+    offset_type end;
+};
+
+inline auto operator==(location const& lhs, location const& rhs) -> bool
+{
+    return lhs.file == rhs.file && lhs.begin == rhs.begin && lhs.end == rhs.end;
+}
+
+// only ever written by the traces of the parser, lines are left to diagnostics
+inline auto operator<<(std::ostream& out, location const& loc) -> std::ostream&
+{
+    return out << '#' << loc.file << ':' << loc.begin << '-' << loc.end;
+}
+
+}
@@ -0,0 +1,67 @@
+/** @file memory_file.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * A FILE writing into memory, which the driver prints to just as it would to
+ * the terminal, so what a compile writes can be kept apart and handed over as
+ * a whole.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace hcpsilva {
+
+class memory_file {
+public:
+    memory_file()
+        : handle(open_memstream(&this->buffer, &this->size))
+    {
+        if (this->handle == nullptr)
+            throw std::runtime_error("driver error, could not open a memory stream\n");
+    }
+
+    memory_file(memory_file const&) = delete;
+
+    auto operator=(memory_file const&) -> memory_file& = delete;
+
+    ~memory_file()
+    {
+        if (this->handle != nullptr)
+            std::fclose(this->handle);
+
+        std::free(this->buffer);
+    }
+
+    auto get() const -> std::FILE* { return this->handle; }
+
+    /** @brief closes the stream, handing over everything written to it */
+    auto take() -> std::string
+    {
+        std::fclose(this->handle);
+        this->handle = nullptr;
+
+        return std::string(this->buffer, this->size);
+    }
+
+private:
+    char*       buffer = nullptr;
+    std::size_t size   = 0;
+    std::FILE*  handle;
+};
+
+}
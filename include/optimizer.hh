@@ -0,0 +1,80 @@
+/** @file optimizer.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Optimizes the code of iloc.hh a function at a time, over its control flow
+ * graph in SSA form: the code is split in blocks at its labels and jumps,
+ * which is where the ifs and whiles of the source branch, and each register
+ * gets a new name at each write, with phis where paths meet. Copies are
+ * folded away on the way in, their uses reading the original. The passes, run
+ * in this order and each of which can be turned off on its own, are:
+ *
+ *  - sccp: sparse conditional constant propagation. values known to be
+ *    constant are loaded as such, and memory at a known index is addressed
+ *    with an offset instead. branches over a known condition become jumps,
+ *    and the blocks no longer reached are dropped
+ *  - licm: loop invariant code motion. what computes the same in every trip
+ *    around a loop (a while, in the source) is moved to right before it
+ *  - gvn: global value numbering, over the dominator tree. what computes a
+ *    value already at hand is dropped, its uses reading that one instead
+ *  - dce: dead code elimination. what computes values never read is dropped
+ *
+ * Nothing that could be seen from outside is ever moved or dropped: calls,
+ * stores, input and output, and so aren't divisions (unless by a constant
+ * other than zero) and indexed loads, whose errors must happen where they
+ * did. Leaving SSA puts copies where the phis were, and the registers are
+ * numbered again from the parameters on.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "iloc.hh"
+
+namespace hcpsilva {
+
+struct optimizer_passes {
+    bool constants  = true; // sccp
+    bool invariants = true; // licm
+    bool numbering  = true; // gvn
+    bool dead_code  = true; // dce
+
+    static constexpr auto none() -> optimizer_passes { return { false, false, false, false }; }
+};
+
+/** @brief the passes in list, as "all", "none" or their names above separated
+ * by commas, as in "sccp,dce" */
+auto parse_optimizer_passes(std::string_view list) -> std::optional<optimizer_passes>;
+
+struct optimizer_statistics {
+    std::size_t constants   = 0; // values loaded as constants, and indices made offsets (sccp)
+    std::size_t branches    = 0; // conditional branches made jumps (sccp)
+    std::size_t unreachable = 0; // blocks dropped (sccp)
+    std::size_t redundant   = 0; // values computed again, dropped (gvn)
+    std::size_t copies      = 0; // copies folded into SSA
+    std::size_t hoisted     = 0; // out of loops (licm)
+    std::size_t dead        = 0; // instructions and phis dropped (dce)
+    std::size_t before      = 0; // instructions, labels included
+    std::size_t after       = 0;
+
+    auto operator+=(optimizer_statistics const& other) -> optimizer_statistics&;
+};
+
+/** @brief runs the passes chosen over each function of program, in place.
+ * with none of them, program is left as it was */
+auto optimize_iloc(iloc_program& program, optimizer_passes const& passes = {}) -> optimizer_statistics;
+
+}
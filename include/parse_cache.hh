@@ -0,0 +1,100 @@
+/** @file parse_cache.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * An on-disk cache of parsed functions, so a file that changed in a single
+ * function only gets that function parsed again. Every function is kept in a
+ * tree file of its own (see ast_binary.hh), named after a digest of:
+ *
+ *  - the version of the compiler, so no entry outlives the code that wrote it
+ *  - the text of every global declaration and function header of its source
+ *    file, so any change to those (which the function may refer to) leaves all
+ *    of its functions behind
+ *  - the text of the function itself
+ *
+ * Locations are kept relative to the start of the function, which then may
+ * move around its file freely. Entries are written to a temporary file and
+ * renamed into place, so many processes (or workers) may share a cache.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.hh"
+#include "ast.hh"
+#include "string_pool.hh"
+
+namespace hcpsilva {
+
+/** @brief a top level declaration, found without parsing anything */
+struct source_span {
+    std::size_t begin; // offsets into the source
+    std::size_t end;
+    std::size_t body; // where the body of a function begins, end otherwise
+    bool        function; // or a global declaration
+};
+
+/** @brief splits source into its top level declarations, by their braces and
+ * semicolons alone (skipping comments and characters). nothing is returned if
+ * they don't add up, leaving it for the parser to complain about */
+auto split_source(std::string_view source) -> std::optional<std::vector<source_span>>;
+
+/** @brief moves every location under function, parsed as if it were a file of
+ * its own, to where span begins. function must have no next of its own */
+auto shift_locations(ast_node* function, source_span const& span) -> void;
+
+struct cache_statistics {
+    std::size_t hits   = 0;
+    std::size_t misses = 0;
+    std::size_t stores = 0; // entries written, failures to do so are ignored
+};
+
+class parse_cache {
+public:
+    /** @brief a cache kept under directory, created if missing */
+    explicit parse_cache(std::filesystem::path directory);
+
+    /** @brief the key of a function given its text and the text of every
+     * global declaration and function header of its file, in any form as long
+     * as it is the same for every function of that file */
+    auto key(std::string_view function, std::string_view globals) const -> std::string;
+
+    /** @brief the tree cached under key, built out of storage with its
+     * locations in file, or nullptr. the amount of nodes built is added to
+     * nodes */
+    auto load(std::string const& key, arena& storage, string_pool& strings, yy::location::file_type file,
+              std::size_t& nodes) -> ast_node*;
+
+    /** @brief caches the tree of a function under key */
+    auto store(std::string const& key, ast_node const* function, string_pool const& strings) -> void;
+
+    auto statistics() const -> cache_statistics;
+
+private:
+    auto entry(std::string const& key) const -> std::filesystem::path;
+
+    std::filesystem::path    directory;
+    std::atomic<std::size_t> hits      = 0;
+    std::atomic<std::size_t> misses    = 0;
+    std::atomic<std::size_t> stores    = 0;
+    std::atomic<std::size_t> temporary = 0; // names each temporary file apart
+};
+
+}
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <cstddef>
 #include <iostream>
+#include <string>
+#include <string_view>
 
 #if !defined(yyFlexLexerOnce)
 #include "FlexLexer.h"
 #endif
 
+#include "location.hh"
 #include "parser.hh"
 
 namespace hcpsilva {
@@ -21,16 +25,36 @@ public:
 
     virtual auto lex(hcpsilva::driver& driver) -> parser::symbol_type;
 
-    auto get_current_line(void) -> std::string const&;
+    /** @brief scans size bytes starting at base in place, without copying
+     * them. base[size] and base[size + 1] must both be NUL */
+    auto scan_buffer(char* base, std::size_t size) -> void;
 
-    auto get_last_token(void) -> std::string const&;
+    /** @brief scans whatever can be read from input, through flex's buffer */
+    auto scan_stream(std::istream* input) -> void;
 
-private:
-    std::string current_line;
+    /** @brief puts back the character flex keeps replaced by a NUL after the
+     * last token, leaving a buffer given to scan_buffer as it was handed over */
+    auto restore() -> void;
+
+    /** @brief all of the source read so far, as it was handed over */
+    auto source_text() -> std::string_view;
+
+    /** @brief the source text under location */
+    auto get_token(location const& loc) -> std::string_view;
 
-    std::string last_token;
+    /** @brief the complete source line where location begins */
+    auto get_line(location const& loc) -> std::string_view;
+
+protected:
+    auto LexerInput(char* buffer, int max_size) -> int override;
+
+private:
+    // the source being scanned in place, if any
+    std::string_view buffer;
 
-    auto on_new_token(char* yytext, int yyleng, char yy_hold_char) -> void;
+    // everything read so far when scanning a stream, which can't be revisited.
+    // it grows a whole read at a time, never per token
+    std::string history;
 };
 
 }
@@ -0,0 +1,79 @@
+/** @file simd_scanner.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * A hand written scanner giving the very same tokens (and locations, and
+ * errors) as the flex one in scanner.ll, over a source held in memory. Runs of
+ * whitespace, comments, letters and digits are gone over a vector at a time,
+ * with AVX2 or SSE2 as the build allows and a byte at a time otherwise, and
+ * keywords are looked up in a table built at compile time. Sources read
+ * through a stream are left to flex.
+ *
+ * Which scanner the driver uses is chosen at run time, defaulting to the one
+ * given by the scanner option of the build (see build-configurations.hh).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "build-configurations.hh"
+#include "parser.hh"
+
+namespace hcpsilva {
+
+class driver;
+
+enum class scanner_kind {
+    FLEX,
+    SIMD,
+};
+
+#ifdef SIMD_SCANNER
+inline constexpr auto default_scanner = scanner_kind::SIMD;
+#else
+inline constexpr auto default_scanner = scanner_kind::FLEX;
+#endif
+
+/** @brief the scanner named, as in "flex" or "simd" */
+auto parse_scanner_kind(std::string_view name) -> std::optional<scanner_kind>;
+
+}
+
+namespace yy {
+
+class simd_scanner {
+public:
+    /** @brief scans size bytes starting at base, which must be followed by
+     * two NULs, as flex needs them too */
+    auto scan_buffer(char const* base, std::size_t size) -> void;
+
+    /** @brief forgets the buffer, as a stream can't be scanned */
+    auto clear() -> void { this->cursor = this->end = nullptr; }
+
+    /** @brief whether there is a buffer to scan */
+    auto ready() const -> bool { return this->cursor != nullptr; }
+
+    auto lex(hcpsilva::driver& driver) -> parser::symbol_type;
+
+private:
+    /** @brief goes over a block comment, its opening already matched */
+    auto skip_comment(location& loc) -> void;
+
+    char const* cursor = nullptr;
+    char const* end    = nullptr;
+};
+
+}
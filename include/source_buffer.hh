@@ -0,0 +1,78 @@
+/** @file source_buffer.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The whole contents of a source file in memory, mapped straight from the file
+ * whenever possible. The bytes are followed by `padding` NUL characters (which
+ * flex requires at the end of a buffer it scans in place) and are writable, as
+ * flex temporarily patches the character after each token. Writes are private
+ * to the process, the file itself is never touched.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace hcpsilva {
+
+class source_buffer {
+public:
+    static constexpr std::size_t padding = 2;
+
+    source_buffer() = default;
+
+    source_buffer(source_buffer&& other) noexcept;
+
+    auto operator=(source_buffer&& other) noexcept -> source_buffer&;
+
+    source_buffer(source_buffer const&) = delete;
+
+    auto operator=(source_buffer const&) -> source_buffer& = delete;
+
+    ~source_buffer();
+
+    /** @brief maps the named file, or reads it if it can't be mapped */
+    static auto open(std::string const& file_name) -> source_buffer;
+
+    /** @brief same as above, for an already open descriptor (not closed) */
+    static auto open(int descriptor) -> source_buffer;
+
+    /** @brief whether the descriptor refers to something that can be mapped */
+    static auto mappable(int descriptor) -> bool;
+
+    auto data() const -> char* { return this->bytes; }
+
+    /** @brief size of the contents, not counting the padding */
+    auto size() const -> std::size_t { return this->length; }
+
+    auto view() const -> std::string_view { return { this->bytes, this->length }; }
+
+    auto mapped() const -> bool { return this->mapping_size != 0; }
+
+    auto empty() const -> bool { return this->bytes == nullptr; }
+
+private:
+    static auto map(int descriptor, std::size_t size) -> source_buffer;
+
+    static auto read(int descriptor) -> source_buffer;
+
+    auto release() -> void;
+
+    char*       bytes        = nullptr;
+    std::size_t length       = 0;
+    std::size_t mapping_size = 0; // 0 when the bytes were read into the heap
+};
+
+}
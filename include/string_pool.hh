@@ -0,0 +1,73 @@
+/** @file string_pool.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Interning of identifiers. Each distinct name is stored once and is from then
+ * on referred to by a small integer, so comparing two names is an integer
+ * comparison and hashing one is free.
+ */
+
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "arena.hh"
+
+namespace hcpsilva {
+
+/** @brief a name interned in a string_pool */
+struct identifier {
+    std::uint32_t id;
+
+    auto operator<=>(identifier const& rhs) const = default;
+};
+
+class string_pool {
+public:
+    string_pool() = default;
+
+    string_pool(string_pool const&) = delete;
+
+    auto operator=(string_pool const&) -> string_pool& = delete;
+
+    /** @brief returns the identifier of text, storing it if it's new */
+    auto intern(std::string_view text) -> identifier;
+
+    auto name(identifier name) const -> std::string_view { return this->names[name.id]; }
+
+    auto size() const -> std::size_t { return this->names.size(); }
+
+private:
+    static constexpr std::uint32_t empty_slot = 0;
+
+    static auto hash(std::string_view text) -> std::uint64_t;
+
+    auto rehash(std::size_t capacity) -> void;
+
+    arena                         characters { 16 * 1024 };
+    std::vector<std::string_view> names;
+    std::vector<std::uint64_t>    hashes; // by id, so growing never hashes a name twice
+    std::vector<std::uint32_t>    slots;  // open addressing, holds id + 1
+};
+
+}
+
+template <>
+struct std::hash<hcpsilva::identifier> {
+    auto operator()(hcpsilva::identifier const& name) const noexcept -> std::size_t { return name.id; }
+};
@@ -1,13 +1,37 @@
+/** @file symbol.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * The symbols declared so far, as a stack of scopes: the global one, then the
+ * parameters of a function, then each block nested in its body. Every scope is
+ * an open addressed table of its own, allocated from an arena as a stack, so
+ * closing a scope throws all of its symbols away at once by rewinding it.
+ */
+
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <location.hh>
-#include <string>
-#include <unordered_map>
+#include <vector>
 
+#include "arena.hh"
+#include "bindings.hh"
 #include "lexic_values.hh"
+#include "string_pool.hh"
 
 namespace hcpsilva {
+
 enum class symbol_kinds {
     VARIABLE,
     ARRAY,
@@ -19,8 +43,77 @@ struct symbol {
     symbol_kinds kind;
     types        type;
     size_t       size;
+    variable_ref variable; // what it is in program_bindings, for functions their number
 };
 
-using symbol_hash_table = std::unordered_map<std::string, symbol>;
+/** @brief bytes taken by a single value of type */
+constexpr auto type_size(types type) -> std::size_t
+{
+    switch (type) {
+    case types::INT:
+        return 4;
+    case types::FLOAT:
+        return 8;
+    case types::CHAR:
+    case types::BOOL:
+        return 1;
+    }
+
+    return 0;
+}
+
+class symbol_table {
+public:
+    /** @brief starts with the global scope open, and nothing else */
+    symbol_table();
+
+    symbol_table(symbol_table const&) = delete;
+
+    auto operator=(symbol_table const&) -> symbol_table& = delete;
+
+    /** @brief opens a scope inside the current one */
+    auto enter() -> void;
+
+    /** @brief closes the current scope, dropping everything declared in it.
+     * the global scope is never closed */
+    auto leave() -> void;
+
+    /** @brief declares name in the current scope, unless it's there already.
+     * in which case nothing changes and the symbol that was there is returned */
+    auto declare(identifier name, symbol const& value) -> symbol const*;
+
+    /** @brief the symbol name refers to, from the current scope outwards */
+    auto find(identifier name) const -> symbol const*;
+
+    /** @brief how many scopes are open, the global one included */
+    auto depth() const -> std::size_t { return this->scopes.size(); }
+
+    /** @brief back to an empty global scope */
+    auto clear() -> void;
+
+private:
+    struct entry {
+        std::uint32_t key; // id + 1, 0 for free slots
+        symbol        value;
+    };
+
+    struct scope {
+        entry*        slots    = nullptr; // allocated on the first declaration
+        std::uint32_t capacity = 0;       // a power of two
+        std::uint32_t count    = 0;
+        arena::marker mark;               // where the arena was when it opened
+    };
+
+    static auto slot_of(identifier name, std::uint32_t capacity) -> std::uint32_t;
+
+    auto grow(scope& current) -> void;
+
+    arena              storage;
+    std::vector<scope> scopes;
+
+    // the scopes holding anything, innermost last, so looking a name up skips
+    // over empty blocks no matter how deeply they nest
+    std::vector<std::uint32_t> populated;
+};
 
 }
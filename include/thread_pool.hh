@@ -0,0 +1,86 @@
+/** @file thread_pool.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * A fixed set of worker threads, each with a queue of its own. Workers take
+ * their most recent task first and, once out of work, steal the oldest ones
+ * from the other queues, so uneven tasks still keep every thread busy. Tasks
+ * get the index of the worker running them, which lets callers keep state per
+ * worker (a driver, for instance) without any locking.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace hcpsilva {
+
+class thread_pool {
+public:
+    using task = std::function<void(std::size_t worker)>;
+
+    /** @brief starts the given number of workers, or one per hardware thread
+     * when given 0 */
+    explicit thread_pool(std::size_t threads = 0);
+
+    thread_pool(thread_pool const&) = delete;
+
+    auto operator=(thread_pool const&) -> thread_pool& = delete;
+
+    /** @brief waits for every task before stopping the workers */
+    ~thread_pool();
+
+    /** @brief queues a task. from within a worker it goes to that worker's own
+     * queue, otherwise the queues are taken in turns */
+    auto submit(task work) -> void;
+
+    /** @brief blocks until every task submitted so far has run. rethrows the
+     * first exception that escaped from any of them */
+    auto wait() -> void;
+
+    auto size() const -> std::size_t { return this->workers.size(); }
+
+private:
+    struct queue {
+        std::mutex       lock;
+        std::deque<task> tasks;
+    };
+
+    auto run(std::size_t index) -> void;
+
+    auto take(std::size_t index) -> std::optional<task>;
+
+    std::vector<std::unique_ptr<queue>> queues;
+    std::vector<std::thread>            workers;
+
+    // guards everything below, which is only touched once per task
+    std::mutex              state_lock;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    std::size_t             queued     = 0;
+    std::size_t             unfinished = 0;
+    std::size_t             next_queue = 0;
+    std::exception_ptr      failure;
+    bool                    stopping = false;
+};
+
+}
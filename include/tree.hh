@@ -14,10 +14,13 @@
 #pragma once
 
 #include <concepts>
+#include <cstddef>
+#include <cstdio>
 #include <functional>
-#include <memory>
-#include <optional>
+#include <iterator>
 #include <ranges>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <fmt/core.h>
@@ -25,147 +28,410 @@
 
 namespace hcpsilva {
 
+/** @brief an intrusive list of children, threaded through each node's sibling
+ * link. nodes are owned elsewhere (usually an arena), the list only links them */
+template <typename node>
+struct child_list {
+    node* first = nullptr;
+    node* last  = nullptr;
+
+    struct iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = node;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = node*;
+        using reference         = node&;
+
+        node* current = nullptr;
+
+        auto operator*() const -> node& { return *this->current; }
+        auto operator->() const -> node* { return this->current; }
+
+        auto operator++() -> iterator&
+        {
+            this->current = this->current->sibling;
+            return *this;
+        }
+
+        auto operator++(int) -> iterator
+        {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        auto operator==(iterator const& rhs) const -> bool = default;
+    };
+
+    auto begin() const -> iterator { return iterator { this->first }; }
+    auto end() const -> iterator { return iterator {}; }
+
+    auto empty() const -> bool { return this->first == nullptr; }
+
+    auto push_back(node* child) -> void
+    {
+        if (this->last != nullptr)
+            this->last->sibling = child;
+        else
+            this->first = child;
+
+        this->last = child;
+    }
+};
+
+/** @brief walks a tree depth first, each node before what hangs from it: its
+ * children in order and then its next (which is a child as far as walking is
+ * concerned). what's left to walk is kept in a stack of its own, so however
+ * long a chain or deep a nesting, the call stack stays put. the root's siblings
+ * aren't part of its tree */
+template <typename node>
+class preorder_iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = std::remove_const_t<node>;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = node*;
+    using reference         = node&;
+
+    preorder_iterator() = default;
+
+    explicit preorder_iterator(node* root)
+        : current { root, nullptr, 0 }
+    {
+    }
+
+    auto operator*() const -> node& { return *this->current.self; }
+    auto operator->() const -> node* { return this->current.self; }
+
+    /** @brief the node the current one hangs from, nullptr for the root */
+    auto parent() const -> node* { return this->current.parent; }
+
+    /** @brief how far the current node is from the root, next links included */
+    auto depth() const -> std::size_t { return this->current.depth; }
+
+    auto operator++() -> preorder_iterator&
+    {
+        auto const self = this->current.self;
+
+        // the sibling comes after everything under this node, and its next
+        // after everything under its children
+        if (this->current.parent != nullptr && this->current.parent->next != self && self->sibling != nullptr)
+            this->pending.push_back({ self->sibling, this->current.parent, this->current.depth });
+
+        if (self->next != nullptr)
+            this->pending.push_back({ self->next, self, this->current.depth + 1 });
+
+        if (self->children.first != nullptr) {
+            this->current = { self->children.first, self, this->current.depth + 1 };
+        } else if (!this->pending.empty()) {
+            this->current = this->pending.back();
+            this->pending.pop_back();
+        } else {
+            this->current = {};
+        }
+
+        return *this;
+    }
+
+    auto operator++(int) -> preorder_iterator
+    {
+        auto previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    auto operator==(preorder_iterator const& rhs) const -> bool { return this->current.self == rhs.current.self; }
+
+private:
+    struct entry {
+        node*       self   = nullptr;
+        node*       parent = nullptr;
+        std::size_t depth  = 0;
+    };
+
+    entry              current;
+    std::vector<entry> pending;
+};
+
+/** @brief walks a tree depth first, each node after what hangs from it (in the
+ * same order as above). the path from the root is kept in a stack of its own */
+template <typename node>
+class postorder_iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = std::remove_const_t<node>;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = node*;
+    using reference         = node&;
+
+    postorder_iterator() = default;
+
+    explicit postorder_iterator(node* root)
+    {
+        if (root != nullptr)
+            this->descend(root);
+    }
+
+    auto operator*() const -> node& { return *this->path.back(); }
+    auto operator->() const -> node* { return this->path.back(); }
+
+    /** @brief the node the current one hangs from, nullptr for the root */
+    auto parent() const -> node* { return this->path.size() > 1 ? this->path[this->path.size() - 2] : nullptr; }
+
+    auto operator++() -> postorder_iterator&
+    {
+        auto const done = this->path.back();
+
+        this->path.pop_back();
+
+        if (this->path.empty())
+            return *this;
+
+        auto const parent = this->path.back();
+
+        // the next link is the last thing hanging from a node
+        auto const following = done == parent->next ? nullptr : done->sibling != nullptr ? done->sibling : parent->next;
+
+        if (following != nullptr)
+            this->descend(following);
+
+        return *this;
+    }
+
+    auto operator++(int) -> postorder_iterator
+    {
+        auto previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    auto operator==(postorder_iterator const& rhs) const -> bool
+    {
+        auto const self  = this->path.empty() ? nullptr : this->path.back();
+        auto const other = rhs.path.empty() ? nullptr : rhs.path.back();
+
+        return self == other;
+    }
+
+private:
+    auto descend(node* from) -> void
+    {
+        for (; from != nullptr; from = from->children.first != nullptr ? from->children.first : from->next)
+            this->path.push_back(from);
+    }
+
+    std::vector<node*> path;
+};
+
+/** @brief a tree as a range, walked by either of the iterators above */
+template <typename iterator>
+class walk_view : public std::ranges::view_interface<walk_view<iterator>> {
+public:
+    walk_view() = default;
+
+    explicit walk_view(typename iterator::pointer root)
+        : root(root)
+    {
+    }
+
+    auto begin() const -> iterator { return iterator(this->root); }
+    auto end() const -> iterator { return iterator(); }
+
+private:
+    typename iterator::pointer root = nullptr;
+};
+
+template <typename node>
+using preorder_view = walk_view<preorder_iterator<node>>;
+
+template <typename node>
+using postorder_view = walk_view<postorder_iterator<node>>;
+
 template <typename T>
 struct tree_node {
-    T                             value;
-    std::vector<tree_node<T>>     children;
-    std::shared_ptr<tree_node<T>> next = nullptr; // a child, but special (i.e. a hack)
-
-    auto add_child(tree_node<T> const& child) -> void;
+    T                        value;
+    child_list<tree_node<T>> children;
+    tree_node<T>*            sibling = nullptr; // link to the next child of the same parent
+    tree_node<T>*            next    = nullptr; // a child, but special (i.e. a hack)
 
-    auto add_child(tree_node<T>&& child) -> void;
+    auto add_child(tree_node<T>* child) -> void;
 
-    template <std::same_as<tree_node<T>>... nodes>
-    auto add_children(nodes&&... children) -> void
+    template <std::same_as<tree_node<T>*>... nodes>
+    auto add_children(nodes... children) -> void
     {
-        this->children.reserve(sizeof...(nodes));
-        (this->children.push_back(std::forward<nodes>(children)), ...);
+        (this->add_child(children), ...);
     }
 
-    auto append_next(tree_node<T> const& child) -> void;
+    auto append_next(tree_node<T>* child) -> void;
 
-    auto append_next(tree_node<T>&& child) -> void;
+    /** @brief the tree under this node, see preorder_iterator */
+    auto preorder() -> preorder_view<tree_node<T>> { return preorder_view<tree_node<T>>(this); }
+    auto preorder() const -> preorder_view<tree_node<T> const> { return preorder_view<tree_node<T> const>(this); }
 
-    auto print() const -> void;
+    /** @brief the tree under this node, see postorder_iterator */
+    auto postorder() -> postorder_view<tree_node<T>> { return postorder_view<tree_node<T>>(this); }
+    auto postorder() const -> postorder_view<tree_node<T> const> { return postorder_view<tree_node<T> const>(this); }
 
-    auto print_edges() const -> void;
+    /** @brief prints the nodes of the tree to out, label maps a value to
+     * what is printed for it (by default, the value itself) */
+    template <typename projection = std::identity>
+    auto print(projection label = {}, std::FILE* out = stdout) const -> void;
 
-    auto apply(std::function<void(T const&)>) const -> void;
+    auto print_edges(std::FILE* out = stdout) const -> void;
 
-    auto map(std::function<T(T const&)>) const -> tree_node<T>;
+    /** @brief calls func with the value of every node, in preorder */
+    template <std::invocable<T const&> function>
+    auto apply(function&& func) const -> void;
 
-    consteval tree_node() noexcept = default;
+    /** @brief a copy of the tree with func applied to every value, its nodes
+     * made by storage (e.g. an arena) */
+    template <std::invocable<T const&> function, typename allocator>
+    auto map(function&& func, allocator& storage) const -> tree_node<std::invoke_result_t<function&, T const&>>*;
 
     constexpr tree_node(T const& in_value)
         : value(in_value)
-        , children()
     {
     }
 
-    constexpr tree_node(tree_node<T> const& in_node) noexcept = default;
-
-    constexpr tree_node(tree_node<T>&& in_node) noexcept = default;
+    constexpr tree_node(T&& in_value)
+        : value(std::move(in_value))
+    {
+    }
 
-    template <std::same_as<tree_node<T>>... nodes>
-    tree_node(T const& value, nodes&&... children) noexcept
+    template <std::same_as<tree_node<T>*>... nodes>
+    tree_node(T const& value, nodes... children)
         : value(value)
-        , children { std::forward<nodes>(children)... }
     {
+        this->add_children(children...);
     }
 
-    template <std::same_as<tree_node<T>>... nodes>
-    tree_node(T&& value, nodes&&... children) noexcept
+    template <std::same_as<tree_node<T>*>... nodes>
+    tree_node(T&& value, nodes... children)
         : value(std::move(value))
-        , children { std::forward<nodes>(children)... }
     {
+        this->add_children(children...);
     }
 
-    auto operator=(tree_node<T> const& rhs) -> tree_node<T>& = default;
+    // nodes are linked by address, so copying one would only alias its subtree
+    tree_node(tree_node<T> const& in_node) = delete;
 
-    auto operator=(tree_node<T>&& rhs) -> tree_node<T>& = default;
+    auto operator=(tree_node<T> const& rhs) -> tree_node<T>& = delete;
 
     auto operator<=>(tree_node<T> const& rhs) const { return this->value <=> rhs.value; }
 };
 
 template <typename T>
-auto tree_node<T>::add_child(tree_node<T> const& child) -> void
+auto tree_node<T>::add_child(tree_node<T>* child) -> void
 {
-    this->children.emplace_back(child);
+    this->children.push_back(child);
 }
 
 template <typename T>
-auto tree_node<T>::add_child(tree_node<T>&& child) -> void
+auto tree_node<T>::append_next(tree_node<T>* child) -> void
 {
-    this->children.emplace_back(std::move(child));
+    auto tail = this;
+
+    while (tail->next != nullptr)
+        tail = tail->next;
+
+    tail->next = child;
 }
 
+/** @brief builds a chain of nodes linked through next. it remembers the tail
+ * of the chain, so appending doesn't walk it from the head every time */
 template <typename T>
-auto tree_node<T>::append_next(tree_node<T> const& child) -> void
-{
-    if (this->next != nullptr) {
-        next->append_next(child);
-    } else {
-        next = std::make_shared<tree_node<T>>(child);
+struct tree_chain {
+    tree_node<T>* head = nullptr;
+    tree_node<T>* tail = nullptr;
+
+    auto append(tree_node<T>* node) -> void
+    {
+        if (node == nullptr)
+            return;
+
+        if (this->tail != nullptr)
+            this->tail->next = node;
+        else
+            this->head = node;
+
+        // the node may bring a chain of its own along (e.g. a nested block),
+        // each of those is walked only once since the tail never moves back
+        for (this->tail = node; this->tail->next != nullptr;)
+            this->tail = this->tail->next;
     }
+};
+
+/** @brief calls visit with every node under root, each before its children */
+template <typename node, std::invocable<node&> visitor>
+auto visit_preorder(node& root, visitor&& visit) -> void
+{
+    for (auto& each : root.preorder())
+        visit(each);
 }
 
-template <typename T>
-auto tree_node<T>::append_next(tree_node<T>&& child) -> void
+/** @brief calls visit with every node under root, each after its children */
+template <typename node, std::invocable<node&> visitor>
+auto visit_postorder(node& root, visitor&& visit) -> void
 {
-    if (this->next != nullptr) {
-        next->append_next(std::move(child));
-    } else {
-        next = std::make_shared<tree_node<T>>(std::move(child));
-    }
+    for (auto& each : root.postorder())
+        visit(each);
 }
 
 template <typename T>
-auto tree_node<T>::print() const -> void
+template <typename projection>
+auto tree_node<T>::print(projection label, std::FILE* out) const -> void
 {
-    fmt::print("{} [label=\"{}\"]\n", fmt::ptr(this), this->value);
-
-    for (auto const& child : this->children)
-        child.print();
-
-    if (this->next != nullptr)
-        this->next->print();
+    for (auto const& node : this->preorder())
+        fmt::print(out, "{} [label=\"{}\"]\n", fmt::ptr(&node), label(node.value));
 }
 
 template <typename T>
-auto tree_node<T>::print_edges() const -> void
+auto tree_node<T>::print_edges(std::FILE* out) const -> void
 {
-    constexpr auto edge_print = [](tree_node<T> const* from, tree_node<T> const* to) {
-        fmt::print("{}, {}\n", fmt::ptr(from), fmt::ptr(to));
-    };
-
-    for (auto const& child : this->children) {
-        edge_print(this, &child);
+    auto const nodes = this->preorder();
 
-        child.print_edges();
-    }
-
-    if (this->next != nullptr) {
-        edge_print(this, this->next.get());
-
-        this->next->print_edges();
+    // every node but the root is reached through an edge from its parent
+    for (auto node = nodes.begin(); node != nodes.end(); ++node) {
+        if (node.parent() != nullptr)
+            fmt::print(out, "{}, {}\n", fmt::ptr(node.parent()), fmt::ptr(&*node));
     }
 }
 
 template <typename T>
-auto tree_node<T>::apply(std::function<void(T const&)> func) const -> void
+template <std::invocable<T const&> function>
+auto tree_node<T>::apply(function&& func) const -> void
 {
-    func(this->value);
-
-    for (auto const& child : this->children)
-        child.apply(func);
+    for (auto const& node : this->preorder())
+        func(node.value);
 }
 
 template <typename T>
-auto tree_node<T>::map(std::function<T(T const&)> func) const -> tree_node<T>
+template <std::invocable<T const&> function, typename allocator>
+auto tree_node<T>::map(function&& func, allocator& storage) const -> tree_node<std::invoke_result_t<function&, T const&>>*
 {
-    auto children_set = this->children | std::views::transform(std::bind(&tree_node<T>::map, func));
+    using mapped = tree_node<std::invoke_result_t<function&, T const&>>;
+
+    auto const nodes = this->preorder();
+
+    // the copies of the nodes from the root down to the current one
+    std::vector<mapped*> path;
+
+    for (auto node = nodes.begin(); node != nodes.end(); ++node) {
+        auto const copy = storage.template make<mapped>(func(node->value));
+
+        path.resize(node.depth());
+
+        if (!path.empty()) {
+            if (node.parent()->next == &*node)
+                path.back()->next = copy;
+            else
+                path.back()->add_child(copy);
+        }
+
+        path.push_back(copy);
+    }
 
-    return tree_node<T>(func(this->value), children_set);
+    return path.empty() ? nullptr : path.front();
 }
 
 }
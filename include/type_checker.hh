@@ -0,0 +1,145 @@
+/** @file type_checker.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Types every expression of a function, once the whole source is parsed, in a
+ * single bottom up walk over its tree. Each node is left with the type of what it
+ * computes (see ast_value), and wherever a value is taken as another type
+ * with a different representation (ints and floats, either way) a node of its
+ * own is put in between, its value the type converted to. Names were typed
+ * while parsing, with their scopes still around, so all that's left is to
+ * look the operators up in the tables below:
+ *
+ *  - arithmetic brings both sides to their common type: a float if either is
+ *    one, an int otherwise, bools taken as ints
+ *  - the rest takes ints, comparisons take their common type giving a bool,
+ *    and logical operators (and conditions) take anything but a char as it
+ *    is, a float being true if not zero
+ *  - assignments, returns and arguments convert to the type of what they go
+ *    to, indices to int
+ *
+ * Chars never mix with anything else, so they are compared only among
+ * themselves. Those, calls with the wrong number of arguments and arrays
+ * indexed with the wrong number of dimensions are semantic errors.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <magic_enum.hpp>
+
+#include "arena.hh"
+#include "ast.hh"
+#include "bindings.hh"
+#include "lexic_values.hh"
+#include "string_pool.hh"
+#include "symbol.hh"
+
+namespace hcpsilva {
+
+/** @brief what taking a value of a type as another takes */
+enum class conversion : std::uint8_t {
+    NONE,    // the same representation, nothing at all
+    NODE,    // a node converting it
+    INVALID, // a semantic error
+};
+
+/** @brief what an operator does with the types of its operands */
+enum class operand_rule : std::uint8_t {
+    NONE,       // not an expression, typed apart
+    ARITHMETIC, // brought to their common type, which is the result
+    INTEGER,    // brought to int, which is the result
+    ORDER,      // brought to their common type, the result a bool
+    TRUTH,      // taken as bools, as they are, the result a bool
+};
+
+inline constexpr auto type_count = magic_enum::enum_count<types>();
+
+/** @brief by the type converted from, then the one converted to */
+inline constexpr std::array<std::array<conversion, type_count>, type_count> conversions { {
+    // int                 float             char                  bool
+    { { conversion::NONE, conversion::NODE, conversion::INVALID, conversion::NONE } },
+    { { conversion::NODE, conversion::NONE, conversion::INVALID, conversion::NODE } },
+    { { conversion::INVALID, conversion::INVALID, conversion::NONE, conversion::INVALID } },
+    { { conversion::NONE, conversion::NODE, conversion::INVALID, conversion::NONE } },
+} };
+
+/** @brief the type two operands meet at, by the type of each, if any */
+inline constexpr std::array<std::array<std::optional<types>, type_count>, type_count> common_types { {
+    // int           float         char          bool
+    { { types::INT, types::FLOAT, std::nullopt, types::INT } },
+    { { types::FLOAT, types::FLOAT, std::nullopt, types::FLOAT } },
+    { { std::nullopt, std::nullopt, types::CHAR, std::nullopt } },
+    { { types::INT, types::FLOAT, std::nullopt, types::INT } },
+} };
+
+/** @brief by operator, in the order of operations */
+inline constexpr std::array<operand_rule, magic_enum::enum_count<operations>()> operand_rules { {
+    operand_rule::NONE,       // =
+    operand_rule::NONE,       // <=, initializing
+    operand_rule::ARITHMETIC, // /
+    operand_rule::ARITHMETIC, // *
+    operand_rule::INTEGER,    // %
+    operand_rule::ORDER,      // <
+    operand_rule::ORDER,      // >
+    operand_rule::ORDER,      // <=
+    operand_rule::ORDER,      // >=
+    operand_rule::ORDER,      // ==
+    operand_rule::ORDER,      // !=
+    operand_rule::TRUTH,      // &&
+    operand_rule::TRUTH,      // ||
+    operand_rule::TRUTH,      // !
+    operand_rule::ARITHMETIC, // +
+    operand_rule::ARITHMETIC, // -, unary as well
+    operand_rule::NONE,       // []
+    operand_rule::NONE,       // ^
+} };
+
+class type_checker {
+public:
+    /** @brief names are looked up in symbols and bindings, with nothing but
+     * the global scope open, and conversions are built out of storage */
+    type_checker(arena& storage, string_pool const& strings, symbol_table const& symbols, program_bindings const& bindings);
+
+    /** @brief types the tree of a function (its names already typed) in
+     * place, throwing yy::parser::syntax_error at the first semantic error.
+     * only the function itself is written to, so functions of the same
+     * program may be checked at once, each with a storage of its own */
+    auto check(ast_node& function) -> void;
+
+    /** @brief how many nodes were added, converting values */
+    auto added() const -> std::size_t { return this->added_nodes; }
+
+private:
+    auto check_operation(ast_node& node, operations op) -> void;
+    auto check_index(ast_node& node) -> void;
+    auto check_call(ast_node& node, identifier callee) -> void;
+    auto check_keyword(ast_node& node, keywords keyword) -> void;
+
+    /** @brief converts the operand link points to (a link of parent, or of
+     * the argument before it) to type, in place */
+    auto convert(ast_node& parent, ast_node*& link, types type) -> void;
+
+    arena&                  storage;
+    string_pool const&      strings;
+    symbol_table const&     symbols;
+    program_bindings const& bindings;
+    types                   returned    = types::INT; // by the function being checked
+    std::size_t             added_nodes = 0;
+};
+
+}
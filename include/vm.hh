@@ -0,0 +1,61 @@
+/** @file vm.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Runs bytecode (see bytecode.hh) on registers. Before running, the code is
+ * threaded: each opcode is replaced by the address of the code handling it, so
+ * going from an instruction to the next is a single indirect jump (a computed
+ * goto, of GNU C) with nothing to look up in between.
+ *
+ * Each call gets a frame of its own on a stack of registers, the arguments
+ * copied in as its first ones and the rest zeroed. Reading and writing memory
+ * out of its bounds, dividing by zero and calling too deep are errors, and so
+ * is input that isn't a number. Floats are single precision words, as in
+ * iloc.hh.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+#include "bytecode.hh"
+
+namespace hcpsilva {
+
+class virtual_machine {
+public:
+    explicit virtual_machine(bytecode_program program);
+
+    /** @brief calls the function named entry, with no arguments, and gives
+     * what it returns. the globals start zeroed on each run, input is read
+     * from in and output written to out, a number per line. complains (with
+     * std::runtime_error) about whatever goes wrong while running */
+    auto run(std::string_view entry = "main", std::FILE* in = stdin, std::FILE* out = stdout) -> std::int32_t;
+
+    /** @brief deepest calls may nest */
+    static constexpr std::size_t max_depth = 1 << 20;
+
+private:
+    // the bytecode with the addresses of the handlers in place of the opcodes
+    auto thread(void* const* handlers) -> void;
+
+    bytecode_program          program;
+    std::vector<std::intptr_t> threaded;
+    std::vector<std::int32_t> memory;
+    std::vector<std::int32_t> registers;
+};
+
+}
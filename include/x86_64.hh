@@ -0,0 +1,45 @@
+/** @file x86_64.hh
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Translates the code of iloc.hh into x86-64 assembly, in the syntax of the
+ * GNU assembler, to be linked against the C library:
+ *
+ *     stage-7 < program.txt > program.s && cc program.s -o program
+ *
+ * Each virtual register gets a slot of its own in the frame of its function,
+ * and each instruction loads its operands from their slots, working on them in
+ * eax (or xmm0, for floats) and storing the result back. The globals are a
+ * single array of words in .bss, and input and output go through scanf and
+ * printf, a number per line.
+ *
+ * Functions follow the System V ABI, every value being a 32 bit word: the
+ * first six arguments go in edi, esi, edx, ecx, r8d and r9d, the rest on the
+ * stack, and the result comes back in eax. Floats travel as their bits, the
+ * same as in the registers of the code. The function main of the program is
+ * the main of C, and what it returns is the exit status.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+#include "iloc.hh"
+
+namespace hcpsilva {
+
+/** @brief writes program out as assembly, complaining (with
+ * std::runtime_error) if it has no main function */
+auto print_x86_64(iloc_program const& program, std::FILE* out = stdout) -> void;
+
+}
@@ -0,0 +1,286 @@
+/** @file bytecode.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "bytecode.hh"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace hcpsilva {
+
+namespace {
+
+    // the operations over two registers are packed by their distance to ADD
+    static_assert(static_cast<int>(opcode::FCMP_NE) - static_cast<int>(opcode::ADD)
+        == static_cast<int>(bytecode_op::FCMP_NE) - static_cast<int>(bytecode_op::ADD));
+
+    class packer {
+    public:
+        explicit packer(iloc_program const& program)
+            : program(program)
+        {
+        }
+
+        auto pack() -> bytecode_program
+        {
+            this->result.memory = this->program.globals;
+
+            for (auto const& function : this->program.functions)
+                this->pack_function(function);
+
+            return std::move(this->result);
+        }
+
+    private:
+        template <typename... arguments>
+        [[noreturn]] auto fail(fmt::format_string<arguments...> format, arguments&&... values) const -> void
+        {
+            throw std::runtime_error(fmt::format("bytecode error, function \"{}\": {}\n", this->current->name,
+                fmt::format(format, std::forward<arguments>(values)...)));
+        }
+
+        auto pack_function(iloc_function const& function) -> void
+        {
+            this->current = &function;
+
+            this->result.functions.push_back({ function.name, function.parameters, used_registers(function),
+                static_cast<std::uint32_t>(this->result.code.size()) });
+
+            this->labels.assign(function.labels, -1);
+            this->jumps.clear();
+
+            auto ends = false;
+
+            for (auto const& code : function.code) {
+                if (code.op == opcode::NOP)
+                    continue;
+
+                if (code.op == opcode::LABEL) {
+                    this->labels[static_cast<std::size_t>(code.a)] = static_cast<std::int32_t>(this->result.code.size());
+                    ends = false;
+                    continue;
+                }
+
+                this->pack_instruction(code);
+
+                ends = code.op == opcode::RET || code.op == opcode::JUMPI;
+            }
+
+            // the code of the next function is right after it
+            if (!ends)
+                this->fail("runs off its end, which must be a ret or a jumpI");
+
+            for (auto const where : this->jumps) {
+                auto& target = this->result.code[where];
+
+                if (target < 0 || static_cast<std::size_t>(target) >= this->labels.size()
+                    || this->labels[static_cast<std::size_t>(target)] < 0)
+                    this->fail("jumps to L{}, which is nowhere", target);
+
+                target = this->labels[static_cast<std::size_t>(target)];
+            }
+        }
+
+        auto pack_instruction(instruction const& code) -> void
+        {
+            switch (code.op) {
+            case opcode::ADD:
+            case opcode::SUB:
+            case opcode::MULT:
+            case opcode::DIV:
+            case opcode::MOD:
+            case opcode::CMP_LT:
+            case opcode::CMP_LE:
+            case opcode::CMP_EQ:
+            case opcode::CMP_GE:
+            case opcode::CMP_GT:
+            case opcode::CMP_NE:
+            case opcode::FADD:
+            case opcode::FSUB:
+            case opcode::FMULT:
+            case opcode::FDIV:
+            case opcode::FCMP_LT:
+            case opcode::FCMP_LE:
+            case opcode::FCMP_EQ:
+            case opcode::FCMP_GE:
+            case opcode::FCMP_GT:
+            case opcode::FCMP_NE:
+                // these are laid out in the same order in both
+                this->emit(static_cast<bytecode_op>(static_cast<int>(bytecode_op::ADD) + static_cast<int>(code.op)
+                               - static_cast<int>(opcode::ADD)),
+                    this->reg(code.a), this->reg(code.b), this->reg(code.c));
+                break;
+            case opcode::ADDI:
+                this->emit(bytecode_op::ADDI, this->reg(code.a), code.b, this->reg(code.c));
+                break;
+            case opcode::MULTI:
+                this->emit(bytecode_op::MULTI, this->reg(code.a), code.b, this->reg(code.c));
+                break;
+            case opcode::RSUBI:
+                this->emit(bytecode_op::RSUBI, this->reg(code.a), code.b, this->reg(code.c));
+                break;
+            case opcode::LOADI:
+            case opcode::LOADF:
+                this->emit(bytecode_op::LOADI, code.a, this->reg(code.c));
+                break;
+            case opcode::I2I:
+                this->emit(bytecode_op::MOVE, this->reg(code.a), this->reg(code.c));
+                break;
+            case opcode::I2F:
+                this->emit(bytecode_op::I2F, this->reg(code.a), this->reg(code.c));
+                break;
+            case opcode::F2I:
+                this->emit(bytecode_op::F2I, this->reg(code.a), this->reg(code.c));
+                break;
+            case opcode::LOADAI:
+                this->base(code.a);
+                this->emit(bytecode_op::LOAD, this->address(code.b), this->reg(code.c));
+                break;
+            case opcode::LOADAO:
+                this->base(code.a);
+                this->emit(bytecode_op::LOADX, this->reg(code.b), this->reg(code.c));
+                break;
+            case opcode::STOREAI:
+                this->base(code.a);
+                this->emit(bytecode_op::STORE, this->reg(code.c), this->address(code.b));
+                break;
+            case opcode::STOREAO:
+                this->base(code.a);
+                this->emit(bytecode_op::STOREX, this->reg(code.c), this->reg(code.b));
+                break;
+            case opcode::JUMPI:
+                this->emit(bytecode_op::JUMP, code.a);
+                this->jump_at(1);
+                break;
+            case opcode::CBR:
+                this->emit(bytecode_op::BRANCH, this->reg(code.a), code.b, code.c);
+                this->jump_at(2);
+                this->jump_at(1);
+                break;
+            case opcode::CALL:
+                this->pack_call(code);
+                break;
+            case opcode::RET:
+                this->emit(bytecode_op::RET, this->reg(code.a));
+                break;
+            case opcode::INPUT:
+                this->emit(bytecode_op::INPUT, this->reg(code.c));
+                break;
+            case opcode::OUTPUT:
+                this->emit(bytecode_op::OUTPUT, this->reg(code.a));
+                break;
+            case opcode::FINPUT:
+                this->emit(bytecode_op::FINPUT, this->reg(code.c));
+                break;
+            case opcode::FOUTPUT:
+                this->emit(bytecode_op::FOUTPUT, this->reg(code.a));
+                break;
+            case opcode::NOP:
+            case opcode::LABEL:
+                break;
+            }
+        }
+
+        auto pack_call(instruction const& code) -> void
+        {
+            auto const& arguments = this->current->arguments;
+            auto const& callee    = this->program.functions[static_cast<std::size_t>(code.a)];
+            auto const  count     = arguments[static_cast<std::size_t>(code.b)];
+
+            if (static_cast<std::uint32_t>(count) != callee.parameters)
+                this->fail("calls \"{}\" with {} arguments, but it takes {}", callee.name, count, callee.parameters);
+
+            this->emit(bytecode_op::CALL, code.a, this->reg(code.c), count);
+
+            for (std::int32_t i = 1; i <= count; ++i)
+                this->result.code.push_back(this->reg(arguments[static_cast<std::size_t>(code.b + i)]));
+        }
+
+        template <typename... operands>
+        auto emit(bytecode_op op, operands... values) -> void
+        {
+            this->result.code.push_back(static_cast<std::int32_t>(op));
+            (this->result.code.push_back(values), ...);
+        }
+
+        auto reg(std::int32_t number) const -> std::int32_t
+        {
+            if (number < 0)
+                this->fail("rbss can only be the base of a load or a store");
+
+            return number;
+        }
+
+        auto base(std::int32_t number) const -> void
+        {
+            if (number != rbss)
+                this->fail("memory can only be addressed from rbss, not r{}", number);
+        }
+
+        auto address(std::int32_t offset) const -> std::int32_t
+        {
+            if (offset < 0 || static_cast<std::uint32_t>(offset) >= this->program.globals)
+                this->fail("rbss + {} is outside of the {} words of globals", offset, this->program.globals);
+
+            return offset;
+        }
+
+        // the label emitted back from the end, resolved once the whole
+        // function is packed, as jumps may go forward
+        auto jump_at(std::size_t back) -> void
+        {
+            this->jumps.push_back(this->result.code.size() - back);
+        }
+
+        iloc_program const&       program;
+        iloc_function const*      current = nullptr;
+        bytecode_program          result;
+        std::vector<std::int32_t> labels;
+        std::vector<std::size_t>  jumps;
+    };
+
+}
+
+auto instruction_size(std::int32_t const* code) -> std::size_t
+{
+    switch (static_cast<bytecode_op>(code[0])) {
+    case bytecode_op::JUMP:
+    case bytecode_op::RET:
+    case bytecode_op::INPUT:
+    case bytecode_op::OUTPUT:
+    case bytecode_op::FINPUT:
+    case bytecode_op::FOUTPUT:
+        return 2;
+    case bytecode_op::LOADI:
+    case bytecode_op::MOVE:
+    case bytecode_op::I2F:
+    case bytecode_op::F2I:
+    case bytecode_op::LOAD:
+    case bytecode_op::LOADX:
+    case bytecode_op::STORE:
+    case bytecode_op::STOREX:
+        return 3;
+    case bytecode_op::CALL:
+        return 4 + static_cast<std::size_t>(code[3]);
+    default:
+        return 4;
+    }
+}
+
+auto compile_bytecode(iloc_program const& program) -> bytecode_program
+{
+    return packer(program).pack();
+}
+
+}
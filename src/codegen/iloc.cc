@@ -0,0 +1,467 @@
+/** @file iloc.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "iloc.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fmt/format.h>
+#include <magic_enum.hpp>
+
+namespace hcpsilva {
+
+namespace {
+
+    struct opcode_form {
+        std::string_view mnemonic;
+
+        // the operands in the order they are written, each a kind (Register,
+        // Constant, Float constant or Label) and the field it goes in, or an arrow (> for =>
+        // and - for ->). calls and labels are written apart
+        std::string_view operands;
+    };
+
+    constexpr std::array<opcode_form, magic_enum::enum_count<opcode>()> forms { {
+        { "nop", "" },
+        { "add", "RaRb>Rc" },
+        { "sub", "RaRb>Rc" },
+        { "mult", "RaRb>Rc" },
+        { "div", "RaRb>Rc" },
+        { "mod", "RaRb>Rc" },
+        { "cmp_LT", "RaRb>Rc" },
+        { "cmp_LE", "RaRb>Rc" },
+        { "cmp_EQ", "RaRb>Rc" },
+        { "cmp_GE", "RaRb>Rc" },
+        { "cmp_GT", "RaRb>Rc" },
+        { "cmp_NE", "RaRb>Rc" },
+        { "fadd", "RaRb>Rc" },
+        { "fsub", "RaRb>Rc" },
+        { "fmult", "RaRb>Rc" },
+        { "fdiv", "RaRb>Rc" },
+        { "fcmp_LT", "RaRb>Rc" },
+        { "fcmp_LE", "RaRb>Rc" },
+        { "fcmp_EQ", "RaRb>Rc" },
+        { "fcmp_GE", "RaRb>Rc" },
+        { "fcmp_GT", "RaRb>Rc" },
+        { "fcmp_NE", "RaRb>Rc" },
+        { "addI", "RaCb>Rc" },
+        { "multI", "RaCb>Rc" },
+        { "rsubI", "RaCb>Rc" },
+        { "loadI", "Ca>Rc" },
+        { "loadF", "Fa>Rc" },
+        { "i2i", "Ra>Rc" },
+        { "i2f", "Ra>Rc" },
+        { "f2i", "Ra>Rc" },
+        { "loadAI", "RaCb>Rc" },
+        { "loadAO", "RaRb>Rc" },
+        { "storeAI", "Rc>RaCb" },
+        { "storeAO", "Rc>RaRb" },
+        { "jumpI", "-La" },
+        { "cbr", "Ra-LbLc" },
+        { "label", "" },
+        { "call", "" },
+        { "ret", "Ra" },
+        { "input", ">Rc" },
+        { "output", "Ra" },
+        { "finput", ">Rc" },
+        { "foutput", "Ra" },
+    } };
+
+    auto field(instruction& code, char name) -> std::int32_t&
+    {
+        return name == 'a' ? code.a : name == 'b' ? code.b : code.c;
+    }
+
+    auto field(instruction const& code, char name) -> std::int32_t
+    {
+        return name == 'a' ? code.a : name == 'b' ? code.b : code.c;
+    }
+
+    auto append_register(fmt::memory_buffer& buffer, std::int32_t number) -> void
+    {
+        if (number == rbss)
+            fmt::format_to(std::back_inserter(buffer), "rbss");
+        else
+            fmt::format_to(std::back_inserter(buffer), "r{}", number);
+    }
+
+    auto append_instruction(fmt::memory_buffer& buffer, iloc_program const& program, iloc_function const& function,
+        instruction const& code) -> void
+    {
+        auto const out = std::back_inserter(buffer);
+
+        if (code.op == opcode::LABEL) {
+            fmt::format_to(out, "L{}:\n", code.a);
+            return;
+        }
+
+        auto const& form = forms[static_cast<std::size_t>(code.op)];
+
+        fmt::format_to(out, "    {}", form.mnemonic);
+
+        if (code.op == opcode::CALL) {
+            fmt::format_to(out, " {}", program.functions[code.a].name);
+
+            auto const count = function.arguments[code.b];
+
+            for (std::int32_t i = 1; i <= count; ++i) {
+                fmt::format_to(out, ", ");
+                append_register(buffer, function.arguments[code.b + i]);
+            }
+
+            fmt::format_to(out, " => ");
+            append_register(buffer, code.c);
+            fmt::format_to(out, "\n");
+            return;
+        }
+
+        auto separator = " ";
+
+        for (std::size_t i = 0; i < form.operands.size(); i += 2) {
+            auto const kind = form.operands[i];
+
+            if (kind == '>' || kind == '-') {
+                fmt::format_to(out, "{}", kind == '>' ? " =>" : " ->");
+                separator = " ";
+                --i;
+                continue;
+            }
+
+            auto const value = field(code, form.operands[i + 1]);
+
+            fmt::format_to(out, "{}", separator);
+
+            if (kind == 'R')
+                append_register(buffer, value);
+            else if (kind == 'L')
+                fmt::format_to(out, "L{}", value);
+            else if (kind == 'F')
+                fmt::format_to(out, "{}", std::bit_cast<float>(value));
+            else
+                fmt::format_to(out, "{}", value);
+
+            separator = ", ";
+        }
+
+        fmt::format_to(out, "\n");
+    }
+
+    /** @brief the words of a line, commas and comments left out */
+    auto split_line(std::string_view line) -> std::vector<std::string_view>
+    {
+        if (auto const comment = line.find("//"); comment != std::string_view::npos)
+            line = line.substr(0, comment);
+
+        std::vector<std::string_view> words;
+
+        std::size_t begin = 0;
+
+        for (std::size_t i = 0; i <= line.size(); ++i) {
+            if (i == line.size() || line[i] == ' ' || line[i] == '\t' || line[i] == ',' || line[i] == '\r') {
+                if (i > begin)
+                    words.push_back(line.substr(begin, i - begin));
+
+                begin = i + 1;
+            }
+        }
+
+        return words;
+    }
+
+    auto number_of(std::string_view text) -> std::optional<std::int32_t>
+    {
+        std::int32_t value = 0;
+
+        auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+        if (error != std::errc {} || end != text.data() + text.size())
+            return std::nullopt;
+
+        return value;
+    }
+
+    class reader {
+    public:
+        auto read(std::string_view text) -> iloc_program
+        {
+            std::size_t begin = 0;
+
+            while (begin <= text.size()) {
+                auto end = text.find('\n', begin);
+
+                if (end == std::string_view::npos)
+                    end = text.size();
+
+                ++this->line;
+                this->read_line(split_line(text.substr(begin, end - begin)));
+
+                begin = end + 1;
+            }
+
+            if (this->current != nullptr)
+                this->fail("function \"{}\" has no end", this->current->name);
+
+            this->resolve_calls();
+
+            return std::move(this->program);
+        }
+
+    private:
+        template <typename... arguments>
+        [[noreturn]] auto fail(fmt::format_string<arguments...> format, arguments&&... values) const -> void
+        {
+            throw std::runtime_error(fmt::format("iloc error, line {}: {}\n", this->line,
+                fmt::format(format, std::forward<arguments>(values)...)));
+        }
+
+        auto read_line(std::vector<std::string_view> const& words) -> void
+        {
+            if (words.empty())
+                return;
+
+            if (words[0] == "globals" && this->current == nullptr && words.size() == 2) {
+                this->program.globals = static_cast<std::uint32_t>(this->constant(words[1]));
+            } else if (words[0] == "function" && this->current == nullptr && words.size() == 3) {
+                this->current = &this->program.functions.emplace_back();
+
+                this->current->name       = words[1];
+                this->current->parameters = static_cast<std::uint32_t>(this->constant(words[2]));
+            } else if (this->current == nullptr) {
+                this->fail("\"{}\" outside of a function", words[0]);
+            } else if (words[0] == "end" && words.size() == 1) {
+                this->current->registers = used_registers(*this->current);
+                this->current = nullptr;
+            } else if (words.size() == 1 && words[0].size() > 1 && words[0].back() == ':') {
+                this->current->code.push_back({ opcode::LABEL, this->label(words[0].substr(0, words[0].size() - 1)) });
+            } else if (words[0] == "call") {
+                this->read_call(words);
+            } else {
+                this->read_instruction(words);
+            }
+        }
+
+        auto read_instruction(std::vector<std::string_view> const& words) -> void
+        {
+            auto const form = std::ranges::find(forms, words[0], &opcode_form::mnemonic);
+
+            if (form == forms.end() || form->mnemonic == "label")
+                this->fail("unknown instruction \"{}\"", words[0]);
+
+            instruction code { static_cast<opcode>(form - forms.begin()) };
+
+            std::size_t word = 1;
+
+            for (std::size_t i = 0; i < form->operands.size(); i += 2) {
+                auto const kind = form->operands[i];
+
+                if (word == words.size())
+                    this->fail("missing operands to \"{}\"", words[0]);
+
+                auto const text = words[word++];
+
+                if (kind == '>' || kind == '-') {
+                    if (text != (kind == '>' ? "=>" : "->"))
+                        this->fail("expected \"{}\", found \"{}\"", kind == '>' ? "=>" : "->", text);
+
+                    --i;
+                    continue;
+                }
+
+                auto& value = field(code, form->operands[i + 1]);
+
+                value = kind == 'R' ? this->reg(text)
+                    : kind == 'L'   ? this->label(text)
+                    : kind == 'F'   ? this->float_constant(text)
+                                    : this->constant(text);
+            }
+
+            if (word != words.size())
+                this->fail("too many operands to \"{}\"", words[0]);
+
+            this->current->code.push_back(code);
+        }
+
+        auto read_call(std::vector<std::string_view> const& words) -> void
+        {
+            if (words.size() < 4 || words[words.size() - 2] != "=>")
+                this->fail("malformed call");
+
+            auto& arguments = this->current->arguments;
+
+            instruction code { opcode::CALL, 0, static_cast<std::int32_t>(arguments.size()), this->reg(words.back()) };
+
+            arguments.push_back(static_cast<std::int32_t>(words.size() - 4));
+
+            for (std::size_t i = 2; i < words.size() - 2; ++i)
+                arguments.push_back(this->reg(words[i]));
+
+            this->calls.push_back({ this->program.functions.size() - 1, this->current->code.size(), words[1], this->line });
+            this->current->code.push_back(code);
+        }
+
+        auto resolve_calls() -> void
+        {
+            std::unordered_map<std::string_view, std::int32_t> numbers;
+
+            for (std::size_t i = 0; i < this->program.functions.size(); ++i)
+                numbers.emplace(this->program.functions[i].name, static_cast<std::int32_t>(i));
+
+            for (auto const& call : this->calls) {
+                auto const found = numbers.find(call.callee);
+
+                this->line = call.line;
+
+                if (found == numbers.end())
+                    this->fail("call to unknown function \"{}\"", call.callee);
+
+                this->program.functions[call.function].code[call.index].a = found->second;
+            }
+        }
+
+        auto reg(std::string_view text) -> std::int32_t
+        {
+            if (text == "rbss")
+                return rbss;
+
+            auto const number = text.starts_with('r') ? number_of(text.substr(1)) : std::nullopt;
+
+            if (!number || *number < 0)
+                this->fail("expected a register, found \"{}\"", text);
+
+            return *number;
+        }
+
+        auto label(std::string_view text) -> std::int32_t
+        {
+            auto const number = text.starts_with('L') ? number_of(text.substr(1)) : std::nullopt;
+
+            if (!number || *number < 0)
+                this->fail("expected a label, found \"{}\"", text);
+
+            this->current->labels = std::max(this->current->labels, static_cast<std::uint32_t>(*number) + 1);
+
+            return *number;
+        }
+
+        auto constant(std::string_view text) -> std::int32_t
+        {
+            auto const number = number_of(text);
+
+            if (!number)
+                this->fail("expected a number, found \"{}\"", text);
+
+            return *number;
+        }
+
+        // kept as its bits, which is what is loaded
+        auto float_constant(std::string_view text) -> std::int32_t
+        {
+            float value = 0;
+
+            auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+            if (error != std::errc {} || end != text.data() + text.size())
+                this->fail("expected a float, found \"{}\"", text);
+
+            return std::bit_cast<std::int32_t>(value);
+        }
+
+        struct pending_call {
+            std::size_t      function;
+            std::size_t      index;
+            std::string_view callee;
+            std::size_t      line;
+        };
+
+        iloc_program              program;
+        iloc_function*            current = nullptr;
+        std::vector<pending_call> calls;
+        std::size_t               line = 0;
+    };
+
+}
+
+auto mnemonic(opcode op) -> std::string_view
+{
+    return forms[static_cast<std::size_t>(op)].mnemonic;
+}
+
+auto used_registers(iloc_function const& function) -> std::uint32_t
+{
+    auto count = function.parameters;
+
+    auto const use = [&](std::int32_t number) {
+        if (number >= 0)
+            count = std::max(count, static_cast<std::uint32_t>(number) + 1);
+    };
+
+    for (auto const& code : function.code) {
+        if (code.op == opcode::CALL) {
+            use(code.c);
+            continue;
+        }
+
+        auto const& operands = forms[static_cast<std::size_t>(code.op)].operands;
+
+        for (std::size_t i = 0; i < operands.size(); ++i) {
+            if (operands[i] == 'R')
+                use(field(code, operands[++i]));
+        }
+    }
+
+    // and the arguments of the calls, kept apart
+    for (std::size_t i = 0; i < function.arguments.size(); i += static_cast<std::size_t>(function.arguments[i]) + 1) {
+        for (std::int32_t j = 1; j <= function.arguments[i]; ++j)
+            use(function.arguments[i + static_cast<std::size_t>(j)]);
+    }
+
+    return count;
+}
+
+auto print_iloc(iloc_program const& program, std::FILE* out) -> void
+{
+    fmt::memory_buffer buffer;
+
+    fmt::format_to(std::back_inserter(buffer), "globals {}\n", program.globals);
+
+    for (auto const& function : program.functions) {
+        fmt::format_to(std::back_inserter(buffer), "function {} {}\n", function.name, function.parameters);
+
+        for (auto const& code : function.code) {
+            append_instruction(buffer, program, function, code);
+
+            // written out a piece at a time, however long the program
+            if (buffer.size() > 1 << 16) {
+                std::fwrite(buffer.data(), 1, buffer.size(), out);
+                buffer.clear();
+            }
+        }
+
+        fmt::format_to(std::back_inserter(buffer), "end\n");
+    }
+
+    std::fwrite(buffer.data(), 1, buffer.size(), out);
+}
+
+auto read_iloc(std::string_view text) -> iloc_program
+{
+    return reader().read(text);
+}
+
+}
@@ -0,0 +1,768 @@
+/** @file iloc_generator.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "iloc_generator.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace hcpsilva {
+
+namespace {
+
+    // what's left to lower, each step taking the registers computed by the
+    // ones before it from the top of a stack of values
+    enum class step : std::uint8_t {
+        STATEMENT, // node, then the rest of its chain
+        VALUE,     // computes node, leaving its register on the stack
+        CONDITION, // branches to label code.a if node is true, to code.b if not
+        OPERATION, // node, its operands computed
+        CONVERT,   // to the type of node, its operand computed
+        LOAD,      // an element of an array, its indices computed
+        CALL,      // node, its arguments computed
+        BRANCH,    // to label code.a if the value is true, to code.b if not
+        ASSIGN,    // the value to node, its indices (if an array) computed after it
+        OUTPUT,
+        RETURN,
+        DISCARD,
+        EMIT, // code, as it is
+        PUSH, // register code.a, holding a float if code.b
+    };
+
+    struct task {
+        step            kind;
+        ast_node const* node = nullptr;
+        instruction     code = {};
+    };
+
+    // a register computed, and whether it holds a float
+    struct operand {
+        std::int32_t reg;
+        bool         real = false;
+    };
+
+    struct constant {
+        std::int32_t bits;
+        bool         real = false;
+    };
+
+    auto opcode_of(operations op, bool real) -> opcode
+    {
+        switch (op) {
+        case operations::DIVISION:
+            return real ? opcode::FDIV : opcode::DIV;
+        case operations::MULTIPLICATION:
+            return real ? opcode::FMULT : opcode::MULT;
+        case operations::REST:
+            return opcode::MOD;
+        case operations::POSITIVE:
+            return real ? opcode::FADD : opcode::ADD;
+        case operations::NEGATIVE:
+            return real ? opcode::FSUB : opcode::SUB;
+        case operations::LESS_THAN:
+            return real ? opcode::FCMP_LT : opcode::CMP_LT;
+        case operations::GREATER_THAN:
+            return real ? opcode::FCMP_GT : opcode::CMP_GT;
+        case operations::LESS_EQUAL:
+            return real ? opcode::FCMP_LE : opcode::CMP_LE;
+        case operations::GREATER_EQUAL:
+            return real ? opcode::FCMP_GE : opcode::CMP_GE;
+        case operations::EQUAL:
+            return real ? opcode::FCMP_EQ : opcode::CMP_EQ;
+        case operations::NOT_EQUAL:
+            return real ? opcode::FCMP_NE : opcode::CMP_NE;
+        default:
+            return opcode::NOP;
+        }
+    }
+
+    auto compares(operations op) -> bool
+    {
+        return op == operations::LESS_THAN || op == operations::GREATER_THAN || op == operations::LESS_EQUAL
+            || op == operations::GREATER_EQUAL || op == operations::EQUAL || op == operations::NOT_EQUAL;
+    }
+
+    // every value is a word, floats being single precision ones
+    auto literal_of(lexic_value const& value) -> std::optional<constant>
+    {
+        return std::visit(
+            [](auto const& alternative) -> std::optional<constant> {
+                using type = std::decay_t<decltype(alternative)>;
+
+                if constexpr (std::is_same_v<type, double>)
+                    return constant { std::bit_cast<std::int32_t>(static_cast<float>(alternative)), true };
+                else if constexpr (type_in<type, int, bool, char>)
+                    return constant { static_cast<std::int32_t>(alternative) };
+                else
+                    return std::nullopt;
+            },
+            value);
+    }
+
+    auto truth_of(constant literal) -> bool
+    {
+        return literal.real ? std::bit_cast<float>(literal.bits) != 0 : literal.bits != 0;
+    }
+
+    // what the names of the program stand for, built once and only ever read
+    // from then on, however many lowerings share it
+    struct name_tables {
+        std::unordered_map<std::size_t, variable_ref>   variables; // by where the name is
+        std::unordered_map<std::uint32_t, std::int32_t> functions; // by name
+
+        explicit name_tables(program_bindings const& bindings)
+        {
+            this->variables.reserve(bindings.uses.size());
+
+            for (auto const& use : bindings.uses)
+                this->variables.emplace(use.offset, use.variable);
+
+            for (std::size_t i = 0; i < bindings.functions.size(); ++i)
+                this->functions.emplace(bindings.functions[i].name.id, static_cast<std::int32_t>(i));
+        }
+    };
+
+    class lowering {
+    public:
+        lowering(program_bindings const& bindings, string_pool const& strings, name_tables const& names,
+            line_resolver const& line_of)
+            : bindings(bindings)
+            , strings(strings)
+            , names(names)
+            , line_of(line_of)
+        {
+        }
+
+        auto function(ast_node const& node, function_info const& info) -> iloc_function
+        {
+            this->result    = {};
+            this->enclosing = &info;
+
+            this->result.name       = this->strings.name(info.name);
+            this->result.parameters = info.parameters;
+
+            this->next_register = static_cast<std::int32_t>(info.variables.size());
+
+            if (node.children.first != nullptr)
+                this->tasks.push_back({ step::STATEMENT, node.children.first });
+
+            while (!this->tasks.empty()) {
+                auto const current = this->tasks.back();
+
+                this->tasks.pop_back();
+                this->run(current);
+            }
+
+            // falling off the end returns 0
+            if (this->result.code.empty() || this->result.code.back().op != opcode::RET) {
+                auto const zero = this->temporary();
+
+                this->emit({ opcode::LOADI, 0, 0, zero });
+                this->emit({ opcode::RET, zero });
+            }
+
+            this->result.registers = used_registers(this->result);
+
+            return std::move(this->result);
+        }
+
+    private:
+        auto run(task const& current) -> void
+        {
+            auto const node = current.node;
+
+            switch (current.kind) {
+            case step::STATEMENT:
+                if (node->next != nullptr)
+                    this->later({ step::STATEMENT, node->next });
+
+                this->statement(*node);
+                break;
+            case step::VALUE:
+                this->value(*node);
+                break;
+            case step::CONDITION:
+                this->condition(*node, current.code.a, current.code.b);
+                break;
+            case step::OPERATION:
+                this->operation(*node);
+                break;
+            case step::CONVERT: {
+                auto const type = std::get<types>(node->value.value);
+                auto const real = type == types::FLOAT;
+
+                // a float is true if not zero, not if it truncates to a non zero int
+                if (type == types::BOOL)
+                    this->values.push_back({ this->truth(this->pop()), false });
+                else
+                    this->values.push_back({ this->convert(this->pop(), real), real });
+                break;
+            }
+            case step::LOAD: {
+                auto const address = this->address(*node);
+                auto const loaded  = this->temporary();
+
+                this->emit({ opcode::LOADAO, rbss, address, loaded });
+                this->values.push_back({ loaded, this->real(*node) });
+                break;
+            }
+            case step::CALL:
+                this->call(*node);
+                break;
+            case step::BRANCH:
+                this->emit({ opcode::CBR, this->truth(this->pop()), current.code.a, current.code.b });
+                break;
+            case step::ASSIGN:
+                this->assign(*node);
+                break;
+            case step::OUTPUT: {
+                auto const written = this->pop();
+
+                this->emit({ written.real ? opcode::FOUTPUT : opcode::OUTPUT, written.reg });
+                break;
+            }
+            case step::RETURN:
+                this->emit({ opcode::RET, this->convert(this->pop(), this->enclosing->type == types::FLOAT) });
+                break;
+            case step::DISCARD:
+                this->pop();
+                break;
+            case step::EMIT:
+                this->emit(current.code);
+                break;
+            case step::PUSH:
+                this->values.push_back({ current.code.a, current.code.b != 0 });
+                break;
+            }
+        }
+
+        auto statement(ast_node const& node) -> void
+        {
+            auto const first = node.children.first;
+
+            if (auto const op = std::get_if<operations>(&node.value.value)) {
+                if (*op == operations::ATTRIBUTION || *op == operations::INITIALIZATION) {
+                    this->later({ step::ASSIGN, first });
+                    this->later_indices(*first);
+                    this->later({ step::VALUE, first->sibling });
+                }
+            } else if (auto const keyword = std::get_if<keywords>(&node.value.value)) {
+                switch (*keyword) {
+                case keywords::IF: {
+                    auto const [then_block, else_block] = branches_of(node);
+
+                    auto const taken = this->label();
+                    auto const other = else_block != nullptr ? this->label() : -1;
+                    auto const end   = this->label();
+
+                    this->later({ step::EMIT, nullptr, { opcode::LABEL, end } });
+
+                    if (else_block != nullptr) {
+                        this->later({ step::STATEMENT, else_block });
+                        this->later({ step::EMIT, nullptr, { opcode::LABEL, other } });
+                        this->later({ step::EMIT, nullptr, { opcode::JUMPI, end } });
+                    }
+
+                    if (then_block != nullptr)
+                        this->later({ step::STATEMENT, then_block });
+
+                    this->later({ step::EMIT, nullptr, { opcode::LABEL, taken } });
+                    this->later({ step::CONDITION, first, { opcode::NOP, taken, else_block != nullptr ? other : end } });
+                    break;
+                }
+                case keywords::WHILE: {
+                    auto const head = this->label();
+                    auto const body = this->label();
+                    auto const end  = this->label();
+
+                    this->later({ step::EMIT, nullptr, { opcode::LABEL, end } });
+                    this->later({ step::EMIT, nullptr, { opcode::JUMPI, head } });
+
+                    if (first->sibling != nullptr)
+                        this->later({ step::STATEMENT, first->sibling });
+
+                    this->later({ step::EMIT, nullptr, { opcode::LABEL, body } });
+                    this->later({ step::CONDITION, first, { opcode::NOP, body, end } });
+                    this->later({ step::EMIT, nullptr, { opcode::LABEL, head } });
+                    break;
+                }
+                case keywords::INPUT: {
+                    auto const read = this->temporary();
+                    auto const real = this->real(*first);
+
+                    this->emit({ real ? opcode::FINPUT : opcode::INPUT, 0, 0, read });
+                    this->values.push_back({ read, real });
+
+                    this->later({ step::ASSIGN, first });
+                    this->later_indices(*first);
+                    break;
+                }
+                case keywords::OUTPUT:
+                    this->later({ step::OUTPUT });
+                    this->later({ step::VALUE, first });
+                    break;
+                case keywords::RETURN:
+                    this->later({ step::RETURN });
+                    this->later({ step::VALUE, first });
+                    break;
+                }
+            } else if (std::holds_alternative<function_call>(node.value.value)) {
+                this->later({ step::DISCARD });
+                this->later({ step::VALUE, &node });
+            }
+        }
+
+        auto value(ast_node const& node) -> void
+        {
+            if (auto const literal = literal_of(node.value.value)) {
+                auto const loaded = this->temporary();
+
+                this->emit({ literal->real ? opcode::LOADF : opcode::LOADI, literal->bits, 0, loaded });
+                this->values.push_back({ loaded, literal->real });
+                return;
+            }
+
+            if (std::holds_alternative<identifier>(node.value.value)) {
+                auto const variable = this->variable_of(node);
+
+                if (!variable.global) {
+                    this->values.push_back({ static_cast<std::int32_t>(variable.number), this->real(node) });
+                    return;
+                }
+
+                auto const loaded = this->temporary();
+                auto const offset = this->bindings.globals[variable.number].offset;
+
+                this->emit({ opcode::LOADAI, rbss, static_cast<std::int32_t>(offset), loaded });
+                this->values.push_back({ loaded, this->real(node) });
+                return;
+            }
+
+            if (std::holds_alternative<function_call>(node.value.value)) {
+                this->later({ step::CALL, &node });
+
+                // the arguments are chained, and computed in their order
+                auto const first = this->tasks.size();
+
+                for (auto argument = node.children.first; argument != nullptr; argument = argument->next)
+                    this->later({ step::VALUE, argument });
+
+                std::reverse(this->tasks.begin() + static_cast<std::ptrdiff_t>(first), this->tasks.end());
+                return;
+            }
+
+            // a conversion, see type_checker.hh
+            if (std::holds_alternative<types>(node.value.value)) {
+                this->later({ step::CONVERT, &node });
+                this->later({ step::VALUE, node.children.first });
+                return;
+            }
+
+            auto const op  = std::get<operations>(node.value.value);
+            auto const lhs = node.children.first;
+            auto const rhs = lhs->sibling;
+
+            switch (op) {
+            case operations::INDEX:
+                this->later({ step::LOAD, &node });
+                this->later_indices(node);
+                break;
+            case operations::AND:
+            case operations::OR:
+            case operations::NEGATION: {
+                // as a condition, branching to the value it takes
+                auto const result = this->temporary();
+                auto const yes    = this->label();
+                auto const no     = this->label();
+                auto const end    = this->label();
+
+                this->later({ step::PUSH, nullptr, { opcode::NOP, result, 0 } });
+                this->later({ step::EMIT, nullptr, { opcode::LABEL, end } });
+                this->later({ step::EMIT, nullptr, { opcode::LOADI, 0, 0, result } });
+                this->later({ step::EMIT, nullptr, { opcode::LABEL, no } });
+                this->later({ step::EMIT, nullptr, { opcode::JUMPI, end } });
+                this->later({ step::EMIT, nullptr, { opcode::LOADI, 1, 0, result } });
+                this->later({ step::EMIT, nullptr, { opcode::LABEL, yes } });
+                this->later({ step::CONDITION, &node, { opcode::NOP, yes, no } });
+                break;
+            }
+            case operations::POSITIVE:
+                if (rhs == nullptr) {
+                    this->later({ step::VALUE, lhs });
+                    break;
+                }
+                [[fallthrough]];
+            default:
+                this->later({ step::OPERATION, &node });
+
+                if (rhs != nullptr)
+                    this->later({ step::VALUE, rhs });
+
+                this->later({ step::VALUE, lhs });
+                break;
+            }
+        }
+
+        auto condition(ast_node const& node, std::int32_t yes, std::int32_t no) -> void
+        {
+            if (auto const literal = literal_of(node.value.value)) {
+                this->emit({ opcode::JUMPI, truth_of(*literal) ? yes : no });
+                return;
+            }
+
+            auto const op = std::get_if<operations>(&node.value.value);
+
+            if (op == nullptr || (*op != operations::AND && *op != operations::OR && *op != operations::NEGATION)) {
+                this->later({ step::BRANCH, nullptr, { opcode::NOP, yes, no } });
+                this->later({ step::VALUE, &node });
+                return;
+            }
+
+            auto const lhs = node.children.first;
+
+            if (*op == operations::NEGATION) {
+                this->later({ step::CONDITION, lhs, { opcode::NOP, no, yes } });
+                return;
+            }
+
+            // the right side is reached only if the left didn't decide it all
+            auto const right = this->label();
+
+            this->later({ step::CONDITION, lhs->sibling, { opcode::NOP, yes, no } });
+            this->later({ step::EMIT, nullptr, { opcode::LABEL, right } });
+
+            if (*op == operations::AND)
+                this->later({ step::CONDITION, lhs, { opcode::NOP, right, no } });
+            else
+                this->later({ step::CONDITION, lhs, { opcode::NOP, yes, right } });
+        }
+
+        auto operation(ast_node const& node) -> void
+        {
+            auto const op = std::get<operations>(node.value.value);
+
+            if (node.children.first->sibling == nullptr) {
+                // the only unary operation left is the negative
+                auto const negated = this->pop();
+                auto const result  = this->temporary();
+
+                if (negated.real) {
+                    auto const zero = this->temporary();
+
+                    this->emit({ opcode::LOADF, 0, 0, zero });
+                    this->emit({ opcode::FSUB, zero, negated.reg, result });
+                } else {
+                    this->emit({ opcode::RSUBI, negated.reg, 0, result });
+                }
+
+                this->values.push_back({ result, negated.real });
+                return;
+            }
+
+            auto const rhs = this->pop();
+            auto const lhs = this->pop();
+
+            // ints meeting floats become floats, but the rest is of ints alone
+            auto const real = op != operations::REST && (lhs.real || rhs.real);
+
+            auto const left   = this->convert(lhs, real);
+            auto const right  = this->convert(rhs, real);
+            auto const result = this->temporary();
+
+            this->emit({ opcode_of(op, real), left, right, result });
+            this->values.push_back({ result, real && !compares(op) });
+        }
+
+        auto call(ast_node const& node) -> void
+        {
+            auto const callee = std::get<function_call>(node.value.value).callee;
+            auto const found  = this->names.functions.find(callee.id);
+
+            if (found == this->names.functions.end())
+                throw std::runtime_error(fmt::format("ir error, \"{}\" is not a function\n", this->strings.name(callee)));
+
+            std::int32_t count = 0;
+
+            for (auto argument = node.children.first; argument != nullptr; argument = argument->next)
+                ++count;
+
+            auto const& info = this->bindings.functions[static_cast<std::size_t>(found->second)];
+
+            if (static_cast<std::uint32_t>(count) != info.parameters)
+                throw std::runtime_error(fmt::format("ir error, line {}: \"{}\" takes {} arguments, but is called with {}\n",
+                    this->line_of(node.value.location), this->strings.name(callee), info.parameters, count));
+
+            // each converted to the type of its parameter
+            std::vector<std::int32_t> passed(static_cast<std::size_t>(count));
+
+            for (auto i = static_cast<std::size_t>(count); i-- > 0;)
+                passed[i] = this->convert(this->pop(), info.variables[i] == types::FLOAT);
+
+            auto& arguments = this->result.arguments;
+            auto const start = static_cast<std::int32_t>(arguments.size());
+
+            arguments.push_back(count);
+            arguments.insert(arguments.end(), passed.begin(), passed.end());
+
+            auto const returned = this->temporary();
+
+            this->emit({ opcode::CALL, found->second, start, returned });
+            this->values.push_back({ returned, info.type == types::FLOAT });
+        }
+
+        auto assign(ast_node const& target) -> void
+        {
+            auto const real = this->real(target);
+
+            if (std::holds_alternative<operations>(target.value.value)) {
+                // the value was computed before the indices
+                auto const address = this->address(target);
+
+                this->emit({ opcode::STOREAO, rbss, address, this->convert(this->pop(), real) });
+                return;
+            }
+
+            auto const variable = this->variable_of(target);
+            auto const stored   = this->convert(this->pop(), real);
+
+            if (!variable.global) {
+                this->emit({ opcode::I2I, stored, 0, static_cast<std::int32_t>(variable.number) });
+                return;
+            }
+
+            auto const offset = this->bindings.globals[variable.number].offset;
+
+            this->emit({ opcode::STOREAI, rbss, static_cast<std::int32_t>(offset), stored });
+        }
+
+        // schedules the indices of an element of an array (if target is one),
+        // to be computed in their order
+        auto later_indices(ast_node const& target) -> void
+        {
+            auto const op = std::get_if<operations>(&target.value.value);
+
+            if (op == nullptr || *op != operations::INDEX)
+                return;
+
+            auto const name  = target.children.first;
+            auto const& array = this->bindings.globals[this->variable_of(*name).number];
+
+            // a[i ^ j ^ k] is sep(sep(sep(i), j), k), so they come last first
+            std::size_t count = 0;
+
+            for (auto separator = name->sibling; separator != nullptr; ++count) {
+                auto const index = separator->children.first;
+
+                if (index->sibling == nullptr) {
+                    this->later({ step::VALUE, index });
+                    separator = nullptr;
+                } else {
+                    this->later({ step::VALUE, index->sibling });
+                    separator = index;
+                }
+            }
+
+            if (count != array.dimensions.size())
+                throw std::runtime_error(fmt::format("ir error, line {}: \"{}\" has {} dimensions, but is indexed with {}\n",
+                    this->line_of(target.value.location), this->strings.name(array.name), array.dimensions.size(), count));
+        }
+
+        // where the element of an array is, from its indices on the stack
+        auto address(ast_node const& target) -> std::int32_t
+        {
+            auto const& array = this->bindings.globals[this->variable_of(*target.children.first).number];
+
+            auto const count = array.dimensions.size();
+            auto const first = this->values.size() - count;
+
+            // row by row: ((i * dj) + j) * dk + k, indices being ints
+            auto offset = this->convert(this->values[first], false);
+
+            for (std::size_t i = 1; i < count; ++i) {
+                auto const index  = this->convert(this->values[first + i], false);
+                auto const scaled = this->temporary();
+                auto const added  = this->temporary();
+
+                this->emit({ opcode::MULTI, offset, static_cast<std::int32_t>(array.dimensions[i]), scaled });
+                this->emit({ opcode::ADD, scaled, index, added });
+
+                offset = added;
+            }
+
+            this->values.resize(first);
+
+            if (array.offset == 0)
+                return offset;
+
+            auto const moved = this->temporary();
+
+            this->emit({ opcode::ADDI, offset, static_cast<std::int32_t>(array.offset), moved });
+
+            return moved;
+        }
+
+        auto variable_of(ast_node const& name) const -> variable_ref
+        {
+            auto const found = this->names.variables.find(name.value.location.begin);
+
+            if (found == this->names.variables.end())
+                throw std::runtime_error(fmt::format("ir error, line {}: nothing is known of \"{}\"\n",
+                    this->line_of(name.value.location), this->strings.name(std::get<identifier>(name.value.value))));
+
+            return found->second;
+        }
+
+        // whether the variable named by target (or the array it indexes)
+        // holds floats
+        auto real(ast_node const& target) const -> bool
+        {
+            auto const& name = std::holds_alternative<operations>(target.value.value) ? *target.children.first : target;
+
+            auto const variable = this->variable_of(name);
+
+            auto const type = variable.global ? this->bindings.globals[variable.number].type
+                                              : this->enclosing->variables[variable.number];
+
+            return type == types::FLOAT;
+        }
+
+        // the register of value, converted to a float or to an int
+        auto convert(operand value, bool real) -> std::int32_t
+        {
+            if (value.real == real)
+                return value.reg;
+
+            auto const converted = this->temporary();
+
+            this->emit({ real ? opcode::I2F : opcode::F2I, value.reg, 0, converted });
+
+            return converted;
+        }
+
+        // an int telling whether value is true, which for floats takes a
+        // comparison, as -0.0 is not all zero bits
+        auto truth(operand value) -> std::int32_t
+        {
+            if (!value.real)
+                return value.reg;
+
+            auto const zero   = this->temporary();
+            auto const result = this->temporary();
+
+            this->emit({ opcode::LOADF, 0, 0, zero });
+            this->emit({ opcode::FCMP_NE, value.reg, zero, result });
+
+            return result;
+        }
+
+        auto later(task const& next) -> void { this->tasks.push_back(next); }
+
+        auto emit(instruction const& code) -> void { this->result.code.push_back(code); }
+
+        auto pop() -> operand
+        {
+            auto const top = this->values.back();
+
+            this->values.pop_back();
+
+            return top;
+        }
+
+        auto temporary() -> std::int32_t { return this->next_register++; }
+
+        auto label() -> std::int32_t { return static_cast<std::int32_t>(this->result.labels++); }
+
+        program_bindings const& bindings;
+        string_pool const&      strings;
+        name_tables const&      names;
+        line_resolver const&    line_of;
+
+        iloc_function        result;
+        function_info const* enclosing     = nullptr;
+        std::int32_t         next_register = 0;
+        std::vector<task>    tasks;
+        std::vector<operand> values;
+    };
+
+}
+
+auto generate_iloc(ast_node const* root, program_bindings const& bindings, string_pool const& strings,
+    line_resolver const& line_of, thread_pool* pool) -> iloc_program
+{
+    iloc_program program;
+
+    program.globals = bindings.global_words;
+
+    // the functions are chained in the order they were declared
+    std::vector<ast_node const*> functions;
+
+    for (auto function = root; function != nullptr; function = function->next) {
+        if (functions.size() == bindings.functions.size())
+            throw std::runtime_error("ir error, there are more functions than were declared\n");
+
+        functions.push_back(function);
+    }
+
+    name_tables const names(bindings);
+
+    program.functions.resize(functions.size());
+
+    if (pool == nullptr) {
+        lowering lower(bindings, strings, names, line_of);
+
+        for (std::size_t i = 0; i < functions.size(); ++i)
+            program.functions[i] = lower.function(*functions[i], bindings.functions[i]);
+
+        return program;
+    }
+
+    // a lowering per worker, each function lowered into its own place. the
+    // error of the first function to fail is the one given, whichever worker
+    // got there first
+    std::vector<std::optional<lowering>> lowerings(pool->size());
+    std::vector<std::exception_ptr>      failures(functions.size());
+
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+        pool->submit([&, i](std::size_t worker) {
+            try {
+                if (!lowerings[worker])
+                    lowerings[worker].emplace(bindings, strings, names, line_of);
+
+                program.functions[i] = lowerings[worker]->function(*functions[i], bindings.functions[i]);
+            } catch (...) {
+                failures[i] = std::current_exception();
+            }
+        });
+    }
+
+    pool->wait();
+
+    for (auto const& failure : failures) {
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+
+    return program;
+}
+
+}
@@ -0,0 +1,1787 @@
+/** @file optimizer.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "optimizer.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace hcpsilva {
+
+namespace {
+
+    using value = std::int32_t;
+
+    constexpr auto none = std::numeric_limits<std::size_t>::max();
+
+    struct phi {
+        value              dst = 0;
+        std::vector<value> sources; // one per predecessor, in their order
+    };
+
+    struct block {
+        std::vector<phi>         phis;
+        std::vector<instruction> code; // ends in a jumpI, cbr or ret, jumping to blocks instead of labels
+        std::vector<std::size_t> predecessors; // once per edge, so twice for a cbr with both sides here
+        bool                     reachable = true;
+    };
+
+    auto jumps(opcode op) -> bool
+    {
+        return op == opcode::JUMPI || op == opcode::CBR || op == opcode::RET;
+    }
+
+    // what can be computed anywhere, any number of times, to the same end
+    auto pure(opcode op) -> bool
+    {
+        return (op >= opcode::ADD && op <= opcode::F2I && op != opcode::DIV && op != opcode::MOD);
+    }
+
+    auto commutes(opcode op) -> bool
+    {
+        return op == opcode::ADD || op == opcode::MULT || op == opcode::CMP_EQ || op == opcode::CMP_NE
+            || op == opcode::FADD || op == opcode::FMULT || op == opcode::FCMP_EQ || op == opcode::FCMP_NE;
+    }
+
+    // what must stay, whether what it writes is read or not
+    auto effects(opcode op) -> bool
+    {
+        switch (op) {
+        case opcode::DIV:
+        case opcode::MOD:
+        case opcode::LOADAO:
+        case opcode::STOREAI:
+        case opcode::STOREAO:
+        case opcode::JUMPI:
+        case opcode::CBR:
+        case opcode::CALL:
+        case opcode::RET:
+        case opcode::INPUT:
+        case opcode::OUTPUT:
+        case opcode::FINPUT:
+        case opcode::FOUTPUT:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /** @brief the register code writes, if any */
+    auto written(instruction& code) -> value*
+    {
+        switch (code.op) {
+        case opcode::NOP:
+        case opcode::STOREAI:
+        case opcode::STOREAO:
+        case opcode::JUMPI:
+        case opcode::CBR:
+        case opcode::LABEL:
+        case opcode::RET:
+        case opcode::OUTPUT:
+        case opcode::FOUTPUT:
+            return nullptr;
+        default:
+            return &code.c;
+        }
+    }
+
+    /** @brief calls read with each register code reads, the arguments of a
+     * call included, so they can be renamed */
+    template <typename reader>
+    auto each_read(instruction& code, std::vector<value>& arguments, reader&& read) -> void
+    {
+        if (code.op >= opcode::ADD && code.op <= opcode::FCMP_NE) {
+            read(code.a);
+            read(code.b);
+            return;
+        }
+
+        switch (code.op) {
+        case opcode::ADDI:
+        case opcode::MULTI:
+        case opcode::RSUBI:
+        case opcode::I2I:
+        case opcode::I2F:
+        case opcode::F2I:
+        case opcode::CBR:
+        case opcode::RET:
+        case opcode::OUTPUT:
+        case opcode::FOUTPUT:
+            read(code.a);
+            break;
+        case opcode::LOADAO:
+            read(code.b);
+            break;
+        case opcode::STOREAI:
+            read(code.c);
+            break;
+        case opcode::STOREAO:
+            read(code.b);
+            read(code.c);
+            break;
+        case opcode::CALL: {
+            auto const first = static_cast<std::size_t>(code.b);
+
+            for (std::size_t i = 1; i <= static_cast<std::size_t>(arguments[first]); ++i)
+                read(arguments[first + i]);
+
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    auto wrap(std::int64_t result) -> std::int32_t
+    {
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(result));
+    }
+
+    auto real(std::int32_t bits) -> float
+    {
+        return std::bit_cast<float>(bits);
+    }
+
+    auto bits(float number) -> std::int32_t
+    {
+        return std::bit_cast<std::int32_t>(number);
+    }
+
+    /** @brief the result of op over constants, as the virtual machine would
+     * compute it, if it computes anything at all */
+    auto evaluate(opcode op, std::int32_t a, std::int32_t b) -> std::optional<std::int32_t>
+    {
+        std::int64_t const x = a, y = b;
+
+        switch (op) {
+        case opcode::ADD:
+        case opcode::ADDI:
+            return wrap(x + y);
+        case opcode::SUB:
+            return wrap(x - y);
+        case opcode::RSUBI:
+            return wrap(y - x);
+        case opcode::MULT:
+        case opcode::MULTI:
+            return wrap(x * y);
+        case opcode::DIV:
+            return y == 0 ? std::nullopt : std::optional(wrap(x / y));
+        case opcode::MOD:
+            return y == 0 ? std::nullopt : std::optional(wrap(x % y));
+        case opcode::CMP_LT:
+            return a < b;
+        case opcode::CMP_LE:
+            return a <= b;
+        case opcode::CMP_EQ:
+            return a == b;
+        case opcode::CMP_GE:
+            return a >= b;
+        case opcode::CMP_GT:
+            return a > b;
+        case opcode::CMP_NE:
+            return a != b;
+        case opcode::FADD:
+            return bits(real(a) + real(b));
+        case opcode::FSUB:
+            return bits(real(a) - real(b));
+        case opcode::FMULT:
+            return bits(real(a) * real(b));
+        case opcode::FDIV:
+            return bits(real(a) / real(b));
+        case opcode::FCMP_LT:
+            return real(a) < real(b);
+        case opcode::FCMP_LE:
+            return real(a) <= real(b);
+        case opcode::FCMP_EQ:
+            return real(a) == real(b);
+        case opcode::FCMP_GE:
+            return real(a) >= real(b);
+        case opcode::FCMP_GT:
+            return real(a) > real(b);
+        case opcode::FCMP_NE:
+            return real(a) != real(b);
+        case opcode::LOADI:
+        case opcode::LOADF:
+        case opcode::I2I:
+            return a;
+        case opcode::I2F:
+            return bits(static_cast<float>(a));
+        case opcode::F2I:
+            // as truncating on the virtual machine, the lowest int if out of range
+            if (!(real(a) >= -2147483648.0f && real(a) < 2147483648.0f))
+                return std::numeric_limits<std::int32_t>::min();
+
+            return static_cast<std::int32_t>(real(a));
+        default:
+            return std::nullopt;
+        }
+    }
+
+    /** @brief an instruction as a key for value numbering, its registers
+     * already renamed */
+    struct expression {
+        opcode       op;
+        std::int32_t a;
+        std::int32_t b;
+
+        auto operator==(expression const&) const -> bool = default;
+    };
+
+    struct expression_hash {
+        auto operator()(expression const& key) const -> std::size_t
+        {
+            auto const mixed = (std::uint64_t(std::uint32_t(key.a)) << 32 | std::uint32_t(key.b)) * 0x9e3779b97f4a7c15u;
+
+            return static_cast<std::size_t>(mixed ^ mixed >> 29) + static_cast<std::size_t>(key.op);
+        }
+    };
+
+    /** @brief one function, from its code into SSA, through the passes and
+     * back */
+    class optimizer {
+    public:
+        optimizer(iloc_function& function, std::uint32_t globals, optimizer_statistics& counts)
+            : function(function)
+            , globals(globals)
+            , counts(counts)
+        {
+        }
+
+        auto run(optimizer_passes const& passes) -> void
+        {
+            this->build();
+            this->analyze();
+            this->into_ssa();
+
+            if (passes.constants)
+                this->propagate_constants();
+
+            if (passes.invariants)
+                this->hoist_invariants();
+
+            if (passes.numbering)
+                this->number_values();
+
+            // dead phis keep jumps from being threaded, and the conditions of
+            // branches made jumps are dead in turn
+            if (passes.dead_code)
+                this->remove_dead_code();
+
+            this->thread_jumps();
+
+            if (passes.dead_code)
+                this->remove_dead_code();
+
+            this->out_of_ssa();
+            this->lay_out();
+        }
+
+    private:
+        template <typename... arguments>
+        [[noreturn]] auto fail(fmt::format_string<arguments...> format, arguments&&... values) const -> void
+        {
+            throw std::runtime_error(fmt::format("optimizer error, function \"{}\": {}\n", this->function.name,
+                fmt::format(format, std::forward<arguments>(values)...)));
+        }
+
+        auto successors(std::size_t number) const -> std::vector<std::size_t>
+        {
+            auto const& last = this->blocks[number].code.back();
+
+            if (last.op == opcode::JUMPI)
+                return { static_cast<std::size_t>(last.a) };
+
+            if (last.op == opcode::CBR)
+                return { static_cast<std::size_t>(last.b), static_cast<std::size_t>(last.c) };
+
+            return {};
+        }
+
+        // the same, each block once
+        auto targets(std::size_t number) const -> std::vector<std::size_t>
+        {
+            auto next = this->successors(number);
+
+            if (next.size() == 2 && next[0] == next[1])
+                next.pop_back();
+
+            return next;
+        }
+
+        auto fresh() -> value { return this->next++; }
+
+        // splits the code in blocks, block 0 being a new one before the rest,
+        // which is where the registers start off
+        auto build() -> void
+        {
+            std::vector<std::size_t> labels(this->function.labels, none);
+            std::vector<bool>        resolved { true, false }; // whether the jump out is to a block already
+
+            this->blocks.resize(2);
+            this->blocks[0].code.push_back({ opcode::JUMPI, 1 });
+
+            auto current = std::size_t { 1 };
+
+            for (auto const& code : this->function.code) {
+                if (code.op == opcode::NOP)
+                    continue;
+
+                if (code.op == opcode::LABEL) {
+                    // a new block, unless the current one is still empty
+                    if (current == none || !this->blocks[current].code.empty()) {
+                        if (current != none) {
+                            this->blocks[current].code.push_back({ opcode::JUMPI, static_cast<value>(this->blocks.size()) });
+                            resolved[current] = true;
+                        }
+
+                        current = this->blocks.size();
+                        this->blocks.emplace_back();
+                        resolved.push_back(false);
+                    }
+
+                    labels[static_cast<std::size_t>(code.a)] = current;
+                    continue;
+                }
+
+                // what follows a jump with no label before it is never reached
+                if (current == none)
+                    continue;
+
+                this->blocks[current].code.push_back(code);
+
+                if (jumps(code.op))
+                    current = none;
+            }
+
+            if (current != none)
+                this->fail("runs off its end, which must be a ret or a jumpI");
+
+            auto const target = [&](std::int32_t& label) {
+                if (label < 0 || static_cast<std::uint32_t>(label) >= this->function.labels
+                    || labels[static_cast<std::size_t>(label)] == none)
+                    this->fail("jumps to L{}, which is nowhere", label);
+
+                label = static_cast<std::int32_t>(labels[static_cast<std::size_t>(label)]);
+            };
+
+            for (std::size_t i = 0; i < this->blocks.size(); ++i) {
+                auto& last = this->blocks[i].code.back();
+
+                if (resolved[i] || last.op == opcode::RET)
+                    continue;
+
+                if (last.op == opcode::JUMPI) {
+                    target(last.a);
+                } else {
+                    target(last.b);
+                    target(last.c);
+                }
+            }
+
+            this->layout.resize(this->blocks.size());
+            std::iota(this->layout.begin(), this->layout.end(), std::size_t { 0 });
+
+            this->registers = std::max(this->function.registers, used_registers(this->function));
+            this->next      = static_cast<value>(this->registers);
+            this->counts.before += this->function.code.size();
+
+            this->edges();
+        }
+
+        // the blocks reached, in reverse post order, and their dominators,
+        // giving how many blocks were no longer reached. the predecessors are
+        // kept as they are, as the phis follow their order
+        auto analyze() -> std::size_t
+        {
+            auto const count = this->blocks.size();
+
+            std::vector<std::size_t> post;
+            std::vector<bool>        seen(count, false);
+
+            std::vector<std::pair<std::size_t, std::size_t>> stack { { 0, 0 } };
+
+            seen[0] = true;
+
+            while (!stack.empty()) {
+                auto& [number, visited] = stack.back();
+
+                auto const next = this->successors(number);
+
+                if (visited < next.size()) {
+                    auto const successor = next[visited++];
+
+                    if (!seen[successor]) {
+                        seen[successor] = true;
+                        stack.emplace_back(successor, 0);
+                    }
+                } else {
+                    post.push_back(number);
+                    stack.pop_back();
+                }
+            }
+
+            this->order.assign(post.rbegin(), post.rend());
+            this->position.assign(count, none);
+
+            for (std::size_t i = 0; i < this->order.size(); ++i)
+                this->position[this->order[i]] = i;
+
+            // blocks no longer reached leave the predecessors of the rest
+            std::size_t dropped = 0;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                if (seen[i] || !this->blocks[i].reachable)
+                    continue;
+
+                for (auto const successor : this->successors(i))
+                    this->drop_edge(i, successor);
+
+                this->blocks[i].reachable = false;
+                this->blocks[i].phis.clear();
+                this->blocks[i].code.clear();
+
+                ++dropped;
+            }
+
+            // after Cooper, Harvey and Kennedy
+            this->dominator.assign(count, none);
+            this->dominator[0] = 0;
+
+            auto const intersect = [&](std::size_t a, std::size_t b) {
+                while (a != b) {
+                    while (this->position[a] > this->position[b])
+                        a = this->dominator[a];
+
+                    while (this->position[b] > this->position[a])
+                        b = this->dominator[b];
+                }
+
+                return a;
+            };
+
+            for (auto changed = true; changed;) {
+                changed = false;
+
+                for (auto const number : this->order | std::views::drop(1)) {
+                    auto found = none;
+
+                    for (auto const predecessor : this->blocks[number].predecessors) {
+                        if (this->dominator[predecessor] == none)
+                            continue;
+
+                        found = found == none ? predecessor : intersect(predecessor, found);
+                    }
+
+                    if (this->dominator[number] != found) {
+                        this->dominator[number] = found;
+                        changed                 = true;
+                    }
+                }
+            }
+
+            this->children.assign(count, {});
+
+            for (auto const number : this->order | std::views::drop(1))
+                this->children[this->dominator[number]].push_back(number);
+
+            return dropped;
+        }
+
+        auto dominates(std::size_t a, std::size_t b) const -> bool
+        {
+            while (b != a && b != 0)
+                b = this->dominator[b];
+
+            return a == b;
+        }
+
+        auto edges() -> void
+        {
+            for (auto& current_block : this->blocks)
+                current_block.predecessors.clear();
+
+            for (std::size_t i = 0; i < this->blocks.size(); ++i) {
+                if (!this->blocks[i].code.empty())
+                    for (auto const successor : this->successors(i))
+                        this->blocks[successor].predecessors.push_back(i);
+            }
+        }
+
+        // takes an edge from..to out, and what comes through it in the phis
+        auto drop_edge(std::size_t from, std::size_t to) -> void
+        {
+            auto& target = this->blocks[to];
+            auto  found  = std::ranges::find(target.predecessors, from);
+
+            auto const slot = static_cast<std::size_t>(found - target.predecessors.begin());
+
+            target.predecessors.erase(found);
+
+            for (auto& node : target.phis)
+                node.sources.erase(node.sources.begin() + static_cast<std::ptrdiff_t>(slot));
+        }
+
+        // calls visit with each block, parents before children in the
+        // dominator tree, and leave after the children of each
+        template <typename visitor, typename leaver>
+        auto walk(visitor&& visit, leaver&& leave) -> void
+        {
+            std::vector<std::pair<std::size_t, std::size_t>> stack { { 0, 0 } };
+
+            visit(std::size_t { 0 });
+
+            while (!stack.empty()) {
+                auto& [number, child] = stack.back();
+
+                if (child < this->children[number].size()) {
+                    auto const next = this->children[number][child++];
+
+                    visit(next);
+                    stack.emplace_back(next, 0);
+                } else {
+                    leave(number);
+                    stack.pop_back();
+                }
+            }
+        }
+
+        // phis where the registers read across blocks meet, after Cytron et
+        // al., and a new name for each write
+        auto into_ssa() -> void
+        {
+            auto const count = this->blocks.size();
+
+            std::vector<std::vector<std::size_t>> frontier(count);
+
+            for (auto const number : this->order) {
+                auto const& predecessors = this->blocks[number].predecessors;
+
+                if (predecessors.size() < 2)
+                    continue;
+
+                for (auto runner : predecessors) {
+                    while (runner != this->dominator[number]) {
+                        if (frontier[runner].empty() || frontier[runner].back() != number)
+                            frontier[runner].push_back(number);
+
+                        runner = this->dominator[runner];
+                    }
+                }
+            }
+
+            // registers read before being written in some block, the only
+            // ones that can need phis, what each block reads of them before
+            // writing, and where each is written
+            std::vector<bool>                     crossing(this->registers, false);
+            std::vector<std::vector<std::size_t>> exposed(count);
+            std::vector<std::vector<bool>>        killed(count, std::vector<bool>(this->registers, false));
+            std::vector<std::vector<std::size_t>> written_at(this->registers);
+
+            for (auto const number : this->order) {
+                for (auto& code : this->blocks[number].code) {
+                    each_read(code, this->function.arguments, [&](value& read) {
+                        auto const r = static_cast<std::size_t>(read);
+
+                        if (!killed[number][r]) {
+                            crossing[r] = true;
+                            exposed[number].push_back(r);
+                        }
+                    });
+
+                    if (auto const target = written(code)) {
+                        auto const r = static_cast<std::size_t>(*target);
+
+                        if (!killed[number][r])
+                            written_at[r].push_back(number);
+
+                        killed[number][r] = true;
+                    }
+                }
+            }
+
+            // where each is live in, so phis only go where their value is read
+            // (pruned form)
+            std::vector<std::vector<bool>> live(count, std::vector<bool>(this->registers, false));
+
+            for (auto changed = true; changed;) {
+                changed = false;
+
+                for (auto const number : this->order | std::views::reverse) {
+                    auto& in = live[number];
+
+                    auto const add = [&](std::size_t r) {
+                        if (!in[r]) {
+                            in[r]   = true;
+                            changed = true;
+                        }
+                    };
+
+                    for (auto const r : exposed[number])
+                        add(r);
+
+                    for (auto const successor : this->successors(number)) {
+                        for (std::size_t r = 0; r < this->registers; ++r) {
+                            if (live[successor][r] && !killed[number][r])
+                                add(r);
+                        }
+                    }
+                }
+            }
+
+            // the registers start off as the arguments, or zeroed
+            auto& entry = this->blocks[0].code;
+
+            for (auto r = this->function.parameters; r < this->registers; ++r) {
+                if (live[0][r])
+                    entry.insert(entry.end() - 1, { opcode::LOADI, 0, 0, static_cast<value>(r) });
+            }
+
+            std::vector<std::size_t> placed(count, none);
+
+            for (std::size_t r = 0; r < this->registers; ++r) {
+                if (!crossing[r])
+                    continue;
+
+                auto work = written_at[r];
+
+                work.push_back(0);
+
+                while (!work.empty()) {
+                    auto const at = work.back();
+
+                    work.pop_back();
+
+                    for (auto const meet : frontier[at]) {
+                        if (placed[meet] == r || !live[meet][r])
+                            continue;
+
+                        placed[meet] = r;
+
+                        auto& target = this->blocks[meet];
+
+                        target.phis.push_back({ static_cast<value>(r),
+                            std::vector<value>(target.predecessors.size(), static_cast<value>(r)) });
+
+                        work.push_back(meet);
+                    }
+                }
+            }
+
+            // renaming, with a stack of names for each register
+            std::vector<std::vector<value>> names(this->registers);
+            std::vector<std::size_t>        pushed; // registers named, in order, to be undone on leaving
+            std::vector<std::size_t>        marks;
+
+            for (value p = 0; p < static_cast<value>(this->function.parameters); ++p)
+                names[static_cast<std::size_t>(p)].push_back(p);
+
+            auto const name = [&](value& r) {
+                auto const number = static_cast<std::size_t>(r);
+
+                r = this->fresh();
+
+                names[number].push_back(r);
+                pushed.push_back(number);
+            };
+
+            this->walk(
+                [&](std::size_t number) {
+                    auto& current = this->blocks[number];
+
+                    marks.push_back(pushed.size());
+
+                    for (auto& node : current.phis)
+                        name(node.dst);
+
+                    for (auto& code : current.code) {
+                        each_read(code, this->function.arguments, [&](value& read) {
+                            if (read >= 0)
+                                read = names[static_cast<std::size_t>(read)].back();
+                        });
+
+                        // copies are folded away, their target naming what they read
+                        if (code.op == opcode::I2I && code.a >= 0) {
+                            names[static_cast<std::size_t>(code.c)].push_back(code.a);
+                            pushed.push_back(static_cast<std::size_t>(code.c));
+
+                            code.op = opcode::NOP;
+
+                            ++this->counts.copies;
+                            continue;
+                        }
+
+                        if (auto const target = written(code))
+                            name(*target);
+                    }
+
+                    // the sources of the phis this block leads to, still registers
+                    for (auto const successor : this->targets(number)) {
+                        auto& target = this->blocks[successor];
+
+                        for (std::size_t slot = 0; slot < target.predecessors.size(); ++slot) {
+                            if (target.predecessors[slot] != number)
+                                continue;
+
+                            for (auto& node : target.phis)
+                                node.sources[slot] = names[static_cast<std::size_t>(node.sources[slot])].back();
+                        }
+                    }
+                },
+                [&](std::size_t) {
+                    while (pushed.size() > marks.back()) {
+                        names[pushed.back()].pop_back();
+                        pushed.pop_back();
+                    }
+
+                    marks.pop_back();
+                });
+
+            for (auto& current : this->blocks)
+                std::erase_if(current.code, [](instruction const& code) { return code.op == opcode::NOP; });
+        }
+
+        // whether each value is a float, as far as what writes it tells
+        auto reals() -> std::vector<bool>
+        {
+            std::vector<bool> found(static_cast<std::size_t>(this->next), false);
+
+            for (auto changed = true; changed;) {
+                changed = false;
+
+                auto const mark = [&](value v, bool real) {
+                    if (real && !found[static_cast<std::size_t>(v)]) {
+                        found[static_cast<std::size_t>(v)] = true;
+                        changed                            = true;
+                    }
+                };
+
+                for (auto const number : this->order) {
+                    for (auto const& node : this->blocks[number].phis) {
+                        for (auto const source : node.sources)
+                            mark(node.dst, found[static_cast<std::size_t>(source)]);
+                    }
+
+                    for (auto const& code : this->blocks[number].code) {
+                        if ((code.op >= opcode::FADD && code.op <= opcode::FDIV) || code.op == opcode::LOADF
+                            || code.op == opcode::I2F || code.op == opcode::FINPUT)
+                            mark(code.c, true);
+                        else if (code.op == opcode::I2I)
+                            mark(code.c, found[static_cast<std::size_t>(code.a)]);
+                    }
+                }
+            }
+
+            return found;
+        }
+
+        // after Wegman and Zadeck: values are unknown until found to be a
+        // constant, or anything, and blocks are only visited once reached
+        // through an edge that can be taken
+        auto propagate_constants() -> void
+        {
+            enum class level { UNKNOWN, CONSTANT, ANY };
+
+            struct cell {
+                level        state    = level::UNKNOWN;
+                std::int32_t constant = 0;
+
+                auto operator==(cell const&) const -> bool = default;
+            };
+
+            struct site {
+                std::size_t block;
+                std::size_t index;
+                bool        phi;
+            };
+
+            auto const count = this->blocks.size();
+
+            std::vector<cell>                     cells(static_cast<std::size_t>(this->next));
+            std::vector<std::vector<site>>        uses(static_cast<std::size_t>(this->next));
+            std::vector<std::vector<bool>>        taken(count); // each edge into a block
+            std::vector<bool>                     reached(count, false);
+            std::vector<std::pair<std::size_t, std::size_t>> flow; // blocks and the edges newly taken into them
+            std::vector<value>                    changed;
+
+            for (value p = 0; p < static_cast<value>(this->function.parameters); ++p)
+                cells[static_cast<std::size_t>(p)].state = level::ANY;
+
+            for (auto const number : this->order) {
+                auto& current = this->blocks[number];
+
+                taken[number].assign(current.predecessors.size(), false);
+
+                for (std::size_t i = 0; i < current.phis.size(); ++i) {
+                    for (auto const source : current.phis[i].sources)
+                        uses[static_cast<std::size_t>(source)].push_back({ number, i, true });
+                }
+
+                for (std::size_t i = 0; i < current.code.size(); ++i) {
+                    each_read(current.code[i], this->function.arguments,
+                        [&](value& read) { uses[static_cast<std::size_t>(read)].push_back({ number, i, false }); });
+                }
+            }
+
+            auto const meet = [](cell a, cell b) {
+                if (a.state == level::UNKNOWN)
+                    return b;
+
+                if (b.state == level::UNKNOWN)
+                    return a;
+
+                if (a.state == level::CONSTANT && b.state == level::CONSTANT && a.constant == b.constant)
+                    return a;
+
+                return cell { level::ANY };
+            };
+
+            auto const lower = [&](value v, cell to) {
+                auto& current = cells[static_cast<std::size_t>(v)];
+                auto  merged  = meet(current, to);
+
+                if (merged != current) {
+                    current = merged;
+                    changed.push_back(v);
+                }
+            };
+
+            auto const take = [&](std::size_t from, std::size_t to) {
+                auto const& predecessors = this->blocks[to].predecessors;
+
+                for (std::size_t slot = 0; slot < predecessors.size(); ++slot) {
+                    if (predecessors[slot] == from && !taken[to][slot]) {
+                        taken[to][slot] = true;
+                        flow.emplace_back(to, slot);
+                    }
+                }
+            };
+
+            auto const visit_phi = [&](std::size_t number, std::size_t index) {
+                auto const& node = this->blocks[number].phis[index];
+
+                cell result;
+
+                for (std::size_t slot = 0; slot < node.sources.size(); ++slot) {
+                    if (taken[number][slot])
+                        result = meet(result, cells[static_cast<std::size_t>(node.sources[slot])]);
+                }
+
+                lower(node.dst, result);
+            };
+
+            auto const visit = [&](std::size_t number, std::size_t index) {
+                auto& code = this->blocks[number].code[index];
+
+                if (code.op == opcode::JUMPI) {
+                    take(number, static_cast<std::size_t>(code.a));
+                } else if (code.op == opcode::CBR) {
+                    auto const condition = cells[static_cast<std::size_t>(code.a)];
+
+                    if (condition.state == level::ANY || condition.constant != 0)
+                        take(number, static_cast<std::size_t>(code.b));
+
+                    if (condition.state == level::ANY || condition.constant == 0)
+                        take(number, static_cast<std::size_t>(code.c));
+                } else if (auto const target = written(code)) {
+                    if (!pure(code.op) && code.op != opcode::DIV && code.op != opcode::MOD) {
+                        lower(*target, { level::ANY });
+                        return;
+                    }
+
+                    // the operands, registers or not, as cells
+                    auto const of = [&](value v) { return cells[static_cast<std::size_t>(v)]; };
+
+                    auto const registers = code.op <= opcode::FCMP_NE                         ? 2
+                        : (code.op <= opcode::RSUBI || code.op >= opcode::I2I) ? 1
+                                                                               : 0;
+
+                    auto const a = registers >= 1 ? of(code.a) : cell { level::CONSTANT, code.a };
+                    auto const b = registers == 2 ? of(code.b) : cell { level::CONSTANT, code.b };
+
+                    // anything times zero is zero
+                    auto const zero = [](cell operand) { return operand.state == level::CONSTANT && operand.constant == 0; };
+
+                    if ((code.op == opcode::MULT || code.op == opcode::MULTI) && (zero(a) || zero(b))) {
+                        lower(*target, { level::CONSTANT, 0 });
+                    } else if (a.state == level::ANY || b.state == level::ANY) {
+                        lower(*target, { level::ANY });
+                    } else if (a.state == level::CONSTANT && b.state == level::CONSTANT) {
+                        auto const result = evaluate(code.op, a.constant, b.constant);
+
+                        lower(*target, result ? cell { level::CONSTANT, *result } : cell { level::ANY });
+                    }
+                }
+            };
+
+            reached[0] = true;
+
+            for (std::size_t i = 0; i < this->blocks[0].code.size(); ++i)
+                visit(0, i);
+
+            while (!flow.empty() || !changed.empty()) {
+                while (!flow.empty()) {
+                    auto const [number, slot] = flow.back();
+
+                    flow.pop_back();
+
+                    for (std::size_t i = 0; i < this->blocks[number].phis.size(); ++i)
+                        visit_phi(number, i);
+
+                    if (!reached[number]) {
+                        reached[number] = true;
+
+                        for (std::size_t i = 0; i < this->blocks[number].code.size(); ++i)
+                            visit(number, i);
+                    }
+                }
+
+                while (!changed.empty()) {
+                    auto const v = changed.back();
+
+                    changed.pop_back();
+
+                    for (auto const& use : uses[static_cast<std::size_t>(v)]) {
+                        if (!reached[use.block])
+                            continue;
+
+                        if (use.phi)
+                            visit_phi(use.block, use.index);
+                        else
+                            visit(use.block, use.index);
+                    }
+                }
+            }
+
+            // branches decided, and the edges never taken out
+            for (auto const number : this->order) {
+                auto& last = this->blocks[number].code.back();
+
+                if (!reached[number] || last.op != opcode::CBR)
+                    continue;
+
+                auto const condition = cells[static_cast<std::size_t>(last.a)];
+
+                if (condition.state != level::CONSTANT)
+                    continue;
+
+                auto const kept    = static_cast<std::size_t>(condition.constant != 0 ? last.b : last.c);
+                auto const dropped = static_cast<std::size_t>(condition.constant != 0 ? last.c : last.b);
+
+                last = { opcode::JUMPI, static_cast<value>(kept) };
+
+                this->drop_edge(number, dropped);
+                ++this->counts.branches;
+            }
+
+            auto const real = this->reals();
+
+            auto const load = [&](value v) -> instruction {
+                auto const constant = cells[static_cast<std::size_t>(v)].constant;
+
+                return { real[static_cast<std::size_t>(v)] ? opcode::LOADF : opcode::LOADI, constant, 0, v };
+            };
+
+            auto const constant = [&](value v) { return cells[static_cast<std::size_t>(v)].state == level::CONSTANT; };
+
+            for (auto const number : this->order) {
+                auto& current = this->blocks[number];
+
+                std::vector<instruction> loads;
+
+                std::erase_if(current.phis, [&](phi const& node) {
+                    if (!constant(node.dst))
+                        return false;
+
+                    loads.push_back(load(node.dst));
+                    return true;
+                });
+
+                for (auto& code : current.code) {
+                    // a constant index in bounds is a constant offset, with nothing to check
+                    if ((code.op == opcode::LOADAO || code.op == opcode::STOREAO) && constant(code.b)) {
+                        auto const offset = cells[static_cast<std::size_t>(code.b)].constant;
+
+                        if (offset >= 0 && static_cast<std::uint32_t>(offset) < this->globals) {
+                            code.op = code.op == opcode::LOADAO ? opcode::LOADAI : opcode::STOREAI;
+                            code.b  = offset;
+
+                            ++this->counts.constants;
+                        }
+                    }
+
+                    auto const target = written(code);
+
+                    if (target == nullptr || !constant(*target) || code.op == opcode::LOADI || code.op == opcode::LOADF)
+                        continue;
+
+                    code = load(*target);
+                    ++this->counts.constants;
+                }
+
+                this->counts.constants += loads.size();
+
+                current.code.insert(current.code.begin(), loads.begin(), loads.end());
+            }
+
+            this->counts.unreachable += this->analyze();
+        }
+
+        // after Briggs, Cooper and Simpson: a table of what was computed,
+        // scoped by the dominator tree, each value renamed to the first one
+        // found to be the same
+        auto number_values() -> void
+        {
+            std::vector<value> same(static_cast<std::size_t>(this->next));
+
+            std::iota(same.begin(), same.end(), value { 0 });
+
+            auto const find = [&](value v) {
+                while (same[static_cast<std::size_t>(v)] != v)
+                    v = same[static_cast<std::size_t>(v)] = same[static_cast<std::size_t>(same[static_cast<std::size_t>(v)])];
+
+                return v;
+            };
+
+            auto const rename = [&](value& read) { read = find(read); };
+
+            std::unordered_map<expression, value, expression_hash> table;
+
+            std::vector<expression>  added; // to the table, to be taken out on leaving
+            std::vector<std::size_t> marks;
+
+            this->walk(
+                [&](std::size_t number) {
+                    auto& current = this->blocks[number];
+
+                    marks.push_back(added.size());
+
+                    // phis reading a single value, or the same as another
+                    for (std::size_t i = 0; i < current.phis.size();) {
+                        auto& node = current.phis[i];
+
+                        std::ranges::for_each(node.sources, rename);
+
+                        auto only = value { -1 };
+                        auto many = false;
+
+                        for (auto const source : node.sources) {
+                            if (source != node.dst && only != -1 && source != only)
+                                many = true;
+                            else if (source != node.dst)
+                                only = source;
+                        }
+
+                        auto const twin = std::ranges::find_if(current.phis.begin(), current.phis.begin() + static_cast<std::ptrdiff_t>(i),
+                            [&](phi const& other) { return other.sources == node.sources; });
+
+                        if (!many && only != -1) {
+                            same[static_cast<std::size_t>(node.dst)] = only;
+                        } else if (twin != current.phis.begin() + static_cast<std::ptrdiff_t>(i)) {
+                            same[static_cast<std::size_t>(node.dst)] = twin->dst;
+                        } else {
+                            ++i;
+                            continue;
+                        }
+
+                        current.phis.erase(current.phis.begin() + static_cast<std::ptrdiff_t>(i));
+                        ++this->counts.redundant;
+                    }
+
+                    for (auto& code : current.code) {
+                        each_read(code, this->function.arguments, rename);
+
+                        if (!pure(code.op))
+                            continue;
+
+                        // the operands as they are, registers or constants
+                        expression key { code.op, code.a, code.op <= opcode::RSUBI ? code.b : 0 };
+
+                        if (commutes(code.op) && key.a > key.b)
+                            std::swap(key.a, key.b);
+
+                        if (auto const found = table.find(key); found != table.end()) {
+                            same[static_cast<std::size_t>(code.c)] = found->second;
+                            code.op                               = opcode::NOP;
+
+                            ++this->counts.redundant;
+                            continue;
+                        }
+
+                        table.emplace(key, code.c);
+                        added.push_back(key);
+                    }
+
+                    std::erase_if(current.code, [](instruction const& code) { return code.op == opcode::NOP; });
+
+                    for (auto const successor : this->targets(number)) {
+                        auto& target = this->blocks[successor];
+
+                        for (std::size_t slot = 0; slot < target.predecessors.size(); ++slot) {
+                            if (target.predecessors[slot] == number) {
+                                for (auto& node : target.phis)
+                                    rename(node.sources[slot]);
+                            }
+                        }
+                    }
+                },
+                [&](std::size_t) {
+                    while (added.size() > marks.back()) {
+                        table.erase(added.back());
+                        added.pop_back();
+                    }
+
+                    marks.pop_back();
+                });
+
+            // reads through back edges may only have been found the same after
+            for (auto const number : this->order) {
+                for (auto& node : this->blocks[number].phis)
+                    std::ranges::for_each(node.sources, rename);
+
+                for (auto& code : this->blocks[number].code)
+                    each_read(code, this->function.arguments, rename);
+            }
+        }
+
+        // whether each value is loaded as a constant other than zero, which
+        // can be divided by with nothing to fear
+        auto divisors() -> std::vector<bool>
+        {
+            std::vector<bool> found(static_cast<std::size_t>(this->next), false);
+
+            for (auto const number : this->order) {
+                for (auto const& code : this->blocks[number].code) {
+                    if (code.op == opcode::LOADI && code.a != 0)
+                        found[static_cast<std::size_t>(code.c)] = true;
+                }
+            }
+
+            return found;
+        }
+
+        // the natural loops, as their headers and the blocks in each
+        auto loops() const -> std::vector<std::pair<std::size_t, std::vector<bool>>>
+        {
+            std::vector<std::pair<std::size_t, std::vector<bool>>> found;
+
+            for (auto const number : this->order) {
+                for (auto const header : this->targets(number)) {
+                    if (!this->dominates(header, number))
+                        continue;
+
+                    auto loop = std::ranges::find(found, header, &std::pair<std::size_t, std::vector<bool>>::first);
+
+                    if (loop == found.end()) {
+                        found.emplace_back(header, std::vector<bool>(this->blocks.size(), false));
+
+                        loop = found.end() - 1;
+                        loop->second[header] = true;
+                    }
+
+                    auto& body = loop->second;
+
+                    std::vector<std::size_t> work;
+
+                    if (!body[number]) {
+                        body[number] = true;
+                        work.push_back(number);
+                    }
+
+                    while (!work.empty()) {
+                        auto const at = work.back();
+
+                        work.pop_back();
+
+                        for (auto const predecessor : this->blocks[at].predecessors) {
+                            if (!body[predecessor]) {
+                                body[predecessor] = true;
+                                work.push_back(predecessor);
+                            }
+                        }
+                    }
+                }
+            }
+
+            return found;
+        }
+
+        // a block right before header, its only way in from outside body
+        auto preheader(std::size_t header, std::vector<bool> const& body) -> bool
+        {
+            auto const predecessors = this->blocks[header].predecessors;
+
+            std::vector<std::size_t> inside, outside; // slots
+
+            for (std::size_t slot = 0; slot < predecessors.size(); ++slot)
+                (body[predecessors[slot]] ? inside : outside).push_back(slot);
+
+            if (outside.size() == 1 && this->successors(predecessors[outside[0]]).size() == 1)
+                return false;
+
+            auto const added = this->blocks.size();
+
+            this->blocks.emplace_back();
+
+            auto& before = this->blocks[added];
+            auto& target = this->blocks[header];
+
+            before.code.push_back({ opcode::JUMPI, static_cast<value>(header) });
+
+            for (auto const slot : outside) {
+                auto const from = predecessors[slot];
+                auto&      last = this->blocks[from].code.back();
+
+                if (last.op == opcode::JUMPI) {
+                    last.a = static_cast<value>(added);
+                } else {
+                    last.b = last.b == static_cast<value>(header) ? static_cast<value>(added) : last.b;
+                    last.c = last.c == static_cast<value>(header) ? static_cast<value>(added) : last.c;
+                }
+
+                before.predecessors.push_back(from);
+            }
+
+            for (auto& node : target.phis) {
+                std::vector<value> sources;
+
+                for (auto const slot : inside)
+                    sources.push_back(node.sources[slot]);
+
+                if (outside.size() == 1) {
+                    sources.push_back(node.sources[outside[0]]);
+                } else {
+                    phi merged { this->fresh(), {} };
+
+                    for (auto const slot : outside)
+                        merged.sources.push_back(node.sources[slot]);
+
+                    sources.push_back(merged.dst);
+                    before.phis.push_back(std::move(merged));
+                }
+
+                node.sources = std::move(sources);
+            }
+
+            target.predecessors.clear();
+
+            for (auto const slot : inside)
+                target.predecessors.push_back(predecessors[slot]);
+
+            target.predecessors.push_back(added);
+
+            this->layout.insert(std::ranges::find(this->layout, header), added);
+
+            return true;
+        }
+
+        // what computes the same in every trip around a loop is moved to its
+        // preheader, the inner loops first so what they move out can be moved
+        // further out by those around them
+        auto hoist_invariants() -> void
+        {
+            auto found = this->loops();
+            auto added = false;
+
+            for (auto const& [header, body] : found)
+                added = this->preheader(header, body) || added;
+
+            if (added) {
+                this->analyze();
+                found = this->loops();
+            }
+
+            std::ranges::sort(found, {}, [](auto const& loop) { return std::ranges::count(loop.second, true); });
+
+            // where each value is written
+            std::vector<std::size_t> where(static_cast<std::size_t>(this->next), 0);
+
+            for (auto const number : this->order) {
+                for (auto const& node : this->blocks[number].phis)
+                    where[static_cast<std::size_t>(node.dst)] = number;
+
+                for (auto& code : this->blocks[number].code) {
+                    if (auto const target = written(code))
+                        where[static_cast<std::size_t>(*target)] = number;
+                }
+            }
+
+            auto const safe = this->divisors();
+
+            for (auto const& [header, body] : found) {
+                auto const before = *std::ranges::find_if(this->blocks[header].predecessors, [&](std::size_t p) { return !body[p]; });
+
+                // loads from globals stay put if anything in the loop could write them
+                auto stores = false;
+
+                for (auto const number : this->order) {
+                    if (!body[number])
+                        continue;
+
+                    for (auto const& code : this->blocks[number].code) {
+                        if (code.op == opcode::STOREAI || code.op == opcode::STOREAO || code.op == opcode::CALL)
+                            stores = true;
+                    }
+                }
+
+                for (auto moved = true; moved;) {
+                    moved = false;
+
+                    for (auto const number : this->order) {
+                        if (!body[number])
+                            continue;
+
+                        auto& code = this->blocks[number].code;
+
+                        for (std::size_t i = 0; i < code.size();) {
+                            auto line = code[i];
+
+                            auto invariant = pure(line.op) || (line.op == opcode::LOADAI && !stores)
+                                || ((line.op == opcode::DIV || line.op == opcode::MOD) && safe[static_cast<std::size_t>(line.b)]);
+
+                            each_read(line, this->function.arguments,
+                                [&](value& read) { invariant = invariant && !body[where[static_cast<std::size_t>(read)]]; });
+
+                            if (!invariant) {
+                                ++i;
+                                continue;
+                            }
+
+                            auto& destination = this->blocks[before].code;
+
+                            destination.insert(destination.end() - 1, line);
+                            code.erase(code.begin() + static_cast<std::ptrdiff_t>(i));
+
+                            where[static_cast<std::size_t>(line.c)] = before;
+                            moved                                   = true;
+
+                            ++this->counts.hoisted;
+                        }
+                    }
+                }
+            }
+        }
+
+        // jumps to blocks doing nothing but jumping go straight to where those
+        // lead, unless the phis there tell where they came from. a branch
+        // going the same way on both sides becomes a jump
+        auto thread_jumps() -> void
+        {
+            for (auto const number : this->order) {
+                auto& last = this->blocks[number].code.back();
+
+                auto const through = [&](value& target) {
+                    for (std::size_t steps = 0; steps < this->blocks.size(); ++steps) {
+                        auto const& passed = this->blocks[static_cast<std::size_t>(target)];
+
+                        if (passed.code.size() != 1 || passed.code[0].op != opcode::JUMPI || !passed.phis.empty())
+                            break;
+
+                        auto const next = static_cast<std::size_t>(passed.code[0].a);
+
+                        if (!this->blocks[next].phis.empty() || next == static_cast<std::size_t>(target))
+                            break;
+
+                        this->drop_edge(number, static_cast<std::size_t>(target));
+                        this->blocks[next].predecessors.push_back(number);
+
+                        target = static_cast<value>(next);
+                    }
+                };
+
+                if (last.op == opcode::JUMPI) {
+                    through(last.a);
+                } else if (last.op == opcode::CBR) {
+                    through(last.b);
+                    through(last.c);
+
+                    if (last.b == last.c) {
+                        last = { opcode::JUMPI, last.b };
+
+                        this->drop_edge(number, static_cast<std::size_t>(last.a));
+                    }
+                }
+            }
+
+            this->analyze();
+        }
+
+        // marking from what must stay, sweeping what wasn't reached
+        auto remove_dead_code() -> void
+        {
+            struct site {
+                std::size_t block = none;
+                std::size_t index = 0;
+                bool        phi   = false;
+            };
+
+            auto const safe = this->divisors();
+
+            // divisions by a constant other than zero can't go wrong
+            auto const stays = [&](instruction const& code) {
+                return effects(code.op)
+                    && !((code.op == opcode::DIV || code.op == opcode::MOD) && safe[static_cast<std::size_t>(code.b)]);
+            };
+
+            std::vector<site>  writer(static_cast<std::size_t>(this->next));
+            std::vector<bool>  live(static_cast<std::size_t>(this->next), false);
+            std::vector<value> work;
+
+            auto const mark = [&](value& read) {
+                if (!live[static_cast<std::size_t>(read)]) {
+                    live[static_cast<std::size_t>(read)] = true;
+                    work.push_back(read);
+                }
+            };
+
+            for (auto const number : this->order) {
+                auto& current = this->blocks[number];
+
+                for (std::size_t i = 0; i < current.phis.size(); ++i)
+                    writer[static_cast<std::size_t>(current.phis[i].dst)] = { number, i, true };
+
+                for (std::size_t i = 0; i < current.code.size(); ++i) {
+                    auto& code = current.code[i];
+
+                    if (auto const target = written(code))
+                        writer[static_cast<std::size_t>(*target)] = { number, i, false };
+
+                    if (stays(code))
+                        each_read(code, this->function.arguments, mark);
+                }
+            }
+
+            while (!work.empty()) {
+                auto const [number, index, is_phi] = writer[static_cast<std::size_t>(work.back())];
+
+                work.pop_back();
+
+                if (number == none)
+                    continue;
+
+                if (is_phi)
+                    std::ranges::for_each(this->blocks[number].phis[index].sources, mark);
+                else
+                    each_read(this->blocks[number].code[index], this->function.arguments, mark);
+            }
+
+            for (auto const number : this->order) {
+                auto& current = this->blocks[number];
+
+                this->counts.dead += std::erase_if(current.phis, [&](phi const& node) { return !live[static_cast<std::size_t>(node.dst)]; });
+
+                this->counts.dead += std::erase_if(current.code, [&](instruction& code) {
+                    auto const target = written(code);
+
+                    return target != nullptr && !stays(code) && !live[static_cast<std::size_t>(*target)];
+                });
+            }
+        }
+
+        // where each value is live in, for those written by phis, walking
+        // back from where they are read
+        auto live_phis() const -> std::vector<std::vector<bool>>
+        {
+            std::vector<std::vector<bool>> live(static_cast<std::size_t>(this->next));
+            std::vector<std::size_t>       writer(static_cast<std::size_t>(this->next), none);
+
+            for (auto const number : this->order) {
+                for (auto const& node : this->blocks[number].phis) {
+                    live[static_cast<std::size_t>(node.dst)].assign(this->blocks.size(), false);
+                    writer[static_cast<std::size_t>(node.dst)] = number;
+                }
+            }
+
+            std::vector<std::size_t> work;
+
+            // v is live in at, and so at the end of its predecessors, up to where it's written
+            auto const reach = [&](value v, std::size_t at) {
+                auto& in = live[static_cast<std::size_t>(v)];
+
+                if (in.empty() || at == writer[static_cast<std::size_t>(v)] || in[at])
+                    return;
+
+                in[at] = true;
+                work.push_back(at);
+
+                while (!work.empty()) {
+                    auto const next = work.back();
+
+                    work.pop_back();
+
+                    for (auto const predecessor : this->blocks[next].predecessors) {
+                        if (predecessor != writer[static_cast<std::size_t>(v)] && !in[predecessor]) {
+                            in[predecessor] = true;
+                            work.push_back(predecessor);
+                        }
+                    }
+                }
+            };
+
+            for (auto const number : this->order) {
+                auto& current = const_cast<block&>(this->blocks[number]);
+
+                for (auto const& node : current.phis) {
+                    for (std::size_t slot = 0; slot < node.sources.size(); ++slot)
+                        reach(node.sources[slot], current.predecessors[slot]);
+                }
+
+                for (auto& code : current.code) {
+                    each_read(code, const_cast<std::vector<value>&>(this->function.arguments),
+                        [&](value& read) { reach(read, number); });
+                }
+            }
+
+            return live;
+        }
+
+        // each phi is written by copies at the end of each predecessor. its
+        // own register can take them when it isn't read after them there (a
+        // copy would be lost), by a phi or otherwise, as then the copies could
+        // depend on their order. otherwise a register of its own takes
+        // them, copied from at the start of the block, so nothing reads what
+        // another copy wrote
+        auto out_of_ssa() -> void
+        {
+            auto const live = this->live_phis();
+
+            for (auto const number : this->order) {
+                auto& current = this->blocks[number];
+
+                std::vector<instruction> copies;
+
+                for (auto const& node : current.phis) {
+                    auto const& in = live[static_cast<std::size_t>(node.dst)];
+
+                    auto shared = true;
+
+                    for (auto const predecessor : current.predecessors) {
+                        auto& last = this->blocks[predecessor].code.back();
+
+                        shared = shared && !(last.op != opcode::JUMPI && last.a == node.dst);
+
+                        for (auto const successor : this->targets(predecessor)) {
+                            shared = shared && !in[successor];
+
+                            for (auto const& other : this->blocks[successor].phis)
+                                shared = shared && std::ranges::find(other.sources, node.dst) == other.sources.end();
+                        }
+                    }
+
+                    auto const between = shared ? node.dst : this->fresh();
+
+                    for (std::size_t slot = 0; slot < node.sources.size(); ++slot) {
+                        auto& code = this->blocks[current.predecessors[slot]].code;
+
+                        code.insert(code.end() - 1, { opcode::I2I, node.sources[slot], 0, between });
+                    }
+
+                    if (!shared)
+                        copies.push_back({ opcode::I2I, between, 0, node.dst });
+                }
+
+                current.phis.clear();
+                current.code.insert(current.code.begin(), copies.begin(), copies.end());
+            }
+        }
+
+        // the blocks back into code, in their original order, dropping jumps
+        // to the block right after and numbering registers and labels again
+        auto lay_out() -> void
+        {
+            std::vector<std::size_t> sequence;
+
+            for (auto const number : this->layout) {
+                if (this->blocks[number].reachable && !this->blocks[number].code.empty())
+                    sequence.push_back(number);
+            }
+
+            std::vector<bool>         falls(this->blocks.size(), false);
+            std::vector<std::int32_t> labels(this->blocks.size(), -1);
+
+            for (std::size_t i = 0; i < sequence.size(); ++i) {
+                auto const& last = this->blocks[sequence[i]].code.back();
+
+                if (last.op == opcode::JUMPI && i + 1 < sequence.size() && static_cast<std::size_t>(last.a) == sequence[i + 1])
+                    falls[sequence[i]] = true;
+                else if (last.op == opcode::JUMPI)
+                    labels[static_cast<std::size_t>(last.a)] = 0;
+                else if (last.op == opcode::CBR)
+                    labels[static_cast<std::size_t>(last.b)] = labels[static_cast<std::size_t>(last.c)] = 0;
+            }
+
+            std::int32_t count = 0;
+
+            for (auto const number : sequence) {
+                if (labels[number] == 0)
+                    labels[number] = ++count;
+            }
+
+            std::vector<value> renamed(static_cast<std::size_t>(this->next), -1);
+            auto               registers = static_cast<value>(this->function.parameters);
+
+            for (value p = 0; p < registers; ++p)
+                renamed[static_cast<std::size_t>(p)] = p;
+
+            auto const rename = [&](value& r) {
+                auto& to = renamed[static_cast<std::size_t>(r)];
+
+                if (to < 0)
+                    to = registers++;
+
+                r = to;
+            };
+
+            std::vector<instruction> code;
+            std::vector<value>       arguments;
+
+            auto const label = [&](std::int32_t number) { return labels[static_cast<std::size_t>(number)] - 1; };
+
+            for (auto const number : sequence) {
+                if (labels[number] > 0)
+                    code.push_back({ opcode::LABEL, labels[number] - 1 });
+
+                auto const& lines = this->blocks[number].code;
+
+                for (auto line : lines | std::views::take(lines.size() - (falls[number] ? 1 : 0))) {
+                    if (line.op == opcode::CALL) {
+                        auto const first = static_cast<std::size_t>(line.b);
+                        auto const given = this->function.arguments[first];
+
+                        line.b = static_cast<value>(arguments.size());
+                        arguments.push_back(given);
+
+                        for (std::size_t i = 1; i <= static_cast<std::size_t>(given); ++i) {
+                            arguments.push_back(this->function.arguments[first + i]);
+                            rename(arguments.back());
+                        }
+                    } else {
+                        each_read(line, arguments, rename);
+                    }
+
+                    if (auto const target = written(line))
+                        rename(*target);
+
+                    if (line.op == opcode::JUMPI) {
+                        line.a = label(line.a);
+                    } else if (line.op == opcode::CBR) {
+                        line.b = label(line.b);
+                        line.c = label(line.c);
+                    }
+
+                    code.push_back(line);
+                }
+            }
+
+            // nothing may run off the end, even if never reached
+            if (code.back().op == opcode::CBR)
+                code.push_back({ opcode::JUMPI, code.back().c });
+
+            this->function.code      = std::move(code);
+            this->function.arguments = std::move(arguments);
+            this->function.labels    = static_cast<std::uint32_t>(count);
+            this->function.registers = static_cast<std::uint32_t>(registers);
+
+            this->counts.after += this->function.code.size();
+        }
+
+        iloc_function&        function;
+        std::uint32_t         globals; // words of memory
+        optimizer_statistics& counts;
+
+        std::vector<block>       blocks;
+        std::vector<std::size_t> layout; // the order blocks are written back in
+        std::vector<std::size_t> order; // reverse post order of the blocks reached
+        std::vector<std::size_t> position; // of each block in order
+
+        std::vector<std::size_t>              dominator; // immediate, of each block
+        std::vector<std::vector<std::size_t>> children; // in the dominator tree
+
+        std::uint32_t registers = 0; // before renaming
+        value         next      = 0;
+    };
+
+}
+
+auto optimizer_statistics::operator+=(optimizer_statistics const& other) -> optimizer_statistics&
+{
+    this->constants += other.constants;
+    this->branches += other.branches;
+    this->unreachable += other.unreachable;
+    this->redundant += other.redundant;
+    this->copies += other.copies;
+    this->hoisted += other.hoisted;
+    this->dead += other.dead;
+    this->before += other.before;
+    this->after += other.after;
+
+    return *this;
+}
+
+auto parse_optimizer_passes(std::string_view list) -> std::optional<optimizer_passes>
+{
+    if (list == "all")
+        return optimizer_passes {};
+
+    auto passes = optimizer_passes::none();
+
+    if (list == "none")
+        return passes;
+
+    while (!list.empty()) {
+        auto const comma = list.find(',');
+        auto const name  = list.substr(0, comma);
+
+        if (name == "sccp")
+            passes.constants = true;
+        else if (name == "gvn")
+            passes.numbering = true;
+        else if (name == "licm")
+            passes.invariants = true;
+        else if (name == "dce")
+            passes.dead_code = true;
+        else
+            return std::nullopt;
+
+        list = comma == std::string_view::npos ? std::string_view {} : list.substr(comma + 1);
+    }
+
+    return passes;
+}
+
+auto optimize_iloc(iloc_program& program, optimizer_passes const& passes) -> optimizer_statistics
+{
+    optimizer_statistics counts;
+
+    if (!passes.constants && !passes.numbering && !passes.invariants && !passes.dead_code) {
+        for (auto const& function : program.functions)
+            counts.before = counts.after += function.code.size();
+
+        return counts;
+    }
+
+    for (auto& function : program.functions)
+        optimizer(function, program.globals, counts).run(passes);
+
+    return counts;
+}
+
+}
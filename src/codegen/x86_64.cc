@@ -0,0 +1,448 @@
+/** @file x86_64.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "x86_64.hh"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+#include <fmt/format.h>
+
+namespace hcpsilva {
+
+namespace {
+
+    constexpr std::array<std::string_view, 6> argument_registers { "%edi", "%esi", "%edx", "%ecx", "%r8d", "%r9d" };
+
+    // the globals, and the formats of scanf and printf
+    constexpr std::string_view globals_symbol = "cc.globals";
+
+    constexpr std::string_view preamble = "    .section .rodata\n"
+                                          ".Lread_int:\n"
+                                          "    .string \"%d\"\n"
+                                          ".Lread_float:\n"
+                                          "    .string \"%f\"\n"
+                                          ".Lwrite_int:\n"
+                                          "    .string \"%d\\n\"\n"
+                                          ".Lwrite_float:\n"
+                                          "    .string \"%g\\n\"\n"
+                                          "    .text\n";
+
+    class emitter {
+    public:
+        emitter(iloc_program const& program, std::FILE* out)
+            : program(program)
+            , out(out)
+        {
+        }
+
+        auto emit() -> void
+        {
+            auto const main = std::ranges::find(this->program.functions, "main", &iloc_function::name);
+
+            if (main == this->program.functions.end())
+                throw std::runtime_error("asm error, there is no function \"main\" to start from\n");
+
+            this->write("{}", preamble);
+
+            // the main of C is the main of the program
+            this->write("    .globl main\n"
+                        "    .type main, @function\n"
+                        "main:\n"
+                        "    jmp fn.main\n"
+                        "    .size main, .-main\n");
+
+            for (std::size_t i = 0; i < this->program.functions.size(); ++i)
+                this->function(i);
+
+            if (this->program.globals > 0)
+                this->write("    .bss\n"
+                            "    .balign 16\n"
+                            "{}:\n"
+                            "    .zero {}\n",
+                    globals_symbol, 4 * std::size_t { this->program.globals });
+
+            this->write("    .section .note.GNU-stack,\"\",@progbits\n");
+
+            this->flush();
+        }
+
+    private:
+        template <typename... arguments>
+        auto write(fmt::format_string<arguments...> format, arguments&&... values) -> void
+        {
+            fmt::format_to(std::back_inserter(this->buffer), format, std::forward<arguments>(values)...);
+
+            // written out a piece at a time, however long the program
+            if (this->buffer.size() > 1 << 16)
+                this->flush();
+        }
+
+        auto flush() -> void
+        {
+            std::fwrite(this->buffer.data(), 1, this->buffer.size(), this->out);
+            this->buffer.clear();
+        }
+
+        // the slot of register number, below the frame pointer
+        auto slot(std::int32_t number) const -> std::string
+        {
+            return fmt::format("{}(%rbp)", -4 * (std::int64_t { number } + 1));
+        }
+
+        auto label(std::int32_t number) const -> std::string
+        {
+            return fmt::format(".L{}_{}", this->index, number);
+        }
+
+        auto function(std::size_t number) -> void
+        {
+            auto const& function = this->program.functions[number];
+
+            this->current = &function;
+            this->index   = number;
+
+            auto const registers = std::max(function.registers, used_registers(function));
+
+            // rsp stays aligned to 16 bytes, the return address and rbp
+            // making up for one another
+            auto const frame = (4 * std::size_t { registers } + 15) / 16 * 16;
+
+            this->write("    .type fn.{0}, @function\n"
+                        "fn.{0}:\n"
+                        "    pushq %rbp\n"
+                        "    movq %rsp, %rbp\n",
+                function.name);
+
+            if (frame > 0)
+                this->write("    subq ${}, %rsp\n", frame);
+
+            for (std::uint32_t i = 0; i < function.parameters; ++i) {
+                if (i < argument_registers.size()) {
+                    this->write("    movl {}, {}\n", argument_registers[i], this->slot(static_cast<std::int32_t>(i)));
+                } else {
+                    this->write("    movl {}(%rbp), %eax\n", 16 + 8 * (i - argument_registers.size()));
+                    this->write("    movl %eax, {}\n", this->slot(static_cast<std::int32_t>(i)));
+                }
+            }
+
+            // the rest starts zeroed, as on the virtual machine
+            if (registers > function.parameters)
+                this->write("    leaq {}, %rdi\n"
+                            "    movl ${}, %ecx\n"
+                            "    xorl %eax, %eax\n"
+                            "    rep stosl\n",
+                    this->slot(static_cast<std::int32_t>(registers) - 1), registers - function.parameters);
+
+            for (auto const& code : function.code)
+                this->instruction(code);
+
+            this->write("    .size fn.{0}, .-fn.{0}\n", function.name);
+        }
+
+        auto instruction(hcpsilva::instruction const& code) -> void
+        {
+            auto const a = [&] { return this->slot(code.a); };
+            auto const b = [&] { return this->slot(code.b); };
+            auto const c = [&] { return this->slot(code.c); };
+
+            switch (code.op) {
+            case opcode::NOP:
+                break;
+            case opcode::ADD:
+                this->integer(a(), "addl", b(), c());
+                break;
+            case opcode::SUB:
+                this->integer(a(), "subl", b(), c());
+                break;
+            case opcode::MULT:
+                this->integer(a(), "imull", b(), c());
+                break;
+            case opcode::DIV:
+            case opcode::MOD:
+                this->write("    movl {}, %eax\n"
+                            "    cltd\n"
+                            "    idivl {}\n"
+                            "    movl {}, {}\n",
+                    a(), b(), code.op == opcode::DIV ? "%eax" : "%edx", c());
+                break;
+            case opcode::CMP_LT:
+                this->compare(a(), b(), "setl", c());
+                break;
+            case opcode::CMP_LE:
+                this->compare(a(), b(), "setle", c());
+                break;
+            case opcode::CMP_EQ:
+                this->compare(a(), b(), "sete", c());
+                break;
+            case opcode::CMP_GE:
+                this->compare(a(), b(), "setge", c());
+                break;
+            case opcode::CMP_GT:
+                this->compare(a(), b(), "setg", c());
+                break;
+            case opcode::CMP_NE:
+                this->compare(a(), b(), "setne", c());
+                break;
+            case opcode::FADD:
+                this->real(a(), "addss", b(), c());
+                break;
+            case opcode::FSUB:
+                this->real(a(), "subss", b(), c());
+                break;
+            case opcode::FMULT:
+                this->real(a(), "mulss", b(), c());
+                break;
+            case opcode::FDIV:
+                this->real(a(), "divss", b(), c());
+                break;
+            // ucomiss sets the carry for unordered values as well, so only
+            // above and above or equal are used, swapping the operands
+            case opcode::FCMP_LT:
+                this->real_compare(b(), a(), "seta", c());
+                break;
+            case opcode::FCMP_LE:
+                this->real_compare(b(), a(), "setae", c());
+                break;
+            case opcode::FCMP_GT:
+                this->real_compare(a(), b(), "seta", c());
+                break;
+            case opcode::FCMP_GE:
+                this->real_compare(a(), b(), "setae", c());
+                break;
+            case opcode::FCMP_EQ:
+                this->write("    movss {}, %xmm0\n"
+                            "    ucomiss {}, %xmm0\n"
+                            "    sete %al\n"
+                            "    setnp %cl\n"
+                            "    andb %cl, %al\n"
+                            "    movzbl %al, %eax\n"
+                            "    movl %eax, {}\n",
+                    a(), b(), c());
+                break;
+            case opcode::FCMP_NE:
+                this->write("    movss {}, %xmm0\n"
+                            "    ucomiss {}, %xmm0\n"
+                            "    setne %al\n"
+                            "    setp %cl\n"
+                            "    orb %cl, %al\n"
+                            "    movzbl %al, %eax\n"
+                            "    movl %eax, {}\n",
+                    a(), b(), c());
+                break;
+            case opcode::ADDI:
+                this->write("    movl {}, %eax\n"
+                            "    addl ${}, %eax\n"
+                            "    movl %eax, {}\n",
+                    a(), code.b, c());
+                break;
+            case opcode::MULTI:
+                this->write("    imull ${}, {}, %eax\n"
+                            "    movl %eax, {}\n",
+                    code.b, a(), c());
+                break;
+            case opcode::RSUBI:
+                this->write("    movl ${}, %eax\n"
+                            "    subl {}, %eax\n"
+                            "    movl %eax, {}\n",
+                    code.b, a(), c());
+                break;
+            case opcode::LOADI:
+            case opcode::LOADF:
+                this->write("    movl ${}, {}\n", code.a, c());
+                break;
+            case opcode::I2I:
+                this->write("    movl {}, %eax\n"
+                            "    movl %eax, {}\n",
+                    a(), c());
+                break;
+            case opcode::I2F:
+                this->write("    cvtsi2ssl {}, %xmm0\n"
+                            "    movss %xmm0, {}\n",
+                    a(), c());
+                break;
+            case opcode::F2I:
+                this->write("    cvttss2si {}, %eax\n"
+                            "    movl %eax, {}\n",
+                    a(), c());
+                break;
+            case opcode::LOADAI:
+                this->base(code.a);
+                this->write("    movl {}+{}(%rip), %eax\n"
+                            "    movl %eax, {}\n",
+                    globals_symbol, 4 * std::int64_t { code.b }, c());
+                break;
+            case opcode::LOADAO:
+                this->base(code.a);
+                this->write("    movslq {}, %rax\n"
+                            "    leaq {}(%rip), %rdx\n"
+                            "    movl (%rdx,%rax,4), %eax\n"
+                            "    movl %eax, {}\n",
+                    b(), globals_symbol, c());
+                break;
+            case opcode::STOREAI:
+                this->base(code.a);
+                this->write("    movl {}, %eax\n"
+                            "    movl %eax, {}+{}(%rip)\n",
+                    c(), globals_symbol, 4 * std::int64_t { code.b });
+                break;
+            case opcode::STOREAO:
+                this->base(code.a);
+                this->write("    movslq {}, %rax\n"
+                            "    leaq {}(%rip), %rdx\n"
+                            "    movl {}, %ecx\n"
+                            "    movl %ecx, (%rdx,%rax,4)\n",
+                    b(), globals_symbol, c());
+                break;
+            case opcode::JUMPI:
+                this->write("    jmp {}\n", this->label(code.a));
+                break;
+            case opcode::CBR:
+                this->write("    cmpl $0, {}\n"
+                            "    jne {}\n"
+                            "    jmp {}\n",
+                    a(), this->label(code.b), this->label(code.c));
+                break;
+            case opcode::LABEL:
+                this->write("{}:\n", this->label(code.a));
+                break;
+            case opcode::CALL:
+                this->call(code);
+                break;
+            case opcode::RET:
+                this->write("    movl {}, %eax\n"
+                            "    leave\n"
+                            "    ret\n",
+                    a());
+                break;
+            case opcode::INPUT:
+            case opcode::FINPUT:
+                this->write("    leaq {}, %rsi\n"
+                            "    leaq {}(%rip), %rdi\n"
+                            "    xorl %eax, %eax\n"
+                            "    call scanf@PLT\n",
+                    c(), code.op == opcode::INPUT ? ".Lread_int" : ".Lread_float");
+                break;
+            case opcode::OUTPUT:
+                this->write("    movl {}, %esi\n"
+                            "    leaq .Lwrite_int(%rip), %rdi\n"
+                            "    xorl %eax, %eax\n"
+                            "    call printf@PLT\n",
+                    a());
+                break;
+            case opcode::FOUTPUT:
+                // variadic, so the float goes as a double, and al tells how
+                // many vector registers are used
+                this->write("    cvtss2sd {}, %xmm0\n"
+                            "    leaq .Lwrite_float(%rip), %rdi\n"
+                            "    movl $1, %eax\n"
+                            "    call printf@PLT\n",
+                    a());
+                break;
+            }
+        }
+
+        auto integer(std::string const& lhs, std::string_view op, std::string const& rhs, std::string const& result)
+            -> void
+        {
+            this->write("    movl {}, %eax\n"
+                        "    {} {}, %eax\n"
+                        "    movl %eax, {}\n",
+                lhs, op, rhs, result);
+        }
+
+        auto compare(std::string const& lhs, std::string const& rhs, std::string_view set, std::string const& result)
+            -> void
+        {
+            this->write("    movl {}, %eax\n"
+                        "    cmpl {}, %eax\n"
+                        "    {} %al\n"
+                        "    movzbl %al, %eax\n"
+                        "    movl %eax, {}\n",
+                lhs, rhs, set, result);
+        }
+
+        auto real(std::string const& lhs, std::string_view op, std::string const& rhs, std::string const& result) -> void
+        {
+            this->write("    movss {}, %xmm0\n"
+                        "    {} {}, %xmm0\n"
+                        "    movss %xmm0, {}\n",
+                lhs, op, rhs, result);
+        }
+
+        auto real_compare(std::string const& lhs, std::string const& rhs, std::string_view set, std::string const& result)
+            -> void
+        {
+            this->write("    movss {}, %xmm0\n"
+                        "    ucomiss {}, %xmm0\n"
+                        "    {} %al\n"
+                        "    movzbl %al, %eax\n"
+                        "    movl %eax, {}\n",
+                lhs, rhs, set, result);
+        }
+
+        auto call(hcpsilva::instruction const& code) -> void
+        {
+            auto const& arguments = this->current->arguments;
+            auto const& callee    = this->program.functions[static_cast<std::size_t>(code.a)];
+
+            auto const count   = static_cast<std::size_t>(arguments[static_cast<std::size_t>(code.b)]);
+            auto const first   = static_cast<std::size_t>(code.b) + 1;
+            auto const stacked = count > argument_registers.size() ? count - argument_registers.size() : 0;
+
+            // rsp must be aligned to 16 bytes at the call
+            auto const padding = stacked % 2 == 1 ? 8 : 0;
+
+            if (padding != 0)
+                this->write("    subq $8, %rsp\n");
+
+            for (auto i = count; i-- > argument_registers.size();)
+                this->write("    movl {}, %eax\n"
+                            "    pushq %rax\n",
+                    this->slot(arguments[first + i]));
+
+            for (std::size_t i = 0; i < std::min(count, argument_registers.size()); ++i)
+                this->write("    movl {}, {}\n", this->slot(arguments[first + i]), argument_registers[i]);
+
+            this->write("    call fn.{}\n", callee.name);
+
+            if (stacked > 0 || padding != 0)
+                this->write("    addq ${}, %rsp\n", 8 * stacked + padding);
+
+            this->write("    movl %eax, {}\n", this->slot(code.c));
+        }
+
+        auto base(std::int32_t number) const -> void
+        {
+            if (number != rbss)
+                throw std::runtime_error(fmt::format(
+                    "asm error, function \"{}\": memory can only be addressed from rbss, not r{}\n", this->current->name, number));
+        }
+
+        iloc_program const&  program;
+        std::FILE*           out;
+        fmt::memory_buffer   buffer;
+        iloc_function const* current = nullptr;
+        std::size_t          index   = 0;
+    };
+
+}
+
+auto print_x86_64(iloc_program const& program, std::FILE* out) -> void
+{
+    emitter(program, out).emit();
+}
+
+}
@@ -0,0 +1,187 @@
+/** @file cpp-compiler-client.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Asks a compiler started with --serve about a file (see compile_server.hh),
+ * writing the answer out as the compiler itself would have: the output to the
+ * standard output, the error messages to the standard error and the status as
+ * the exit code. Only the socket is linked in, nothing of the compiler, so it
+ * starts as fast as a process can. The server is found at --socket, or else
+ * where default_socket_path says.
+ *
+ *     cpp-compiler-client [--socket SOCKET] [-f legacy|dot|edges] parse|ast|diagnostics FILE
+ *     cpp-compiler-client [--socket SOCKET] shutdown
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+#include "compile_server.hh"
+
+namespace {
+
+auto usage() -> int
+{
+    fmt::print(stderr, "usage: cpp-compiler-client [--socket SOCKET] [-f legacy|dot|edges] parse|ast|diagnostics FILE\n"
+                       "       cpp-compiler-client [--socket SOCKET] shutdown\n");
+
+    return 2;
+}
+
+// sends request, and gives everything answered to it
+auto ask(std::string const& socket_path, std::string const& request) -> std::string
+{
+    sockaddr_un address {};
+
+    if (socket_path.size() >= sizeof address.sun_path)
+        throw std::runtime_error(fmt::format("driver error, socket path \"{}\" is too long\n", socket_path));
+
+    // a server of another user would be told which files we compile, and
+    // could answer anything at all
+    if (!hcpsilva::socket_path_trusted(socket_path))
+        throw std::runtime_error(fmt::format("driver error, \"{}\" is not a socket of this user\n", socket_path));
+
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+
+    auto const connection = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (connection < 0 || connect(connection, reinterpret_cast<sockaddr const*>(&address), sizeof address) != 0) {
+        auto const reason = std::strerror(errno);
+
+        if (connection >= 0)
+            close(connection);
+
+        throw std::runtime_error(fmt::format("driver error, could not reach a server on \"{}\": {}\n", socket_path, reason));
+    }
+
+    std::string_view pending = request;
+    std::string      answer;
+
+    while (!pending.empty()) {
+        auto const sent = send(connection, pending.data(), pending.size(), MSG_NOSIGNAL);
+
+        if (sent < 0 && errno == EINTR)
+            continue;
+
+        if (sent <= 0)
+            break;
+
+        pending.remove_prefix(static_cast<std::size_t>(sent));
+    }
+
+    char buffer[1 << 16];
+
+    for (;;) {
+        auto const received = recv(connection, buffer, sizeof buffer, 0);
+
+        if (received < 0 && errno == EINTR)
+            continue;
+
+        if (received <= 0)
+            break;
+
+        answer.append(buffer, static_cast<std::size_t>(received));
+    }
+
+    close(connection);
+
+    return answer;
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    auto socket_path = hcpsilva::default_socket_path();
+    auto format      = std::string("legacy");
+
+    std::string_view command;
+    std::string      file;
+
+    for (auto i = 1; i < argc; ++i) {
+        std::string_view const argument = argv[i];
+
+        if (argument == "--socket") {
+            if (++i == argc)
+                return usage();
+
+            socket_path = argv[i];
+        } else if (argument == "-f" || argument == "--format") {
+            if (++i == argc)
+                return usage();
+
+            format = argv[i];
+        } else if (argument.starts_with("-")) {
+            return usage();
+        } else if (command.empty()) {
+            command = argument;
+        } else if (file.empty()) {
+            file = argument;
+        } else {
+            return usage();
+        }
+    }
+
+    std::string request;
+
+    if (command == "shutdown" && file.empty())
+        request = "shutdown\n";
+    else if ((command == "parse" || command == "diagnostics") && !file.empty())
+        request = fmt::format("{} {}\n", command, std::filesystem::absolute(file).lexically_normal().string());
+    else if (command == "ast" && !file.empty())
+        request = fmt::format("ast {} {}\n", format, std::filesystem::absolute(file).lexically_normal().string());
+    else
+        return usage();
+
+    std::string answer;
+
+    try {
+        answer = ask(socket_path, request);
+    } catch (std::exception const& error) {
+        fmt::print(stderr, "{}", error.what());
+
+        return 1;
+    }
+
+    // a line with the status and the sizes of what follows it
+    auto const header = answer.find('\n') + 1;
+
+    int         status = 0;
+    std::size_t output = 0, errors = 0;
+
+    if (header == 0 || std::sscanf(answer.c_str(), "%d %zu %zu", &status, &output, &errors) != 3
+        || answer.size() != header + output + errors) {
+        fmt::print(stderr, "driver error, the server on \"{}\" gave a broken answer\n", socket_path);
+
+        return 1;
+    }
+
+    std::fwrite(answer.data() + header, 1, output, stdout);
+    std::fflush(stdout);
+    std::fwrite(answer.data() + header + output, 1, errors, stderr);
+
+    return status;
+}
@@ -0,0 +1,253 @@
+/** @file cpp-compiler.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Compiles every file given in the command line in a single process, as many
+ * at a time as there are jobs. The output of each file is written as a whole,
+ * in the order the files were given, followed by its error messages (if any).
+ * Trees are printed in the given format (see ast_emitter.hh), legacy if none.
+ * With --save-ast, the tree of each file is also saved next to it with an .ast
+ * suffix, and such files given as input are loaded instead of parsed. With
+ * --cache, functions already parsed before (see parse_cache.hh) are loaded
+ * from the given directory, and how often that happened is reported at the end.
+ * With -O, constants are folded before printing (see ast_folder.hh), and how
+ * many nodes that took out of the trees is reported at the end as well.
+ * With --run, each program is run in process (see jit.hh) instead of having its
+ * tree printed, reading its input from FILE.in if there is one, and how long
+ * compiling and running it took is reported along with what main returned.
+ * Programs run are always parsed as a whole, so --cache does nothing for them,
+ * and .ast files can't be run at all.
+ * With --passes, the code run goes through the passes listed first (see
+ * optimizer.hh), and what they did is reported at the end.
+ * With --time-report, where the time of the compiles went is reported at the
+ * end phase by phase (see instrumentation.hh), and --stats does the same as a
+ * JSON object. Both need the instrumentation built in, which it isn't by
+ * default.
+ * With --scanner, files are scanned by flex or by the hand written scanner of
+ * simd_scanner.hh, whichever the build chose if not given.
+ * With --function-jobs, the functions of each file are typed and lowered over
+ * that many threads (0 for one per hardware thread), on top of the jobs
+ * compiling files. The output is the same whatever the number.
+ * With --serve, no file is compiled: the compiler stays up answering requests
+ * on the given socket (see compile_server.hh) until told to shut down, which
+ * cpp-compiler-client sends.
+ *
+ *     cpp-compiler [-j JOBS] [-f legacy|dot|edges] [-O] [--save-ast] [--cache DIR] [--run] [--passes LIST]
+ *                  [--stats] [--time-report] [--scanner flex|simd] [--function-jobs N] FILE...
+ *     cpp-compiler [-j JOBS] --serve SOCKET
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "batch.hh"
+#include "compile_server.hh"
+
+namespace {
+
+auto usage() -> int
+{
+    fmt::print(stderr, "usage: cpp-compiler [-j JOBS] [-f legacy|dot|edges] [-O] [--save-ast] [--cache DIR] [--run] [--passes LIST] "
+                       "[--stats] [--time-report] [--scanner flex|simd] [--function-jobs N] FILE...\n"
+                       "       cpp-compiler [-j JOBS] --serve SOCKET\n");
+
+    return 2;
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    hcpsilva::batch_options              options;
+    std::optional<hcpsilva::parse_cache> cache;
+    std::vector<std::string>             files;
+    std::optional<std::string>           socket_path;
+
+    auto stats = false, time_report = false;
+
+    for (auto i = 1; i < argc; ++i) {
+        std::string_view const argument = argv[i];
+
+        if (argument == "-j" || argument == "--jobs") {
+            if (++i == argc)
+                return usage();
+
+            options.threads = std::strtoul(argv[i], nullptr, 10);
+        } else if (argument == "--function-jobs") {
+            if (++i == argc)
+                return usage();
+
+            options.function_threads = std::strtoul(argv[i], nullptr, 10);
+        } else if (argument == "-f" || argument == "--format") {
+            if (++i == argc)
+                return usage();
+
+            auto const chosen = hcpsilva::parse_ast_format(argv[i]);
+
+            if (!chosen)
+                return usage();
+
+            options.format = *chosen;
+        } else if (argument == "-O" || argument == "--optimize") {
+            options.optimize = true;
+        } else if (argument == "--run") {
+            options.run = true;
+        } else if (argument == "--passes") {
+            if (++i == argc)
+                return usage();
+
+            auto const chosen = hcpsilva::parse_optimizer_passes(argv[i]);
+
+            if (!chosen)
+                return usage();
+
+            options.passes = *chosen;
+        } else if (argument == "--scanner") {
+            if (++i == argc)
+                return usage();
+
+            auto const chosen = hcpsilva::parse_scanner_kind(argv[i]);
+
+            if (!chosen)
+                return usage();
+
+            options.scanner = *chosen;
+        } else if (argument == "--stats" || argument == "--time-report") {
+#ifndef INSTRUMENTATION
+            fmt::print(stderr, "driver error, {} needs the instrumentation built in\n", argument);
+            return 2;
+#endif
+            stats           = stats || argument == "--stats";
+            time_report     = time_report || argument == "--time-report";
+            options.measure = true;
+        } else if (argument == "--serve") {
+            if (++i == argc)
+                return usage();
+
+            socket_path = argv[i];
+        } else if (argument == "--save-ast") {
+            options.save_ast = true;
+        } else if (argument == "--cache") {
+            if (++i == argc)
+                return usage();
+
+            try {
+                options.cache = &cache.emplace(argv[i]);
+            } catch (std::exception const& error) {
+                fmt::print(stderr, "driver error, could not use \"{}\" as a cache: {}\n", argv[i], error.what());
+
+                return 1;
+            }
+        } else if (argument.starts_with("-")) {
+            return usage();
+        } else {
+            files.emplace_back(argument);
+        }
+    }
+
+    if (socket_path) {
+        if (!files.empty())
+            return usage();
+
+        try {
+            hcpsilva::compile_server server(*socket_path);
+
+            server.serve(options.threads);
+
+            auto const statistics = server.statistics();
+
+            fmt::print(stderr, "serve: {} requests, {} hits, {} parses, {} invalidated, {} evicted\n",
+                       statistics.requests, statistics.hits, statistics.parses, statistics.invalidated,
+                       statistics.evicted);
+        } catch (std::exception const& error) {
+            fmt::print(stderr, "{}", error.what());
+
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (files.empty())
+        return usage();
+
+    // a loaded tree misses what its names stand for, which code needs
+    if (options.run && std::ranges::any_of(files, [](auto const& file) { return file.ends_with(".ast"); })) {
+        fmt::print(stderr, "driver error, --run needs sources, trees loaded from .ast files can't be run\n");
+        return 2;
+    }
+
+    auto status = 0;
+
+    hcpsilva::fold_statistics      folded;
+    hcpsilva::optimizer_statistics optimized;
+    hcpsilva::compile_report       report;
+
+    for (auto const& result : hcpsilva::compile_batch(files, options)) {
+        std::fwrite(result.output.data(), 1, result.output.size(), stdout);
+
+        if (!result.errors.empty()) {
+            std::fflush(stdout);
+            fmt::print(stderr, "{}:{}", result.file_name, result.errors);
+        }
+
+        if (result.status != 0)
+            status = 1;
+        else if (options.run)
+            fmt::print(stderr, "run: {}: returned {}, {:.3f} ms compiling, {:.3f} ms running\n", result.file_name,
+                       result.returned, 1e3 * result.compile_seconds, 1e3 * result.run_seconds);
+
+        folded.folded += result.folded.folded;
+        folded.simplified += result.folded.simplified;
+        folded.pruned += result.folded.pruned;
+        folded.removed += result.folded.removed;
+        optimized += result.optimized;
+        report += result.report;
+    }
+
+    if (options.optimize) {
+        fmt::print(stderr, "optimize: {} nodes removed, {} operations folded, {} simplified, {} branches pruned\n",
+                   folded.removed, folded.folded, folded.simplified, folded.pruned);
+    }
+
+    if (options.run && optimized.before != 0) {
+        fmt::print(stderr,
+                   "passes: {} instructions to {}, {} constants, {} branches and {} blocks dropped, {} redundant, "
+                   "{} copies, {} hoisted, {} dead\n",
+                   optimized.before, optimized.after, optimized.constants, optimized.branches, optimized.unreachable,
+                   optimized.redundant, optimized.copies, optimized.hoisted, optimized.dead);
+    }
+
+    if (cache) {
+        auto const statistics = cache->statistics();
+
+        fmt::print(stderr, "cache: {} hits, {} misses, {} stored\n", statistics.hits, statistics.misses,
+                   statistics.stores);
+    }
+
+    if (time_report)
+        hcpsilva::print_time_report(report, files.size(), stderr);
+
+    if (stats)
+        hcpsilva::print_stats(report, files.size(), stderr);
+
+    return status;
+}
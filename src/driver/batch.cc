@@ -0,0 +1,170 @@
+/** @file batch.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "batch.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+#include "driver.hh"
+#include "memory_file.hh"
+#include "thread_pool.hh"
+
+namespace hcpsilva {
+
+namespace {
+
+    auto seconds_since(std::chrono::steady_clock::time_point start) -> double
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // translates the program of the driver and runs it, its input being
+    // file_name.in if there is one
+    auto run(driver& worker_driver, compilation& result, std::FILE* output, compile_report* report,
+        std::chrono::steady_clock::time_point start) -> void
+    {
+        using file = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+
+        file input(std::fopen((result.file_name + ".in").c_str(), "r"), &std::fclose);
+
+        if (!input)
+            input.reset(std::fopen("/dev/null", "r"));
+
+        if (!input)
+            throw std::runtime_error("driver error, could not open an input for the program\n");
+
+        std::optional<hcpsilva::jit> program;
+
+        {
+            phase_timer timing(report, phase::CODE);
+
+            program.emplace(worker_driver.code());
+        }
+
+        result.optimized       = worker_driver.code_statistics();
+        result.compile_seconds = seconds_since(start);
+
+        auto const running = std::chrono::steady_clock::now();
+
+        {
+            phase_timer timing(report, phase::RUN);
+
+            result.returned = program->run(input.get(), output);
+        }
+
+        result.run_seconds = seconds_since(running);
+    }
+
+    auto compile(std::optional<driver>& worker_driver, compilation& result, batch_options const& options) -> void
+    {
+        memory_file output, errors;
+
+        auto const start = std::chrono::steady_clock::now();
+
+        try {
+            // trees saved before are loaded back, instead of parsing anything.
+            // their file still becomes the input, it's just never scanned
+            auto const saved = result.file_name.ends_with(".ast");
+
+            // each worker keeps its driver (and its threads), only the input
+            // changes
+            if (worker_driver) {
+                worker_driver->swap_input(result.file_name);
+            } else {
+                worker_driver.emplace(result.file_name);
+                worker_driver->use_threads(options.function_threads);
+            }
+
+            worker_driver->use_scanner(options.scanner);
+
+            auto* const report = options.measure ? &result.report : nullptr;
+
+            worker_driver->redirect(output.get(), errors.get());
+            worker_driver->optimize_code(options.passes);
+            worker_driver->measure(report);
+
+            {
+                phase_timer timing(report, phase::PARSE);
+
+                // code needs what every name stands for, which is only taken
+                // down parsing the file as a whole, so programs run skip the cache
+                if (saved)
+                    worker_driver->load_ast(result.file_name);
+                else if (options.cache != nullptr && !options.run)
+                    result.status = worker_driver->parse(*options.cache);
+                else
+                    result.status = worker_driver->parse();
+            }
+
+            if (result.status == 0 && options.save_ast && !saved)
+                worker_driver->save_ast(result.file_name + ".ast");
+
+            if (result.status == 0 && options.optimize) {
+                phase_timer timing(report, phase::FOLD);
+
+                result.folded = worker_driver->optimize();
+            }
+
+            if (result.status == 0 && options.run) {
+                run(*worker_driver, result, output.get(), report, start);
+            } else if (result.status == 0) {
+                phase_timer timing(report, phase::PRINT);
+
+                worker_driver->print_ast(options.format);
+            }
+
+            result.report.nodes = worker_driver->node_count();
+        } catch (std::exception const& error) {
+            std::fputs(error.what(), errors.get());
+
+            result.status = 1;
+        }
+
+        // nothing may be printed to the streams once they are gone
+        if (worker_driver) {
+            worker_driver->redirect(stdout, stderr);
+            worker_driver->measure(nullptr);
+        }
+
+        result.output = output.take();
+        result.errors = errors.take();
+    }
+
+}
+
+auto compile_batch(std::vector<std::string> const& files, batch_options const& options) -> std::vector<compilation>
+{
+    std::vector<compilation> results(files.size());
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+        results[i].file_name = files[i];
+
+    thread_pool pool(options.threads);
+
+    // one driver per worker, each touched only by its own thread
+    std::vector<std::optional<driver>> drivers(pool.size());
+
+    for (auto& result : results)
+        pool.submit([&drivers, &result, &options](std::size_t worker) { compile(drivers[worker], result, options); });
+
+    pool.wait();
+
+    return results;
+}
+
+}
@@ -0,0 +1,377 @@
+/** @file compile_server.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "compile_server.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "ast_emitter.hh"
+#include "driver.hh"
+#include "memory_file.hh"
+#include "thread_pool.hh"
+
+namespace hcpsilva {
+
+namespace {
+
+    // what tells a file apart from what it was when parsed
+    struct file_stamp {
+        timespec    modified {};
+        std::size_t size  = 0;
+        ino_t       inode = 0;
+
+        auto operator==(file_stamp const& other) const -> bool
+        {
+            return this->modified.tv_sec == other.modified.tv_sec && this->modified.tv_nsec == other.modified.tv_nsec
+                && this->size == other.size && this->inode == other.inode;
+        }
+    };
+
+    auto stamp_of(std::string const& path) -> std::optional<file_stamp>
+    {
+        struct stat status {};
+
+        if (stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+            return std::nullopt;
+
+        return file_stamp { status.st_mtim, static_cast<std::size_t>(status.st_size), status.st_ino };
+    }
+
+    auto socket_address(std::string const& path) -> sockaddr_un
+    {
+        sockaddr_un address {};
+
+        if (path.size() >= sizeof address.sun_path)
+            throw std::runtime_error(fmt::format("driver error, socket path \"{}\" is too long\n", path));
+
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.data(), path.size());
+
+        return address;
+    }
+
+    auto send_all(int connection, std::string_view data) -> bool
+    {
+        while (!data.empty()) {
+            auto const sent = send(connection, data.data(), data.size(), MSG_NOSIGNAL);
+
+            if (sent < 0 && errno == EINTR)
+                continue;
+
+            if (sent <= 0)
+                return false;
+
+            data.remove_prefix(static_cast<std::size_t>(sent));
+        }
+
+        return true;
+    }
+
+    // the request line, without its line break. requests are small, anything
+    // longer than a path could be is given up on
+    auto receive_line(int connection) -> std::optional<std::string>
+    {
+        std::string line;
+        char        buffer[512];
+
+        while (line.size() < 2 * PATH_MAX) {
+            auto const received = recv(connection, buffer, sizeof buffer, 0);
+
+            if (received < 0 && errno == EINTR)
+                continue;
+
+            if (received <= 0)
+                return std::nullopt;
+
+            line.append(buffer, static_cast<std::size_t>(received));
+
+            if (auto const end = line.find('\n'); end != std::string::npos) {
+                line.resize(end);
+                return line;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // cuts the first word off text
+    auto next_word(std::string_view& text) -> std::string_view
+    {
+        auto const end  = text.find(' ');
+        auto const word = text.substr(0, end);
+
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+
+        return word;
+    }
+
+}
+
+// a file as parsed, with what parsing it said. its driver is used by one
+// request at a time
+struct compile_server::entry {
+    std::mutex  lock;
+    file_stamp  stamp;
+    std::size_t last_used = 0;
+
+    std::optional<hcpsilva::driver> parsed;
+    int                             status = 0;
+    std::string                     errors;
+    std::optional<std::string>      warnings; // once asked for
+};
+
+compile_server::compile_server(std::string socket_path, std::size_t capacity)
+    : socket_path(std::move(socket_path))
+    , capacity(std::max<std::size_t>(capacity, 1))
+{
+    auto const address = socket_address(this->socket_path);
+
+    if (!socket_path_trusted(this->socket_path))
+        throw std::runtime_error(
+            fmt::format("driver error, \"{}\" is taken by something not a socket of this user\n", this->socket_path));
+
+    // a socket nobody answers on was left by a server that is gone
+    if (auto const probe = socket(AF_UNIX, SOCK_STREAM, 0); probe >= 0) {
+        auto const alive = connect(probe, reinterpret_cast<sockaddr const*>(&address), sizeof address) == 0;
+
+        close(probe);
+
+        if (alive)
+            throw std::runtime_error(fmt::format("driver error, a server is already listening on \"{}\"\n", this->socket_path));
+
+        unlink(this->socket_path.c_str());
+    }
+
+    this->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (this->listener < 0
+        || bind(this->listener, reinterpret_cast<sockaddr const*>(&address), sizeof address) != 0
+        || chmod(this->socket_path.c_str(), S_IRUSR | S_IWUSR) != 0
+        || listen(this->listener, SOMAXCONN) != 0) {
+        auto const reason = std::strerror(errno);
+
+        if (this->listener >= 0)
+            close(this->listener);
+
+        throw std::runtime_error(fmt::format("driver error, could not listen on \"{}\": {}\n", this->socket_path, reason));
+    }
+}
+
+compile_server::~compile_server()
+{
+    close(this->listener);
+    unlink(this->socket_path.c_str());
+}
+
+auto compile_server::serve(std::size_t threads) -> void
+{
+    thread_pool pool(threads);
+
+    while (!this->stopping) {
+        auto const connection = accept4(this->listener, nullptr, nullptr, SOCK_CLOEXEC);
+
+        if (connection >= 0) {
+            pool.submit([this, connection](std::size_t) { this->handle(connection); });
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            // the listener shut down by a shutdown request, or broken
+            break;
+        }
+    }
+
+    pool.wait();
+}
+
+auto compile_server::statistics() const -> server_statistics
+{
+    std::lock_guard guard(this->lock);
+
+    return this->counts;
+}
+
+auto compile_server::handle(int connection) -> void
+{
+    response answer;
+
+    if (auto const request = receive_line(connection)) {
+        try {
+            answer = this->answer(*request);
+        } catch (std::exception const& error) {
+            answer = { 1, "", error.what() };
+        }
+
+        auto const header = fmt::format("{} {} {}\n", answer.status, answer.output.size(), answer.errors.size());
+
+        // a client gone before its answer is none of our business
+        send_all(connection, header) && send_all(connection, answer.output) && send_all(connection, answer.errors);
+    }
+
+    close(connection);
+}
+
+auto compile_server::answer(std::string const& request) -> response
+{
+    std::string_view rest    = request;
+    auto const       command = next_word(rest);
+
+    {
+        std::lock_guard guard(this->lock);
+
+        ++this->counts.requests;
+    }
+
+    if (command == "shutdown") {
+        this->stopping = true;
+
+        // wakes the accept of serve up, which sees it must stop
+        shutdown(this->listener, SHUT_RDWR);
+
+        return {};
+    }
+
+    std::optional<ast_format> format;
+
+    if (command == "ast") {
+        format = parse_ast_format(next_word(rest));
+
+        if (!format)
+            return { 2, "", fmt::format("driver error, unknown format in request \"{}\"\n", request) };
+    } else if (command != "parse" && command != "diagnostics") {
+        return { 2, "", fmt::format("driver error, unknown request \"{}\"\n", request) };
+    }
+
+    auto const path = std::string(rest);
+
+    if (path.empty() || path.front() != '/')
+        return { 2, "", fmt::format("driver error, the path in request \"{}\" is not absolute\n", request) };
+
+    auto const file = this->lookup(path);
+
+    std::lock_guard guard(file->lock);
+
+    if (command == "parse" || file->status != 0)
+        return { file->status, "", file->errors };
+
+    if (format) {
+        memory_file output;
+
+        file->parsed->redirect(output.get(), stderr);
+        file->parsed->print_ast(*format);
+        file->parsed->redirect(stdout, stderr);
+
+        return { 0, output.take(), "" };
+    }
+
+    // folding works in place, so it's done over a tree of its own, once
+    if (!file->warnings) {
+        memory_file warnings;
+        driver      folding(path);
+
+        folding.redirect(stdout, warnings.get());
+
+        if (folding.parse() == 0)
+            folding.optimize();
+
+        folding.redirect(stdout, stderr);
+
+        file->warnings = warnings.take();
+    }
+
+    return { 0, "", *file->warnings };
+}
+
+auto compile_server::lookup(std::string const& path) -> std::shared_ptr<entry>
+{
+    auto const stamp = stamp_of(path);
+
+    if (!stamp)
+        throw std::runtime_error(fmt::format("driver error, could not read \"{}\"\n", path));
+
+    std::shared_ptr<entry> file;
+
+    {
+        std::lock_guard guard(this->lock);
+
+        auto const found = this->entries.find(path);
+
+        if (found != this->entries.end() && found->second->stamp == *stamp) {
+            found->second->last_used = ++this->clock;
+            ++this->counts.hits;
+
+            // it may still be being parsed, which its lock waits for
+            return found->second;
+        }
+
+        if (found != this->entries.end())
+            ++this->counts.invalidated;
+        else if (this->entries.size() == this->capacity) {
+            auto oldest = this->entries.begin();
+
+            for (auto i = this->entries.begin(); i != this->entries.end(); ++i) {
+                if (i->second->last_used < oldest->second->last_used)
+                    oldest = i;
+            }
+
+            this->entries.erase(oldest);
+            ++this->counts.evicted;
+        }
+
+        ++this->counts.parses;
+
+        file            = std::make_shared<entry>();
+        file->stamp     = *stamp;
+        file->last_used = ++this->clock;
+
+        // taken before anyone else can see it, so they wait for the parse
+        file->lock.lock();
+
+        this->entries[path] = file;
+    }
+
+    std::lock_guard guard(file->lock, std::adopt_lock);
+
+    memory_file errors;
+
+    try {
+        file->parsed.emplace(path);
+        file->parsed->redirect(stdout, errors.get());
+
+        file->status = file->parsed->parse();
+
+        file->parsed->redirect(stdout, stderr);
+    } catch (std::exception const& error) {
+        std::fputs(error.what(), errors.get());
+
+        file->status = 1;
+    }
+
+    file->errors = errors.take();
+
+    // nothing but the messages is needed from a file that failed
+    if (file->status != 0)
+        file->parsed.reset();
+
+    return file;
+}
+
+}
@@ -13,18 +13,107 @@
 
 #include "driver.hh"
 
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <fmt/core.h>
+#include <unistd.h>
 
 namespace hcpsilva {
 
+namespace {
+
+    auto describe(symbol_kinds kind) -> std::string_view
+    {
+        switch (kind) {
+        case symbol_kinds::VARIABLE:
+            return "a variable";
+        case symbol_kinds::ARRAY:
+            return "an array";
+        case symbol_kinds::FUNCTION:
+            return "a function";
+        }
+
+        return "something";
+    }
+
+    /** @brief the type a function header starts with, read as the scanner
+     * would read it */
+    auto header_type(std::string_view header) -> std::optional<types>
+    {
+        constexpr std::pair<std::string_view, types> keywords[] = {
+            { "int", types::INT },
+            { "float", types::FLOAT },
+            { "bool", types::BOOL },
+            { "char", types::CHAR },
+        };
+
+        for (auto const& [keyword, type] : keywords) {
+            if (!header.starts_with(keyword))
+                continue;
+
+            if (header.size() == keyword.size() || !std::isalnum(static_cast<unsigned char>(header[keyword.size()])))
+                return type;
+        }
+
+        return std::nullopt;
+    }
+
+    /** @brief the types of the parameters of a function header, in order */
+    auto header_parameters(std::string_view header) -> std::optional<std::vector<types>>
+    {
+        auto const open  = header.find('(');
+        auto const close = header.rfind(')');
+
+        if (open == std::string_view::npos || close == std::string_view::npos || close < open)
+            return std::nullopt;
+
+        std::vector<types> parameters;
+
+        for (auto rest = header.substr(open + 1, close - open - 1);;) {
+            auto const comma     = rest.find(',');
+            auto       parameter = rest.substr(0, comma);
+
+            while (!parameter.empty() && std::isspace(static_cast<unsigned char>(parameter.front())))
+                parameter.remove_prefix(1);
+
+            // nothing at all between the parentheses
+            if (parameter.empty() && comma == std::string_view::npos && parameters.empty())
+                return parameters;
+
+            auto const type = header_type(parameter);
+
+            if (!type)
+                return std::nullopt;
+
+            parameters.push_back(*type);
+
+            if (comma == std::string_view::npos)
+                return parameters;
+
+            rest.remove_prefix(comma + 1);
+        }
+    }
+
+}
+
 driver::driver(std::string const& file_name)
-    : location(&file_name)
-    , file_name(file_name)
-    , input(file_name)
-    , scanner(&input)
 {
+    this->swap_input(file_name);
+}
+
+driver::driver()
+{
+    this->swap_input();
 }
 
 auto driver::swap_input(std::string const& file_name) -> void
@@ -32,23 +121,27 @@ auto driver::swap_input(std::string const& file_name) -> void
     if (file_name.empty())
         throw std::runtime_error("driver error, new input file name is empty\n");
 
-    // TODO: maybe also check if the file exists... sigh. use std::filesystem
-
-    this->location.initialize(&file_name);
+    this->reset();
 
     this->file_name = file_name;
 
+    this->location.initialize(++this->inputs);
+
     if (this->input.is_open())
         this->input.close();
 
-    this->input = std::ifstream(file_name);
+    // the scanner runs straight over the mapped file, tokens point into it
+    this->source = source_buffer::open(file_name);
 
-    this->scanner.switch_streams(&this->input);
+    this->scanner.scan_buffer(this->source.data(), this->source.size());
+    this->simd.scan_buffer(this->source.data(), this->source.size());
 }
 
 auto driver::swap_input(std::ifstream& input) -> void
 {
-    this->location.initialize();
+    this->reset();
+
+    this->location.initialize(++this->inputs);
 
     this->file_name = "";
 
@@ -60,32 +153,487 @@ auto driver::swap_input(std::ifstream& input) -> void
                              // taste and we should instead receive a rvalue
                              // reference if we were to do this
 
-    this->scanner.switch_streams(&this->input);
+    this->scanner.scan_stream(&this->input);
+    this->simd.clear();
+
+    this->source = source_buffer();
 }
 
 auto driver::swap_input() -> void
 {
-    this->location.initialize();
+    this->reset();
+
+    this->location.initialize(++this->inputs);
 
     this->file_name = "";
 
     if (this->input.is_open())
         this->input.close();
 
-    this->scanner.switch_streams();
+    // stdin redirected from a file gets mapped like any other file, while
+    // pipes and terminals are still read through the stream
+    if (source_buffer::mappable(STDIN_FILENO)) {
+        this->source = source_buffer::open(STDIN_FILENO);
+
+        this->scanner.scan_buffer(this->source.data(), this->source.size());
+        this->simd.scan_buffer(this->source.data(), this->source.size());
+    } else {
+        this->scanner.scan_stream(&std::cin);
+        this->simd.clear();
+
+        this->source = source_buffer();
+    }
+}
+
+auto driver::reset() -> void
+{
+    // names stay interned, they are cheap and likely to show up again
+    this->ast         = nullptr;
+    this->built_nodes = 0;
+
+    this->symbols.clear();
+    this->bindings.clear();
+    this->storage.reset();
+
+    for (auto& storage : this->worker_storage)
+        storage->reset();
+
+    this->lines.clear();
+    this->loaded        = false;
+    this->loaded_source = source_buffer();
+}
+
+auto driver::redirect(std::FILE* output, std::FILE* errors) -> void
+{
+    this->output = output;
+    this->errors = errors;
 }
 
 auto driver::parse(void) -> int
 {
-    return this->parser.parse();
+    auto const result = this->parser.parse();
+
+    if (result != 0)
+        return result;
+
+    std::vector<ast_node*> functions;
+
+    for (auto function = this->ast; function != nullptr; function = function->next)
+        functions.push_back(function);
+
+    return this->check_functions(functions) ? 0 : 1;
 }
 
-auto driver::print_ast() -> void
+auto driver::use_threads(std::size_t threads) -> void
 {
-    if (this->ast) {
-        this->ast->print();
-        this->ast->print_edges();
+    this->workers.reset();
+
+    if (threads != 1)
+        this->workers = std::make_unique<thread_pool>(threads);
+
+    // arenas are only ever added: those there may hold conversions spliced
+    // into a tree checked before, which lives on until reset
+    auto const needed = this->workers != nullptr ? this->workers->size() : 0;
+
+    while (this->worker_storage.size() < needed)
+        this->worker_storage.push_back(std::make_unique<arena>());
+}
+
+auto driver::parse(parse_cache& cache) -> int
+{
+    if (this->source.empty())
+        return this->parse();
+
+    auto const text  = this->source.view();
+    auto const spans = split_source(text);
+
+    if (!spans)
+        return this->parse();
+
+    // every function of the file depends on all of its global declarations
+    // and on the functions it may call, in the order they were declared
+    std::string globals;
+
+    for (auto const& span : *spans) {
+        globals.append(text.substr(span.begin, span.body - span.begin));
+        globals.push_back('\0');
+    }
+
+    // chained only once the parsed ones are stored, each on its own
+    std::vector<ast_node*> functions;
+
+    // the functions parsed rather than loaded, which are typed and stored
+    // only once every global is declared
+    struct parsed_function {
+        std::string        key;
+        ast_node*          tree;
+        source_span const* span;
+    };
+
+    std::vector<parsed_function> parsed;
+
+    auto const errors = this->errors;
+    auto       failed = false;
+
+    // nothing is reported while going over the declarations one by one, a
+    // failure simply starts it all over as a whole
+    this->errors = nullptr;
+
+    for (auto const& span : *spans) {
+        // globals build no nodes, but still have to be checked
+        if (!span.function) {
+            failed = !this->parse_span(span);
+        } else {
+            auto const key = cache.key(text.substr(span.begin, span.end - span.begin), globals);
+
+            auto       function = cache.load(key, this->storage, this->strings, this->inputs, this->built_nodes);
+            auto const cached   = function != nullptr;
+
+            if (!cached) {
+                failed   = !this->parse_span(span);
+                function = this->ast;
+
+                if (!failed && function != nullptr)
+                    parsed.push_back({ key, function, &span });
+            } else {
+                shift_locations(function, span);
+            }
+
+            if (function != nullptr)
+                functions.push_back(function);
+
+            // what's cached was checked when stored, with these very globals
+            // and headers around it. the function itself is all that's left
+            if (cached)
+                failed = !this->declare_cached(function, text.substr(span.begin, span.body - span.begin));
+        }
+
+        if (failed)
+            break;
+    }
+
+    if (!failed) {
+        std::vector<ast_node*> trees;
+
+        for (auto const& function : parsed)
+            trees.push_back(function.tree);
+
+        failed = !this->check_functions(trees);
     }
+
+    // cached as parsed, with locations relative to their own start
+    if (!failed) {
+        for (auto const& function : parsed) {
+            cache.store(function.key, function.tree, this->strings);
+            shift_locations(function.tree, *function.span);
+        }
+    }
+
+    this->errors = errors;
+
+    // back to the whole of the source, as swap_input left it
+    this->location.initialize(this->inputs);
+    this->lines.clear();
+    this->scanner.scan_buffer(this->source.data(), this->source.size());
+    this->simd.scan_buffer(this->source.data(), this->source.size());
+
+    if (failed) {
+        this->reset();
+
+        return this->parse();
+    }
+
+    ast_chain chain;
+
+    for (auto const function : functions)
+        chain.append(function);
+
+    this->ast = chain.head;
+
+    // the locations taken down were those of each declaration on its own,
+    // and the functions found in cache have none
+    this->bindings.complete = false;
+
+    return 0;
+}
+
+auto driver::declare_cached(ast_node const* function, std::string_view header) -> bool
+{
+    auto const name       = std::get_if<identifier>(&function->value.value);
+    auto const type       = header_type(header);
+    auto       parameters = header_parameters(header);
+
+    if (name == nullptr || !type || !parameters)
+        return false;
+
+    auto const number = static_cast<std::uint32_t>(this->bindings.functions.size());
+    auto const value  = symbol { function->value.location, symbol_kinds::FUNCTION, *type, type_size(*type), { true, number } };
+
+    if (this->symbols.declare(*name, value) != nullptr)
+        return false;
+
+    auto const count = static_cast<std::uint32_t>(parameters->size());
+
+    this->bindings.functions.push_back({ *name, *type, count, std::move(*parameters) });
+
+    return true;
+}
+
+auto driver::parse_span(source_span const& span) -> bool
+{
+    auto const base = this->source.data() + span.begin;
+    auto const size = span.end - span.begin;
+
+    // flex wants its buffers followed by NULs, so the bytes right after the
+    // span are swapped for those until it's done
+    char saved[source_buffer::padding];
+
+    std::memcpy(saved, base + size, sizeof saved);
+    std::memset(base + size, '\0', sizeof saved);
+
+    this->location.initialize(this->inputs);
+    this->lines.clear();
+    this->scanner.scan_buffer(base, size);
+    this->simd.scan_buffer(base, size);
+
+    this->ast = nullptr;
+
+    auto const result = this->parser.parse();
+
+    this->scanner.restore();
+
+    std::memcpy(base + size, saved, sizeof saved);
+
+    return result == 0;
+}
+
+auto driver::declare(identifier name, symbol_kinds kind, types type, yy::location const& location,
+    std::vector<std::uint32_t> dimensions) -> void
+{
+    sampled_timer timing(this->report, phase::SEMANTIC);
+
+    auto count = std::uint32_t { 1 };
+
+    for (auto const dimension : dimensions)
+        count *= dimension;
+
+    auto& functions = this->bindings.functions;
+    auto& globals   = this->bindings.globals;
+
+    // functions are global as well, but numbered apart
+    variable_ref variable { this->symbols.depth() == 1, 0 };
+
+    if (kind == symbol_kinds::FUNCTION)
+        variable.number = static_cast<std::uint32_t>(functions.size());
+    else if (variable.global)
+        variable.number = static_cast<std::uint32_t>(globals.size());
+    else
+        variable.number = static_cast<std::uint32_t>(functions.back().variables.size());
+
+    auto const previous = this->symbols.declare(name, symbol { location, kind, type, type_size(type) * count, variable });
+
+    if (previous != nullptr)
+        throw yy::parser::syntax_error(location,
+            fmt::format("semantic error, \"{}\" was already declared at line {}", this->name(name), this->position(previous->location).line));
+
+    if (kind == symbol_kinds::FUNCTION) {
+        functions.push_back({ name, type });
+    } else if (variable.global) {
+        globals.push_back({ name, type, this->bindings.global_words, std::move(dimensions) });
+        this->bindings.global_words += count;
+    } else {
+        // a local may be initialized, naming it in the tree
+        functions.back().variables.push_back(type);
+        this->bindings.uses.push_back({ location.begin, variable });
+    }
+}
+
+auto driver::use(identifier name, symbol_kinds kind, yy::location const& location) -> types
+{
+    sampled_timer timing(this->report, phase::SEMANTIC);
+
+    auto const found = this->symbols.find(name);
+
+    if (found == nullptr)
+        throw yy::parser::syntax_error(location, fmt::format("semantic error, \"{}\" was not declared", this->name(name)));
+
+    if (found->kind != kind)
+        throw yy::parser::syntax_error(location,
+            fmt::format("semantic error, \"{}\" is used as {} but was declared as {} at line {}", this->name(name),
+                        describe(kind), describe(found->kind), this->position(found->location).line));
+
+    if (kind != symbol_kinds::FUNCTION)
+        this->bindings.uses.push_back({ location.begin, found->variable });
+
+    return found->type;
+}
+
+auto driver::check_functions(std::vector<ast_node*> const& functions) -> bool
+{
+    phase_timer timing(this->report, phase::SEMANTIC, true);
+
+    // each function checked apart, so the first error of the source can be
+    // told no matter which worker found it first
+    struct outcome {
+        std::optional<yy::parser::syntax_error> error;
+        std::size_t                             added = 0;
+    };
+
+    std::vector<outcome> outcomes(functions.size());
+
+    auto const check = [&](std::size_t index, arena& storage) {
+        type_checker checker(storage, this->strings, this->symbols, this->bindings);
+
+        try {
+            checker.check(*functions[index]);
+        } catch (yy::parser::syntax_error const& error) {
+            outcomes[index].error = error;
+        }
+
+        outcomes[index].added = checker.added();
+    };
+
+    if (this->workers == nullptr) {
+        for (std::size_t i = 0; i < functions.size(); ++i)
+            check(i, this->storage);
+    } else {
+        for (std::size_t i = 0; i < functions.size(); ++i)
+            this->workers->submit([&, i](std::size_t worker) { check(i, *this->worker_storage[worker]); });
+
+        this->workers->wait();
+    }
+
+    for (auto const& [error, added] : outcomes) {
+        this->built_nodes += added;
+
+        if (error) {
+            this->parser.error(*error);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto driver::print_ast(ast_format format) -> void
+{
+    if (this->ast != nullptr)
+        ast_emitter(this->strings, format).emit(this->ast, this->output);
+}
+
+auto driver::optimize() -> fold_statistics
+{
+    ast_folder folder;
+
+    folder.fold(this->ast);
+
+    if (this->errors != nullptr) {
+        for (auto const& warning : folder.warnings())
+            fmt::print(this->errors, "\n--\nline {}: warning, {}\n", this->position(warning.location).line, warning.message);
+    }
+
+    return folder.statistics();
+}
+
+auto driver::position(yy::location const& location) -> line_column
+{
+    std::string_view text;
+
+    if (!this->loaded) {
+        text = this->scanner.source_text();
+    } else {
+        // a loaded tree comes without its source, which is read only now
+        if (this->loaded_source.empty() && !this->file_name.empty()) {
+            try {
+                this->loaded_source = source_buffer::open(this->file_name);
+            } catch (std::exception const&) {
+            }
+        }
+
+        text = this->loaded_source.view();
+    }
+
+    if (location.file != this->inputs || location.begin > text.size())
+        return { 0, 0 };
+
+    return this->lines.at(text, location.begin);
+}
+
+auto driver::lower() -> iloc_program
+{
+    if (!this->bindings.complete)
+        throw std::runtime_error("driver error, only a tree parsed as a whole can be lowered\n");
+
+    // lines are resolved for errors alone, but those may come from any worker
+    std::mutex resolving;
+
+    return generate_iloc(
+        this->ast, this->bindings, this->strings,
+        [this, &resolving](yy::location const& location) {
+            std::lock_guard const guard(resolving);
+
+            return this->position(location).line;
+        },
+        this->workers.get());
+}
+
+auto driver::node_bytes() const -> std::size_t
+{
+    auto bytes = this->storage.bytes_used();
+
+    for (auto const& storage : this->worker_storage)
+        bytes += storage->bytes_used();
+
+    return bytes;
+}
+
+auto driver::code() -> iloc_program
+{
+    auto program = this->lower();
+
+    this->optimized = optimize_iloc(program, this->passes);
+
+    return program;
+}
+
+auto driver::print_iloc() -> void
+{
+    hcpsilva::print_iloc(this->code(), this->output);
+}
+
+auto driver::print_asm() -> void
+{
+    print_x86_64(this->code(), this->output);
+}
+
+auto driver::run(std::FILE* in) -> std::int32_t
+{
+    return virtual_machine(compile_bytecode(this->code())).run("main", in, this->output);
+}
+
+auto driver::jit(std::FILE* in) -> std::int32_t
+{
+    return hcpsilva::jit(this->code()).run(in, this->output);
+}
+
+auto driver::save_ast(std::string const& path) const -> void
+{
+    hcpsilva::save_ast(path, this->ast, this->strings, this->file_name);
+}
+
+auto driver::load_ast(std::string const& path) -> void
+{
+    auto const file = ast_file::open(path);
+
+    this->reset();
+
+    // the loaded nodes are located in a source of their own, named in the file
+    this->file_name   = file.source_name();
+    this->ast         = file.load(this->storage, this->strings, ++this->inputs);
+    this->built_nodes = file.node_count();
+    this->loaded      = true;
+
+    this->bindings.complete = false;
 }
 
 }
@@ -0,0 +1,221 @@
+/** @file parse_cache.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "parse_cache.hh"
+
+#include <cstdint>
+#include <exception>
+#include <system_error>
+
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include "ast_binary.hh"
+#include "build-configurations.hh"
+
+namespace hcpsilva {
+
+namespace {
+
+    // two unrelated 64 bit digests, so telling entries apart doesn't rest on
+    // a single one of them
+    struct digest {
+        std::uint64_t first  = 0xcbf29ce484222325; // fnv-1a
+        std::uint64_t second = 0x9e3779b97f4a7c15;
+
+        auto add(std::string_view text) -> void
+        {
+            for (auto const c : text) {
+                this->first ^= static_cast<unsigned char>(c);
+                this->first *= 0x100000001b3;
+
+                this->second ^= static_cast<unsigned char>(c);
+                this->second *= 0xff51afd7ed558ccd;
+                this->second ^= this->second >> 29;
+            }
+
+            // where one piece ends is part of the digest as well
+            this->first ^= text.size();
+            this->first *= 0x100000001b3;
+
+            this->second ^= text.size();
+            this->second *= 0xff51afd7ed558ccd;
+            this->second ^= this->second >> 29;
+        }
+    };
+
+}
+
+auto split_source(std::string_view source) -> std::optional<std::vector<source_span>>
+{
+    std::vector<source_span> spans;
+
+    auto depth = 0;
+
+    // the declaration being read, if any
+    std::optional<source_span> current;
+
+    auto const size = source.size();
+
+    for (std::size_t i = 0; i < size;) {
+        auto const c = source[i];
+
+        if (c == '\n' || c == ' ' || c == '\t' || c == '\r') {
+            ++i;
+
+            continue;
+        }
+
+        if (c == '/' && i + 1 < size && source[i + 1] == '/') {
+            auto const end = source.find('\n', i);
+
+            i = end == std::string_view::npos ? size : end;
+
+            continue;
+        }
+
+        if (c == '/' && i + 1 < size && source[i + 1] == '*') {
+            auto const end = source.find("*/", i + 2);
+
+            if (end == std::string_view::npos)
+                return std::nullopt;
+
+            i = end + 2;
+
+            continue;
+        }
+
+        if (!current)
+            current = source_span { i, i, i, false };
+
+        // the scanner takes '' and 'x' (but no newline) as characters, which
+        // may well be a brace or a semicolon
+        std::size_t length = 1;
+
+        if (c == '\'' && i + 1 < size && source[i + 1] == '\'')
+            length = 2;
+        else if (c == '\'' && i + 2 < size && source[i + 1] != '\n' && source[i + 2] == '\'')
+            length = 3;
+        else if (c == '{' && depth++ == 0)
+            current->body = i;
+        else if (c == '}' && --depth < 0)
+            return std::nullopt;
+
+        i += length;
+
+        if (length != 1 || depth != 0)
+            continue;
+
+        // a function ends along with its body, anything else with a semicolon
+        if (c == '}' || c == ';') {
+            current->end      = i;
+            current->function = c == '}';
+
+            if (!current->function)
+                current->body = i;
+
+            spans.push_back(*current);
+            current.reset();
+        }
+    }
+
+    if (current)
+        return std::nullopt;
+
+    return spans;
+}
+
+auto shift_locations(ast_node* function, source_span const& span) -> void
+{
+    auto const by = static_cast<yy::location::offset_type>(span.begin);
+
+    for (auto& node : function->preorder()) {
+        node.value.location.begin += by;
+        node.value.location.end += by;
+    }
+}
+
+parse_cache::parse_cache(std::filesystem::path directory)
+    : directory(std::move(directory))
+{
+    std::filesystem::create_directories(this->directory);
+}
+
+auto parse_cache::key(std::string_view function, std::string_view globals) const -> std::string
+{
+    digest result;
+
+    result.add(VERSION_STR);
+    result.add(globals);
+    result.add(function);
+
+    return fmt::format("{:016x}{:016x}", result.first, result.second);
+}
+
+auto parse_cache::entry(std::string const& key) const -> std::filesystem::path
+{
+    return this->directory / (key + ".ast");
+}
+
+auto parse_cache::load(std::string const& key, arena& storage, string_pool& strings, yy::location::file_type file,
+                       std::size_t& nodes) -> ast_node*
+{
+    auto const path = this->entry(key);
+
+    std::error_code error;
+
+    if (std::filesystem::exists(path, error)) {
+        // an entry that can't be read is as good as none, it gets replaced
+        try {
+            auto const entry = ast_file::open(path);
+            auto const root = entry.load(storage, strings, file);
+
+            nodes += entry.node_count();
+            ++this->hits;
+
+            return root;
+        } catch (std::exception const&) {
+        }
+    }
+
+    ++this->misses;
+
+    return nullptr;
+}
+
+auto parse_cache::store(std::string const& key, ast_node const* function, string_pool const& strings) -> void
+{
+    auto const path = this->entry(key);
+    auto const temporary_path
+        = this->directory / fmt::format("{}.{}.{}.tmp", key, ::getpid(), this->temporary.fetch_add(1));
+
+    // a cache that can't be written to only makes things slower
+    try {
+        save_ast(temporary_path, function, strings, "");
+
+        std::filesystem::rename(temporary_path, path);
+
+        ++this->stores;
+    } catch (std::exception const&) {
+        std::error_code error;
+
+        std::filesystem::remove(temporary_path, error);
+    }
+}
+
+auto parse_cache::statistics() const -> cache_statistics
+{
+    return { this->hits.load(), this->misses.load(), this->stores.load() };
+}
+
+}
@@ -12,12 +12,16 @@
  */
 
 %code requires {
+	#include <cstdint>
 	#include <string>
 	#include <optional>
+	#include <vector>
 
 	#include "fmt/core.h"
+	#include "fmt/format.h"
 	#include "ast.hh"
 	#include "lexic_values.hh"
+	#include "location.hh"
 
 	namespace hcpsilva {
 		class driver;
@@ -25,6 +29,8 @@
 }
 
 %code top {
+	#include <algorithm>
+
 	#include "driver.hh"
 	#include "scanner.hh"
 	#include "parser.hh"
@@ -35,6 +41,11 @@
 	static auto yylex(driver& driver) -> yy::parser::symbol_type {
 		return driver.yylex();
 	}
+
+	/* the same as bison's, but keeping the file along with the offsets */
+	#define YYLLOC_DEFAULT(Current, Rhs, N)                                                     \
+		(Current) = (N) ? yy::location(YYRHSLOC(Rhs, 1), YYRHSLOC(Rhs, N))                       \
+		                : yy::location(YYRHSLOC(Rhs, 0).file, YYRHSLOC(Rhs, 0).end, YYRHSLOC(Rhs, 0).end)
 }
 
 /* the following options enable us more information when printing the
@@ -56,6 +67,8 @@
 %language "c++"
 
 %locations
+/* our own location type, byte offsets into the source and nothing else */
+%define api.location.type {yy::location}
 
 /* types */
 %token <hcpsilva::types>
@@ -121,11 +134,14 @@
 %token <bool> FALSE             "false literal"
 %token <bool> TRUE              "true literal"
 %token <char> CHARACTER         "character literal"
-%token <std::string> IDENTIFIER "identifier"
+%token <hcpsilva::identifier> IDENTIFIER "identifier"
 
 %type <hcpsilva::lexic_value> literal
 
-%type <std::string> header
+%type <hcpsilva::identifier> header header_name
+
+/* the dimensions of an array */
+%type <std::vector<std::uint32_t>> index_def index_def_rep
 
 %type <hcpsilva::types> type
 
@@ -138,12 +154,12 @@
 	tk_op_un
 ;
 
-/* rules and their types */
-%type <hcpsilva::ast_node>
+/* rules and their types, the nodes themselves live in the driver's arena */
+%type <hcpsilva::ast_node*>
 	function
 	expr
 	op_log op_eq op_cmp op_add op_mul op_un op_elem
-	call param_rep
+	call
 	index index_rep
 	id
 	atrib
@@ -154,37 +170,44 @@
 	return
 ;
 
-%type <std::optional<hcpsilva::ast_node>>
-	source
+/* these may produce no node at all, in which case they hold nullptr */
+%type <hcpsilva::ast_node*>
 	id_var_local
 	var_local
-	id_var_local_rep
+	body
 	block
-	command command_rep
+	command
 ;
 
-%printer { fmt::print("{}\n", *$$); } <std::optional<hcpsilva::ast_node>>
+/* lists of nodes chained through next, built by appending to their tail */
+%type <hcpsilva::ast_chain>
+	source
+	id_var_local_rep
+	command_rep
+	param_rep
+;
+
+%printer { if ($$) fmt::print("{}\n", *$$); else fmt::print("(null)\n"); } <hcpsilva::ast_node*>
+%printer { if ($$.head) fmt::print("{}\n", *$$.head); else fmt::print("(null)\n"); } <hcpsilva::ast_chain>
+%printer { fmt::print("{}\n", driver.name($$)); } <hcpsilva::identifier>
+%printer { fmt::print("{}\n", fmt::join($$, "^")); } <std::vector<std::uint32_t>>
 %printer { fmt::print("{}\n", $$); } <*>
 
 %%
 
 start
-	: source { driver.ast = std::move($1); }
+	: source { driver.ast = $1.head; }
 	;
 
 	/* ---------- GLOBAL SCOPE ---------- */
 
 	/* the source code can be empty, and variables require ';' */
 source
-	: %empty { $$ = std::nullopt; }
-	| source global_var SEMICOLON { $$ = std::move($1); }
+	: %empty { $$ = ast_chain(); }
+	| source global_var SEMICOLON { $$ = $1; }
 	| source function {
-		if ($1) {
-			$1->append_next(std::move($2));
-			$$ = std::move(*$1);
-		} else {
-			$$ = std::move($2);
-		}
+		$$ = $1;
+		$$.append($2);
 	}
 	;
 
@@ -198,22 +221,35 @@ id_global_var_rep
 	| id_global_var_rep COMMA id_global_var
 	;
 
+	/* which take the type given before them, see the type rule */
 id_global_var
-	: IDENTIFIER
-	| IDENTIFIER index_def
+	: IDENTIFIER { driver.declare($1, symbol_kinds::VARIABLE, driver.declared_type, @1); }
+	| IDENTIFIER index_def { driver.declare($1, symbol_kinds::ARRAY, driver.declared_type, @1, std::move($2)); }
 	;
 
+	/* the parameters are in a scope of their own, which the body shares. its
+	 * names are typed as they are found, the rest once the source is parsed */
 function
-	: header block {
-		$$ = ast_node(std::move($1));
-		if ($2) $$.add_child(std::move(*$2));
+	: header body {
+		$$ = driver.make_node($1, @1);
+		if ($2) $$->add_child($2);
+		driver.symbols.leave();
 	}
 	;
 
 	/* definition parameters can be empty, as well as calling parameters */
 header
-	: type IDENTIFIER LPAREN decl_params_rep RPAREN { $$ = std::move($2); }
-	| type IDENTIFIER LPAREN RPAREN { $$ = std::move($2); }
+	: header_name decl_params_rep RPAREN { $$ = $1; }
+	| header_name RPAREN { $$ = $1; }
+	;
+
+	/* the function is declared before its parameters, so it can call itself */
+header_name
+	: type IDENTIFIER LPAREN {
+		driver.declare($2, symbol_kinds::FUNCTION, $1, @2);
+		driver.symbols.enter();
+		$$ = $2;
+	}
 	;
 
 decl_params_rep
@@ -222,12 +258,31 @@ decl_params_rep
 	;
 
 decl_param
-	: type IDENTIFIER
+	: type IDENTIFIER {
+		driver.declare($2, symbol_kinds::VARIABLE, $1, @2);
+		++driver.bindings.functions.back().parameters;
+	}
+	;
+
+body
+	: LCURLY command_rep RCURLY { $$ = $2.head; }
+	| LCURLY RCURLY { $$ = nullptr; }
 	;
 
+	/* every other block opens a scope */
 block
-	: LCURLY command_rep RCURLY { $$ = std::move($2); }
-	| LCURLY RCURLY { $$ = std::nullopt; }
+	: block_open command_rep RCURLY {
+		$$ = $2.head;
+		driver.symbols.leave();
+	}
+	| block_open RCURLY {
+		$$ = nullptr;
+		driver.symbols.leave();
+	}
+	;
+
+block_open
+	: LCURLY { driver.symbols.enter(); }
 	;
 
 	/* ---------- COMMANDS ---------- */
@@ -235,52 +290,52 @@ block
 	/* commands are chained through ';' */
 command_rep
 	: command_rep command SEMICOLON {
-		if ($1 && $2) {
-			$1->append_next(std::move(*$2));
-			$$ = std::move(*$1);
-		} else if ($2) {
-			$$ = std::move(*$2);
-		}
+		$$ = $1;
+		$$.append($2);
 	}
-	| command SEMICOLON { $$ = std::move($1); }
+	| command SEMICOLON { $$.append($1); }
 	;
 
 command
-	: atrib { $$ = std::move($1); }
-	| var_local { $$ = std::move($1); }
-	| control_flow { $$ = std::move($1); }
-	| io { $$ = std::move($1); }
-	| return { $$ = std::move($1); }
-	| call { $$ = std::move($1); }
-	| block { $$ = std::move($1); }
+	: atrib { $$ = $1; }
+	| var_local { $$ = $1; }
+	| control_flow { $$ = $1; }
+	| io { $$ = $1; }
+	| return { $$ = $1; }
+	| call { $$ = $1; }
+	| block { $$ = $1; }
 	;
 
 	/* we use "=" in attributions, as expected */
 atrib
-	: id EQUAL expr { $$ = ast_node($2, std::move($1), std::move($3)); }
+	: id EQUAL expr { $$ = driver.make_node($2, @2, $1, $3); }
 	;
 
 var_local
-	: type id_var_local_rep { $$ = std::move($2); }
+	: type id_var_local_rep { $$ = $2.head; }
 	;
 
 	/* again, we can have multiple variables being declared at once */
 id_var_local_rep
-	: id_var_local { $$ = std::move($1); }
+	: id_var_local { $$.append($1); }
 	| id_var_local_rep COMMA id_var_local {
-		if ($1 && $3) {
-			$1->append_next(std::move(*$3));
-			$$ = std::move(*$1);
-		} else if ($3) {
-			$$ = std::move(*$3);
-		}
+		$$ = $1;
+		$$.append($3);
 	}
 	;
 
 	/* and they can be initialized (using "<=", for some reason) */
 id_var_local
-	: IDENTIFIER { $$ = std::nullopt; }
-	| IDENTIFIER OC_LESS_EQUAL literal { $$ = ast_node(operations::INITIALIZATION, ast_node(std::move($1)), ast_node(std::move($3))); }
+	: IDENTIFIER {
+		driver.declare($1, symbol_kinds::VARIABLE, driver.declared_type, @1);
+		$$ = nullptr;
+	}
+	| IDENTIFIER OC_LESS_EQUAL literal {
+		driver.declare($1, symbol_kinds::VARIABLE, driver.declared_type, @1);
+		auto const target = driver.make_node($1, @1);
+		target->value.type = driver.declared_type;
+		$$ = driver.make_node(operations::INITIALIZATION, @2, target, driver.make_node($3, @3));
+	}
 	;
 
 control_flow
@@ -288,45 +343,53 @@ control_flow
 	| while
 	;
 
+	/* an if spans up to the end of its then block, so a lone block after the
+	 * condition can be told to be its then or else by where it is */
 if
 	: IF LPAREN expr RPAREN THEN block {
-		$$ = ast_node($1, std::move($3));
-		if ($6) $$.add_child(std::move(*$6));
+		$$ = driver.make_node($1, yy::location(@1, @6), $3);
+		if ($6) $$->add_child($6);
 	}
 	| IF LPAREN expr RPAREN THEN block ELSE block {
-		$$ = ast_node($1, std::move($3));
-		if ($6) $$.add_child(std::move(*$6));
-		if ($8) $$.add_child(std::move(*$8));
+		$$ = driver.make_node($1, yy::location(@1, @6), $3);
+		if ($6) $$->add_child($6);
+		if ($8) $$->add_child($8);
 	}
 	;
 
 while
 	: WHILE LPAREN expr RPAREN block {
-		$$ = ast_node($1, std::move($3));
-		if ($5) $$.add_child(std::move(*$5));
+		$$ = driver.make_node($1, @1, $3);
+		if ($5) $$->add_child($5);
 	}
 	;
 
 io
-	: INPUT id { $$ = ast_node($1, std::move($2)); }
-	| OUTPUT id { $$ = ast_node($1, std::move($2)); }
-	| OUTPUT literal { $$ = ast_node($1, ast_node(std::move($2))); }
+	: INPUT id { $$ = driver.make_node($1, @1, $2); }
+	| OUTPUT id { $$ = driver.make_node($1, @1, $2); }
+	| OUTPUT literal { $$ = driver.make_node($1, @1, driver.make_node($2, @2)); }
 	;
 
 return
-	: RETURN expr { $$ = ast_node($1, std::move($2)); }
+	: RETURN expr { $$ = driver.make_node($1, @1, $2); }
 	;
 
 call
-	: IDENTIFIER LPAREN param_rep RPAREN { $$ = ast_node(std::move($1.insert(0, "call ")), std::move($3)); }
-	| IDENTIFIER LPAREN RPAREN { $$ = ast_node(std::move($1.insert(0, "call "))); }
+	: IDENTIFIER LPAREN param_rep RPAREN {
+		driver.use($1, symbol_kinds::FUNCTION, @1);
+		$$ = driver.make_node(function_call { $1 }, @1, $3.head);
+	}
+	| IDENTIFIER LPAREN RPAREN {
+		driver.use($1, symbol_kinds::FUNCTION, @1);
+		$$ = driver.make_node(function_call { $1 }, @1);
+	}
 	;
 
 param_rep
-	: expr { $$ = std::move($1); }
+	: expr { $$.append($1); }
 	| param_rep COMMA expr {
-		$1.append_next(std::move($3));
-		$$ = std::move($1);
+		$$ = $1;
+		$$.append($3);
 	}
 	;
 
@@ -334,44 +397,44 @@ param_rep
 
 	/* the expression rules are implemented following precedence orders */
 expr
-	: op_log { $$ = std::move($1); }
+	: op_log { $$ = $1; }
 	;
 
 op_log
-	: op_eq { $$ = std::move($1); }
-	| op_eq tk_op_log op_log { $$ = ast_node($2, std::move($1), std::move($3)); }
+	: op_eq { $$ = $1; }
+	| op_eq tk_op_log op_log { $$ = driver.make_node($2, @2, $1, $3); }
 	;
 
 op_eq
-	: op_cmp { $$ = std::move($1); }
-	| op_cmp tk_op_eq op_eq { $$ = ast_node($2, std::move($1), std::move($3)); }
+	: op_cmp { $$ = $1; }
+	| op_cmp tk_op_eq op_eq { $$ = driver.make_node($2, @2, $1, $3); }
 	;
 
 op_cmp
-	: op_add { $$ = std::move($1); }
-	| op_add tk_op_cmp op_cmp { $$ = ast_node($2, std::move($1), std::move($3)); }
+	: op_add { $$ = $1; }
+	| op_add tk_op_cmp op_cmp { $$ = driver.make_node($2, @2, $1, $3); }
 	;
 
 op_add
-	: op_mul { $$ = std::move($1); }
-	| op_mul tk_op_add op_add { $$ = ast_node($2, std::move($1), std::move($3)); }
+	: op_mul { $$ = $1; }
+	| op_mul tk_op_add op_add { $$ = driver.make_node($2, @2, $1, $3); }
 	;
 
 op_mul
-	: op_un { $$ = std::move($1); }
-	| op_un tk_op_mul op_mul { $$ = ast_node($2, std::move($1), std::move($3)); }
+	: op_un { $$ = $1; }
+	| op_un tk_op_mul op_mul { $$ = driver.make_node($2, @2, $1, $3); }
 	;
 
 op_un
-	: op_elem { $$ = std::move($1); }
-	| tk_op_un op_un { $$ = ast_node($1, std::move($2)); }
+	: op_elem { $$ = $1; }
+	| tk_op_un op_un { $$ = driver.make_node($1, @1, $2); }
 	;
 
 op_elem
-	: id { $$ = std::move($1); }
-	| call { $$ = std::move($1); }
-	| literal { $$ = ast_node($1); }
-	| LPAREN expr RPAREN { $$ = std::move($2); }
+	: id { $$ = $1; }
+	| call { $$ = $1; }
+	| literal { $$ = driver.make_node($1, @1); }
+	| LPAREN expr RPAREN { $$ = $2; }
 	;
 
 	/* tokens of each expression rule */
@@ -421,58 +484,69 @@ literal
 	/* ---------- MISC ----------  */
 
 id
-	: IDENTIFIER { $$ = ast_node(std::move($1)); }
-	| IDENTIFIER index { $$ = ast_node(operations::INDEX, ast_node(std::move($1)), std::move($2)); }
+	: IDENTIFIER {
+		auto const type = driver.use($1, symbol_kinds::VARIABLE, @1);
+		$$ = driver.make_node($1, @1);
+		$$->value.type = type;
+	}
+	| IDENTIFIER index {
+		driver.use($1, symbol_kinds::ARRAY, @1);
+		$$ = driver.make_node(operations::INDEX, @2, driver.make_node($1, @1), $2);
+	}
 	;
 
 index_def
-	: LSQUARE index_def_rep RSQUARE
+	: LSQUARE index_def_rep RSQUARE { $$ = $2; }
 	;
 
 index_def_rep
-	: INTEGER
-	| index_def_rep CARET INTEGER
+	: INTEGER { $$.push_back(static_cast<std::uint32_t>($1)); }
+	| index_def_rep CARET INTEGER {
+		$$ = std::move($1);
+		$$.push_back(static_cast<std::uint32_t>($3));
+	}
 	;
 
 index
-	: LSQUARE index_rep RSQUARE { $$ = std::move($2); }
+	: LSQUARE index_rep RSQUARE { $$ = $2; }
 	;
 
 index_rep
-	: expr { $$ = ast_node(operations::INDEX_SEP, std::move($1)); }
-	| index_rep CARET expr { $$ = ast_node($2, std::move($1), std::move($3)); }
+	: expr { $$ = driver.make_node(operations::INDEX_SEP, @1, $1); }
+	| index_rep CARET expr { $$ = driver.make_node($2, @2, $1, $3); }
 	;
 
+	/* the identifiers of a declaration come after its type, so the driver
+	 * remembers the last one read for them */
 type
-	: INT
-	| FLOAT
-	| BOOL
-	| CHAR
+	: INT { $$ = driver.declared_type = $1; }
+	| FLOAT { $$ = driver.declared_type = $1; }
+	| BOOL { $$ = driver.declared_type = $1; }
+	| CHAR { $$ = driver.declared_type = $1; }
 	;
 
 %%
 
 auto yy::parser::error(yy::location const& location, std::string const& message) -> void
 {
-	auto const token = driver.scanner.get_last_token();
-	auto const complete_line = driver.scanner.get_current_line();
-	auto const first_col = location.begin.column;
-	auto const last_col = location.end.column;
-	auto underline_string = (char*) calloc(last_col + 1, sizeof (char));
-
-	auto aux_ptr = underline_string;
+	// a quiet parse, which is done over again to report what went wrong
+	if (driver.errors == nullptr)
+		return;
 
-	std::memset(aux_ptr, ' ', first_col - 1);
-	aux_ptr += first_col - 1;
-	*aux_ptr = '^';
-	std::memset(aux_ptr + 1, '~', last_col - first_col - 1);
+	// nothing of this is kept while scanning, it's all cut out of the source
+	// only now, using the offsets in the location
+	auto const token = driver.scanner.get_token(location);
+	auto const complete_line = driver.scanner.get_line(location);
+	auto const [line, first_col] = driver.position(location);
+	auto const line_rest = static_cast<int>(complete_line.size()) - (first_col - 1);
+	auto const width = std::max(1, std::min(static_cast<int>(token.size()), line_rest));
 
-	fmt::print(stderr, "\n--\n");
+	auto const underline_string = fmt::format("{:{}}^{:~<{}}", "", first_col - 1, "", width - 1);
 
-	fmt::print(stderr, "line {}: {} (read token = \"{}\")\n", location.begin.line, message, token);
+	fmt::print(driver.errors, "\n--\n");
 
-	fmt::print(stderr, "{}\t| {}\n", location.begin.line, complete_line);
-	fmt::print(stderr, "\t| {}\n", underline_string);
+	fmt::print(driver.errors, "line {}: {} (read token = \"{}\")\n", line, message, token);
 
-	free(underline_string);
+	fmt::print(driver.errors, "{}\t| {}\n", line, complete_line);
+	fmt::print(driver.errors, "\t| {}\n", underline_string);
 }
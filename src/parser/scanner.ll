@@ -22,10 +22,11 @@
 %option batch
 
 %{
+#include <algorithm>
 #include <cstdlib>
-#include <string.h>
 
 #include <string>
+#include <string_view>
 #include <fmt/core.h>
 
 #include "parser.hh"
@@ -34,14 +35,12 @@
 #include "driver.hh"
 #include "lexic_values.hh"
 
-static bool read_a_line = true;
-
 #undef YY_DECL
 #define YY_DECL yy::parser::symbol_type yy::scanner::lex(hcpsilva::driver& driver)
 
-/* update the location of the tokens as they are recognized */
-/* VERY evil code */
-#define YY_USER_ACTION loc.columns(yyleng); this->on_new_token(yytext, yyleng, yy_hold_char);
+/* update the location of the tokens as they are recognized. that's all the
+ * bookkeeping done per token, the error context is rebuilt from the offsets */
+#define YY_USER_ACTION loc.columns(yyleng);
 %}
 
 /* helpful character classes */
@@ -118,7 +117,7 @@ LIT_FALSE "false"
 [^*[:blank:]\n]*
 "*"+[^*/[:blank:]\n]*
 {WHITE}+                         { loc.step(); }
-\n+                              { loc.lines(yyleng); loc.step(); }
+\n+                              { loc.step(); }
 
 }
 
@@ -148,7 +147,7 @@ LIT_FALSE "false"
 {LIT_FALSE}                      { return yy::parser::make_FALSE(false, loc); }
 
 	/* identifiers */
-{ALPHA}+                         { return yy::parser::make_IDENTIFIER(yytext, loc); }
+{ALPHA}+                         { return yy::parser::make_IDENTIFIER(driver.intern(std::string_view(yytext, yyleng)), loc); }
 
 
 	/* ---------- special characters section ---------- */
@@ -201,7 +200,7 @@ LIT_FALSE "false"
 	/* whitespace or newlines between tokens */
 {WHITE}+                         { loc.step(); }
 
-\n+                              { loc.lines(yyleng); loc.step(); read_a_line = true; }
+\n+                              { loc.step(); }
 
 <<EOF>>                          { return yy::parser::make_YYEOF(loc); }
 
@@ -212,32 +211,93 @@ LIT_FALSE "false"
 
 %%
 
-auto yy::scanner::get_current_line(void) -> std::string const&
+auto yy::scanner::scan_buffer(char* base, std::size_t size) -> void
+{
+	// flex only generates yy_scan_buffer for C scanners, so this does the
+	// same by hand: a buffer state pointing into memory we don't own and that
+	// is never refilled
+	auto state = static_cast<YY_BUFFER_STATE>(yyalloc(sizeof (struct yy_buffer_state)));
+
+	if (!state)
+		YY_FATAL_ERROR("out of dynamic memory in yy::scanner::scan_buffer()");
+
+	state->yy_buf_size       = static_cast<int>(size);
+	state->yy_buf_pos        = base;
+	state->yy_ch_buf         = base;
+	state->yy_is_our_buffer  = 0;
+	state->yy_input_file     = nullptr;
+	state->yy_n_chars        = state->yy_buf_size;
+	state->yy_is_interactive = 0;
+	state->yy_at_bol         = 1;
+	state->yy_fill_buffer    = 0;
+	state->yy_buffer_status  = YY_BUFFER_NEW;
+
+	auto previous = YY_CURRENT_BUFFER;
+
+	yy_switch_to_buffer(state);
+
+	if (previous)
+		yy_delete_buffer(previous);
+
+	BEGIN(INITIAL);
+
+	this->buffer = std::string_view(base, size);
+	this->history.clear();
+}
+
+auto yy::scanner::scan_stream(std::istream* input) -> void
+{
+	this->buffer = std::string_view();
+	this->history.clear();
+
+	this->switch_streams(input);
+
+	BEGIN(INITIAL);
+}
+
+auto yy::scanner::LexerInput(char* buffer, int max_size) -> int
+{
+	auto const count = yyFlexLexer::LexerInput(buffer, max_size);
+
+	if (count > 0)
+		this->history.append(buffer, count);
+
+	return count;
+}
+
+auto yy::scanner::restore() -> void
 {
-	return this->current_line;
+	// flex itself does the very same before matching anything else
+	if (yy_c_buf_p)
+		*yy_c_buf_p = yy_hold_char;
 }
 
-auto yy::scanner::get_last_token(void) -> std::string const&
+auto yy::scanner::source_text() -> std::string_view
 {
-	return this->last_token;
+	this->restore();
+
+	return this->buffer.data() ? this->buffer : std::string_view(this->history);
 }
 
-auto yy::scanner::on_new_token(char* yytext, int yyleng, char yy_hold_char) -> void
+auto yy::scanner::get_token(location const& loc) -> std::string_view
 {
-	this->last_token = std::string(yytext);
+	auto const source = this->source_text();
+	auto const begin  = std::min<std::size_t>(loc.begin, source.size());
+	auto const end    = std::min<std::size_t>(loc.end, source.size());
 
-	if (read_a_line) {
-		yytext[yyleng] = yy_hold_char;
+	return source.substr(begin, end > begin ? end - begin : 0);
+}
 
-		auto	newline_index		= strchrnul(yytext, '\n') - yytext;
-		auto	newline_char_or_eos = yytext[newline_index];
+auto yy::scanner::get_line(location const& loc) -> std::string_view
+{
+	auto const source = this->source_text();
+	auto const offset = std::min<std::size_t>(loc.begin, source.size());
 
-		yytext[newline_index] = '\0';
-		current_line          = std::string(yytext);
-		yytext[newline_index] = newline_char_or_eos;
+	auto first = source.substr(0, offset).rfind('\n');
+	auto last  = source.find('\n', offset);
 
-		yytext[yyleng] = '\0';
+	first = first == std::string_view::npos ? 0 : first + 1;
+	last  = last == std::string_view::npos ? source.size() : last;
 
-		read_a_line = false;
-	}
+	return source.substr(first, last - first);
 }
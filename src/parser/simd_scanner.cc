@@ -0,0 +1,574 @@
+/** @file simd_scanner.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "simd_scanner.hh"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "driver.hh"
+#include "lexic_values.hh"
+
+namespace hcpsilva {
+
+auto parse_scanner_kind(std::string_view name) -> std::optional<scanner_kind>
+{
+    if (name == "flex")
+        return scanner_kind::FLEX;
+
+    if (name == "simd")
+        return scanner_kind::SIMD;
+
+    return std::nullopt;
+}
+
+}
+
+namespace {
+
+// ---------- vectors, as wide as the build allows ----------
+
+#if defined(__AVX2__)
+
+using chunk = __m256i;
+
+constexpr std::size_t   width = 32;
+constexpr std::uint32_t every = 0xffffffff;
+
+auto load(char const* at) -> chunk { return _mm256_loadu_si256(reinterpret_cast<chunk const*>(at)); }
+auto splat(char value) -> chunk { return _mm256_set1_epi8(value); }
+auto equal(chunk bytes, char value) -> chunk { return _mm256_cmpeq_epi8(bytes, splat(value)); }
+auto either(chunk lhs, chunk rhs) -> chunk { return _mm256_or_si256(lhs, rhs); }
+auto shift(chunk bytes, char by) -> chunk { return _mm256_add_epi8(bytes, splat(by)); }
+auto below(chunk bytes, char bound) -> chunk { return _mm256_cmpgt_epi8(splat(bound), bytes); }
+auto bits(chunk mask) -> std::uint32_t { return static_cast<std::uint32_t>(_mm256_movemask_epi8(mask)); }
+
+#define VECTORS
+
+#elif defined(__SSE2__)
+
+using chunk = __m128i;
+
+constexpr std::size_t   width = 16;
+constexpr std::uint32_t every = 0xffff;
+
+auto load(char const* at) -> chunk { return _mm_loadu_si128(reinterpret_cast<chunk const*>(at)); }
+auto splat(char value) -> chunk { return _mm_set1_epi8(value); }
+auto equal(chunk bytes, char value) -> chunk { return _mm_cmpeq_epi8(bytes, splat(value)); }
+auto either(chunk lhs, chunk rhs) -> chunk { return _mm_or_si128(lhs, rhs); }
+auto shift(chunk bytes, char by) -> chunk { return _mm_add_epi8(bytes, splat(by)); }
+auto below(chunk bytes, char bound) -> chunk { return _mm_cmplt_epi8(bytes, splat(bound)); }
+auto bits(chunk mask) -> std::uint32_t { return static_cast<std::uint32_t>(_mm_movemask_epi8(mask)); }
+
+#define VECTORS
+
+#endif
+
+// ---------- classes of bytes, as flex takes them ----------
+
+auto is_letter(char c) -> bool { return static_cast<unsigned char>((c | 0x20) - 'a') < 26; }
+auto is_digit(char c) -> bool { return static_cast<unsigned char>(c - '0') < 10; }
+auto is_alnum(char c) -> bool { return is_letter(c) || is_digit(c); }
+auto is_blank(char c) -> bool { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+// the bytes going on a comment without ever stepping its location
+auto is_comment_text(char c) -> bool { return c != '*' && c != ' ' && c != '\t' && c != '\n'; }
+
+// ---------- runs of them ----------
+
+#ifdef VECTORS
+
+// byte ranges are tested by shifting the range down to the bottom of the
+// signed bytes, where a single comparison tells what's in it
+auto letters(chunk bytes) -> chunk { return below(shift(either(bytes, splat(0x20)), static_cast<char>(-'a' - 128)), -128 + 26); }
+auto digits(chunk bytes) -> chunk { return below(shift(bytes, static_cast<char>(-'0' - 128)), -128 + 10); }
+
+#endif
+
+auto skip_letters(char const* at, char const* end) -> char const*
+{
+#ifdef VECTORS
+    for (; at + width <= end; at += width) {
+        if (auto const stop = ~bits(letters(load(at))) & every)
+            return at + std::countr_zero(stop);
+    }
+#endif
+
+    while (at < end && is_letter(*at))
+        ++at;
+
+    return at;
+}
+
+auto skip_digits(char const* at, char const* end) -> char const*
+{
+#ifdef VECTORS
+    for (; at + width <= end; at += width) {
+        if (auto const stop = ~bits(digits(load(at))) & every)
+            return at + std::countr_zero(stop);
+    }
+#endif
+
+    while (at < end && is_digit(*at))
+        ++at;
+
+    return at;
+}
+
+auto skip_alnums(char const* at, char const* end) -> char const*
+{
+#ifdef VECTORS
+    for (; at + width <= end; at += width) {
+        auto const bytes = load(at);
+
+        if (auto const stop = ~bits(either(letters(bytes), digits(bytes))) & every)
+            return at + std::countr_zero(stop);
+    }
+#endif
+
+    while (at < end && is_alnum(*at))
+        ++at;
+
+    return at;
+}
+
+auto skip_comment_text(char const* at, char const* end) -> char const*
+{
+#ifdef VECTORS
+    for (; at + width <= end; at += width) {
+        auto const bytes = load(at);
+        auto const stops = either(either(equal(bytes, '*'), equal(bytes, ' ')), either(equal(bytes, '\t'), equal(bytes, '\n')));
+
+        if (auto const stop = bits(stops))
+            return at + std::countr_zero(stop);
+    }
+#endif
+
+    while (at < end && is_comment_text(*at))
+        ++at;
+
+    return at;
+}
+
+auto skip_blanks(char const* at, char const* end) -> char const*
+{
+#ifdef VECTORS
+    for (; at + width <= end; at += width) {
+        auto const bytes  = load(at);
+        auto const blanks = either(either(equal(bytes, ' '), equal(bytes, '\t')), either(equal(bytes, '\r'), equal(bytes, '\n')));
+
+        if (auto const stop = ~bits(blanks) & every)
+            return at + std::countr_zero(stop);
+    }
+#endif
+
+    while (at < end && is_blank(*at))
+        ++at;
+
+    return at;
+}
+
+// ---------- keywords, hashed into a table built at compile time ----------
+
+enum class word : std::uint8_t {
+    NONE,
+    INT,
+    FLOAT,
+    BOOL,
+    CHAR,
+    IF,
+    THEN,
+    ELSE,
+    WHILE,
+    INPUT,
+    OUTPUT,
+    RETURN,
+    TRUE,
+    FALSE,
+};
+
+struct keyword {
+    std::string_view text;
+    word             kind = word::NONE;
+};
+
+constexpr keyword keywords[] = {
+    { "int", word::INT },
+    { "float", word::FLOAT },
+    { "bool", word::BOOL },
+    { "char", word::CHAR },
+    { "if", word::IF },
+    { "then", word::THEN },
+    { "else", word::ELSE },
+    { "while", word::WHILE },
+    { "input", word::INPUT },
+    { "output", word::OUTPUT },
+    { "return", word::RETURN },
+    { "true", word::TRUE },
+    { "false", word::FALSE },
+};
+
+constexpr std::size_t slots = 32;
+
+constexpr auto slot_of(std::string_view text) -> std::size_t
+{
+    return (2 * text.size() + static_cast<unsigned char>(text.front()) + static_cast<unsigned char>(text.back())) % slots;
+}
+
+consteval auto build_table() -> std::array<keyword, slots>
+{
+    std::array<keyword, slots> table {};
+
+    for (auto const& entry : keywords) {
+        // a collision makes this no longer a constant expression
+        if (table[slot_of(entry.text)].kind != word::NONE)
+            throw std::logic_error("two keywords share a slot");
+
+        table[slot_of(entry.text)] = entry;
+    }
+
+    return table;
+}
+
+constexpr auto table = build_table();
+
+auto find_keyword(std::string_view text) -> word
+{
+    auto const& entry = table[slot_of(text)];
+
+    return entry.text == text ? entry.kind : word::NONE;
+}
+
+}
+
+namespace yy {
+
+auto simd_scanner::scan_buffer(char const* base, std::size_t size) -> void
+{
+    this->cursor = base;
+    this->end    = base + size;
+}
+
+auto simd_scanner::skip_comment(location& loc) -> void
+{
+    // the rules of the comment state of scanner.ll, of which only blanks and
+    // line breaks step the location. a carriage return takes the longer of
+    // the two rules it starts, the text rule when they tie
+    auto at   = this->cursor + 2;
+    auto from = this->cursor;
+
+    auto const flush = [&] {
+        loc.columns(static_cast<int>(at - from));
+        from = at;
+    };
+
+    while (at < this->end) {
+        auto const c = *at;
+
+        if (c == '\n') {
+            while (at < this->end && *at == '\n')
+                ++at;
+
+            flush();
+            loc.step();
+        } else if (c == ' ' || c == '\t' || c == '\r') {
+            auto white = at;
+
+            while (white < this->end && (*white == ' ' || *white == '\t' || *white == '\r'))
+                ++white;
+
+            auto const text = c == '\r' ? skip_comment_text(at, this->end) : at;
+
+            if (white > text) {
+                at = white;
+
+                flush();
+                loc.step();
+            } else {
+                at = text;
+            }
+        } else if (c == '*') {
+            while (at < this->end && *at == '*')
+                ++at;
+
+            if (at < this->end && *at == '/') {
+                ++at;
+                break;
+            }
+        } else {
+            at = skip_comment_text(at, this->end);
+        }
+    }
+
+    flush();
+
+    this->cursor = at;
+}
+
+auto simd_scanner::lex(hcpsilva::driver& driver) -> parser::symbol_type
+{
+    using namespace hcpsilva;
+
+    auto& loc = driver.location;
+
+    loc.step();
+
+    auto at = this->cursor;
+
+    // what comes before the token, which steps the location except for
+    // comments (see scanner.ll)
+    for (;;) {
+        if (auto const next = skip_blanks(at, this->end); next != at) {
+            loc.columns(static_cast<int>(next - at));
+            loc.step();
+
+            at = next;
+        }
+
+        if (at == this->end || at[0] != '/' || (at[1] != '/' && at[1] != '*'))
+            break;
+
+        if (at[1] == '/') {
+            auto const line = static_cast<char const*>(std::memchr(at, '\n', static_cast<std::size_t>(this->end - at)));
+            auto const next = line == nullptr ? this->end : line;
+
+            loc.columns(static_cast<int>(next - at));
+
+            at = next;
+        } else {
+            this->cursor = at;
+            this->skip_comment(loc);
+
+            at = this->cursor;
+        }
+    }
+
+    if (at == this->end) {
+        this->cursor = at;
+
+        return parser::make_YYEOF(loc);
+    }
+
+    auto const start = at;
+
+    auto const take = [&](char const* next) {
+        loc.columns(static_cast<int>(next - start));
+        this->cursor = next;
+    };
+
+    auto const bad_sequence = [&](char const* next) -> parser::syntax_error {
+        take(next);
+
+        return parser::syntax_error(loc, fmt::format("syntax error, bad alphanumeric sequence \"{}\"", std::string_view(start, next)));
+    };
+
+    if (is_letter(*at)) {
+        auto const next = skip_letters(at, this->end);
+
+        if (next < this->end && is_digit(*next))
+            throw bad_sequence(skip_alnums(next, this->end));
+
+        take(next);
+
+        auto const text = std::string_view(start, next);
+
+        switch (find_keyword(text)) {
+        case word::INT:
+            return parser::make_INT(types::INT, loc);
+        case word::FLOAT:
+            return parser::make_FLOAT(types::FLOAT, loc);
+        case word::BOOL:
+            return parser::make_BOOL(types::BOOL, loc);
+        case word::CHAR:
+            return parser::make_CHAR(types::CHAR, loc);
+        case word::IF:
+            return parser::make_IF(keywords::IF, loc);
+        case word::THEN:
+            return parser::make_THEN(loc);
+        case word::ELSE:
+            return parser::make_ELSE(loc);
+        case word::WHILE:
+            return parser::make_WHILE(keywords::WHILE, loc);
+        case word::INPUT:
+            return parser::make_INPUT(keywords::INPUT, loc);
+        case word::OUTPUT:
+            return parser::make_OUTPUT(keywords::OUTPUT, loc);
+        case word::RETURN:
+            return parser::make_RETURN(keywords::RETURN, loc);
+        case word::TRUE:
+            return parser::make_TRUE(true, loc);
+        case word::FALSE:
+            return parser::make_FALSE(false, loc);
+        case word::NONE:
+            break;
+        }
+
+        return parser::make_IDENTIFIER(driver.intern(text), loc);
+    }
+
+    if (is_digit(*at)) {
+        auto next = skip_digits(at, this->end);
+
+        // a fraction makes it a float, otherwise any letter right after makes
+        // it a bad sequence instead of an integer. atoi and atof stop right
+        // where the token does, as flex has a NUL there
+        if (next + 1 < this->end && next[0] == '.' && is_digit(next[1])) {
+            next = skip_digits(next + 1, this->end);
+
+            if (next < this->end && (*next == 'e' || *next == 'E')) {
+                auto exponent = next + 1;
+
+                if (exponent < this->end && (*exponent == '+' || *exponent == '-'))
+                    ++exponent;
+
+                if (exponent < this->end && is_digit(*exponent))
+                    next = skip_digits(exponent, this->end);
+            }
+
+            take(next);
+
+            return parser::make_FLOATING_POINT(std::atof(std::string(start, next).c_str()), loc);
+        }
+
+        if (next < this->end && is_letter(*next))
+            throw bad_sequence(skip_alnums(next, this->end));
+
+        take(next);
+
+        return parser::make_INTEGER(std::atoi(std::string(start, next).c_str()), loc);
+    }
+
+    // the longest of the character literals, which never span lines
+    if (*at == '\'') {
+        if (at + 2 < this->end && at[1] != '\n' && at[2] == '\'') {
+            take(at + 3);
+            return parser::make_CHARACTER(at[1], loc);
+        }
+
+        if (at + 1 < this->end && at[1] == '\'') {
+            take(at + 2);
+            return parser::make_CHARACTER('\x1a', loc);
+        }
+    }
+
+    auto const pair = [&](char second) { return at + 1 < this->end && at[1] == second; };
+
+    switch (*at) {
+    case '<':
+        if (pair('=')) {
+            take(at + 2);
+            return parser::make_OC_LESS_EQUAL(operations::LESS_EQUAL, loc);
+        }
+
+        take(at + 1);
+        return parser::make_LESS_THAN(operations::LESS_THAN, loc);
+    case '>':
+        if (pair('=')) {
+            take(at + 2);
+            return parser::make_OC_GREATER_EQUAL(operations::GREATER_EQUAL, loc);
+        }
+
+        take(at + 1);
+        return parser::make_GREATER_THAN(operations::GREATER_THAN, loc);
+    case '=':
+        if (pair('=')) {
+            take(at + 2);
+            return parser::make_OC_EQUAL(operations::EQUAL, loc);
+        }
+
+        take(at + 1);
+        return parser::make_EQUAL(operations::ATTRIBUTION, loc);
+    case '!':
+        if (pair('=')) {
+            take(at + 2);
+            return parser::make_OC_NOT_EQUAL(operations::NOT_EQUAL, loc);
+        }
+
+        take(at + 1);
+        return parser::make_BANG(operations::NEGATION, loc);
+    case '&':
+        if (pair('&')) {
+            take(at + 2);
+            return parser::make_OC_AND(operations::AND, loc);
+        }
+
+        break;
+    case '|':
+        if (pair('|')) {
+            take(at + 2);
+            return parser::make_OC_OR(operations::OR, loc);
+        }
+
+        break;
+    case '+':
+        take(at + 1);
+        return parser::make_PLUS(operations::POSITIVE, loc);
+    case '-':
+        take(at + 1);
+        return parser::make_MINUS(operations::NEGATIVE, loc);
+    case '*':
+        take(at + 1);
+        return parser::make_STAR(operations::MULTIPLICATION, loc);
+    case '/':
+        take(at + 1);
+        return parser::make_SLASH(operations::DIVISION, loc);
+    case '%':
+        take(at + 1);
+        return parser::make_PERCENT(operations::REST, loc);
+    case '^':
+        take(at + 1);
+        return parser::make_CARET(operations::INDEX_SEP, loc);
+    case ',':
+        take(at + 1);
+        return parser::make_COMMA(loc);
+    case ';':
+        take(at + 1);
+        return parser::make_SEMICOLON(loc);
+    case '(':
+        take(at + 1);
+        return parser::make_LPAREN(loc);
+    case ')':
+        take(at + 1);
+        return parser::make_RPAREN(loc);
+    case '{':
+        take(at + 1);
+        return parser::make_LCURLY(loc);
+    case '}':
+        take(at + 1);
+        return parser::make_RCURLY(loc);
+    case '[':
+        take(at + 1);
+        return parser::make_LSQUARE(loc);
+    case ']':
+        take(at + 1);
+        return parser::make_RSQUARE(loc);
+    default:
+        break;
+    }
+
+    take(at + 1);
+
+    throw parser::syntax_error(loc, fmt::format("syntax error, unknown character '{}'", std::string_view(start, 1)));
+}
+
+}
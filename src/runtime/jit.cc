@@ -0,0 +1,703 @@
+/** @file jit.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "jit.hh"
+
+#include <algorithm>
+#include <bit>
+#include <csetjmp>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/format.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace hcpsilva {
+
+namespace {
+
+    // what stops a program short, as given to longjmp
+    enum trap : int {
+        NONE,
+        DIVISION,
+        ADDRESS,
+        DEPTH,
+        NO_INPUT,
+    };
+
+    enum reg : std::uint8_t {
+        EAX = 0,
+        ECX = 1,
+        EDX = 2,
+        ESI = 6,
+        EDI = 7,
+        R8D = 8,
+        R9D = 9,
+    };
+
+    constexpr reg argument_registers[] = { EDI, ESI, EDX, ECX, R8D, R9D };
+
+    constexpr std::size_t stub_bytes = 64;
+
+    // generous bounds on the code of an instruction and of the rest of a
+    // function, so its memory is mapped once and for all
+    constexpr std::size_t instruction_bytes = 96;
+    constexpr std::size_t function_bytes    = 256;
+
+    // what is left of the stack for the helpers, once calls get this deep
+    constexpr std::size_t stack_margin = 256 * 1024;
+
+    template <typename... arguments>
+    [[noreturn]] auto fail(fmt::format_string<arguments...> format, arguments&&... values) -> void
+    {
+        throw std::runtime_error(fmt::format("jit error, {}\n", fmt::format(format, std::forward<arguments>(values)...)));
+    }
+
+    // the displacement of the slot of register number from rbp
+    auto slot(std::int32_t number) -> std::int32_t
+    {
+        return -4 * (number + 1);
+    }
+
+    /** @brief writes machine code, a byte at a time */
+    class writer {
+    public:
+        explicit writer(std::uint8_t* at)
+            : at(at)
+        {
+        }
+
+        auto position() const -> std::uint8_t* { return this->at; }
+
+        auto bytes(std::initializer_list<std::uint8_t> values) -> void
+        {
+            for (auto const value : values)
+                *this->at++ = value;
+        }
+
+        auto dword(std::int32_t value) -> void
+        {
+            std::memcpy(this->at, &value, sizeof value);
+            this->at += sizeof value;
+        }
+
+        auto qword(void const* pointer) -> void
+        {
+            auto const value = reinterpret_cast<std::uint64_t>(pointer);
+
+            std::memcpy(this->at, &value, sizeof value);
+            this->at += sizeof value;
+        }
+
+        // a rel32 to target, as the last four bytes of an instruction
+        auto relative(std::uint8_t const* target) -> void
+        {
+            this->dword(static_cast<std::int32_t>(target - (this->at + 4)));
+        }
+
+        // the prefix and opcode given, with [rbp + displacement] as the memory
+        // operand and r as the other one
+        auto frame(std::initializer_list<std::uint8_t> opcode, std::uint8_t r, std::int32_t displacement) -> void
+        {
+            if (r >= 8)
+                this->bytes({ 0x44 });
+
+            this->bytes(opcode);
+            this->bytes({ static_cast<std::uint8_t>(0x85 | (r & 7) << 3) });
+            this->dword(displacement);
+        }
+
+        // the same, for the sse instructions, whose prefix comes before rex
+        auto sse(std::uint8_t prefix, std::uint8_t opcode, std::int32_t displacement) -> void
+        {
+            if (prefix != 0)
+                this->bytes({ prefix });
+
+            this->bytes({ 0x0f, opcode, 0x85 });
+            this->dword(displacement);
+        }
+
+        auto load(reg r, std::int32_t number) -> void { this->frame({ 0x8b }, r, slot(number)); }
+
+        auto store(std::int32_t number, reg r) -> void { this->frame({ 0x89 }, r, slot(number)); }
+
+        // movabs into rax, rdx or rdi
+        auto address(reg r, void const* pointer) -> void
+        {
+            this->bytes({ 0x48, static_cast<std::uint8_t>(0xb8 + r) });
+            this->qword(pointer);
+        }
+
+        auto call(void const* function) -> void
+        {
+            this->address(EAX, function);
+            this->bytes({ 0xff, 0xd0 });
+        }
+
+    private:
+        std::uint8_t* at;
+    };
+
+}
+
+struct jit::state {
+    iloc_program program;
+
+    std::uint8_t* code     = nullptr;
+    std::size_t   capacity = 0;
+    std::size_t   used     = 0;
+
+    std::vector<std::uint8_t*> entries; // of each function, once translated
+    std::vector<std::uint8_t*> stubs;
+    std::uint8_t*              traps[NO_INPUT] = {};
+
+    std::vector<std::int32_t> memory;
+    std::uintptr_t            limit = 0; // of the stack
+
+    std::FILE*   in       = stdin;
+    std::FILE*   out      = stdout;
+    std::int32_t returned = 0;
+    std::jmp_buf escape;
+
+    jit_statistics statistics;
+
+    auto writable(bool write) -> void
+    {
+        mprotect(this->code, this->capacity, write ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC);
+    }
+
+    auto translate(std::size_t number) -> void;
+};
+
+namespace {
+
+    // the runtime, called from the generated code with the state first
+
+    [[noreturn]] auto stop(jit::state* self, int why) -> void
+    {
+        std::longjmp(self->escape, why);
+    }
+
+    auto input(jit::state* self) -> std::int32_t
+    {
+        std::int32_t value = 0;
+
+        if (std::fscanf(self->in, "%d", &value) != 1)
+            stop(self, NO_INPUT);
+
+        return value;
+    }
+
+    auto float_input(jit::state* self) -> std::int32_t
+    {
+        float value = 0;
+
+        if (std::fscanf(self->in, "%f", &value) != 1)
+            stop(self, NO_INPUT);
+
+        return std::bit_cast<std::int32_t>(value);
+    }
+
+    auto output(jit::state* self, std::int32_t value) -> void
+    {
+        fmt::print(self->out, "{}\n", value);
+    }
+
+    auto float_output(jit::state* self, std::int32_t bits) -> void
+    {
+        fmt::print(self->out, "{:g}\n", std::bit_cast<float>(bits));
+    }
+
+    // translates function number if it wasn't yet, and has the call that
+    // returns to return_address (if any) go straight to it
+    auto resolve(jit::state* self, std::uint32_t number, std::uint8_t* return_address) -> std::uint8_t*
+    {
+        self->writable(true);
+
+        if (self->entries[number] == nullptr)
+            self->translate(number);
+
+        if (return_address != nullptr) {
+            writer(return_address - 4).relative(self->entries[number]);
+            ++self->statistics.patched;
+        }
+
+        self->writable(false);
+
+        return self->entries[number];
+    }
+
+    auto enter(jit::state* self, std::int32_t (*main)()) -> int
+    {
+        if (auto const why = setjmp(self->escape); why != NONE)
+            return why;
+
+        self->returned = main();
+
+        return NONE;
+    }
+
+    auto lowest_stack_address() -> std::uintptr_t
+    {
+        pthread_attr_t attributes;
+
+        void*       stack = nullptr;
+        std::size_t size  = 0;
+
+        if (pthread_getattr_np(pthread_self(), &attributes) != 0)
+            return 0;
+
+        pthread_attr_getstack(&attributes, &stack, &size);
+        pthread_attr_destroy(&attributes);
+
+        return reinterpret_cast<std::uintptr_t>(stack);
+    }
+
+}
+
+auto jit::state::translate(std::size_t number) -> void
+{
+    auto const& function = this->program.functions[number];
+
+    auto const registers = std::max(function.registers, used_registers(function));
+    auto const frame     = (4 * std::int32_t(registers) + 15) / 16 * 16;
+
+    writer code(this->code + this->used);
+
+    this->entries[number] = code.position();
+
+    std::vector<std::uint8_t*>                            labels(function.labels, nullptr);
+    std::vector<std::pair<std::uint8_t*, std::int32_t>> jumps; // where a rel32 to a label goes
+
+    auto const jump_to = [&](std::int32_t label) {
+        jumps.emplace_back(code.position(), label);
+        code.dword(0);
+    };
+
+    // push rbp, mov rbp, rsp, sub rsp, frame
+    code.bytes({ 0x55, 0x48, 0x89, 0xe5, 0x48, 0x81, 0xec });
+    code.dword(frame);
+
+    // cmp rsp, [limit], jb to the trap
+    code.address(EAX, &this->limit);
+    code.bytes({ 0x48, 0x3b, 0x20, 0x0f, 0x82 });
+    code.relative(this->traps[DEPTH]);
+
+    for (std::uint32_t i = 0; i < function.parameters; ++i) {
+        auto const parameter = static_cast<std::int32_t>(i);
+
+        if (i < std::size(argument_registers)) {
+            code.store(parameter, argument_registers[i]);
+        } else {
+            code.frame({ 0x8b }, EAX, static_cast<std::int32_t>(16 + 8 * (i - std::size(argument_registers))));
+            code.store(parameter, EAX);
+        }
+    }
+
+    // the rest starts zeroed: lea rdi, mov ecx, xor eax, eax, rep stosd
+    if (registers > function.parameters) {
+        code.bytes({ 0x48, 0x8d, 0xbd });
+        code.dword(slot(static_cast<std::int32_t>(registers) - 1));
+        code.bytes({ 0xb9 });
+        code.dword(static_cast<std::int32_t>(registers - function.parameters));
+        code.bytes({ 0x31, 0xc0, 0xf3, 0xab });
+    }
+
+    auto const words = static_cast<std::int32_t>(this->program.globals);
+
+    // movsxd rax, index, cmp rax, words, jae to the trap, movabs rdx, memory
+    auto const element = [&](std::int32_t index) {
+        code.frame({ 0x48, 0x63 }, EAX, slot(index));
+        code.bytes({ 0x48, 0x3d });
+        code.dword(words);
+        code.bytes({ 0x0f, 0x83 });
+        code.relative(this->traps[ADDRESS]);
+        code.address(EDX, this->memory.data());
+    };
+
+    auto const compare = [&](std::uint8_t set) {
+        // setcc al, movzx eax, al
+        code.bytes({ 0x0f, set, 0xc0, 0x0f, 0xb6, 0xc0 });
+    };
+
+    for (auto const& line : function.code) {
+        auto const [op, a, b, c] = line;
+
+        switch (op) {
+        case opcode::NOP:
+            break;
+        case opcode::ADD:
+        case opcode::SUB:
+        case opcode::MULT:
+            code.load(EAX, a);
+
+            if (op == opcode::MULT)
+                code.frame({ 0x0f, 0xaf }, EAX, slot(b));
+            else
+                code.frame({ static_cast<std::uint8_t>(op == opcode::ADD ? 0x03 : 0x2b) }, EAX, slot(b));
+
+            code.store(c, EAX);
+            break;
+        case opcode::DIV:
+        case opcode::MOD:
+            // dividing by -1 is negating, as idiv faults on the lowest int
+            code.load(ECX, b);
+            code.bytes({ 0x85, 0xc9, 0x0f, 0x84 });
+            code.relative(this->traps[DIVISION]);
+            code.load(EAX, a);
+            code.bytes({ 0x83, 0xf9, 0xff, 0x75, 0x04 });
+
+            if (op == opcode::DIV)
+                code.bytes({ 0xf7, 0xd8, 0xeb, 0x03, 0x99, 0xf7, 0xf9 });
+            else
+                code.bytes({ 0x31, 0xc0, 0xeb, 0x05, 0x99, 0xf7, 0xf9, 0x89, 0xd0 });
+
+            code.store(c, EAX);
+            break;
+        case opcode::CMP_LT:
+        case opcode::CMP_LE:
+        case opcode::CMP_EQ:
+        case opcode::CMP_GE:
+        case opcode::CMP_GT:
+        case opcode::CMP_NE: {
+            constexpr std::uint8_t sets[] = { 0x9c, 0x9e, 0x94, 0x9d, 0x9f, 0x95 };
+
+            code.load(EAX, a);
+            code.frame({ 0x3b }, EAX, slot(b));
+            compare(sets[static_cast<int>(op) - static_cast<int>(opcode::CMP_LT)]);
+            code.store(c, EAX);
+            break;
+        }
+        case opcode::FADD:
+        case opcode::FSUB:
+        case opcode::FMULT:
+        case opcode::FDIV: {
+            constexpr std::uint8_t operations[] = { 0x58, 0x5c, 0x59, 0x5e };
+
+            code.sse(0xf3, 0x10, slot(a));
+            code.sse(0xf3, operations[static_cast<int>(op) - static_cast<int>(opcode::FADD)], slot(b));
+            code.sse(0xf3, 0x11, slot(c));
+            break;
+        }
+        case opcode::FCMP_LT:
+        case opcode::FCMP_LE:
+        case opcode::FCMP_EQ:
+        case opcode::FCMP_GE:
+        case opcode::FCMP_GT:
+        case opcode::FCMP_NE: {
+            // as in x86_64.cc, only above and above or equal are used
+            auto const swapped = op == opcode::FCMP_LT || op == opcode::FCMP_LE;
+
+            code.sse(0xf3, 0x10, slot(swapped ? b : a));
+            code.sse(0, 0x2e, slot(swapped ? a : b));
+
+            if (op == opcode::FCMP_EQ) {
+                // sete al, setnp cl, and al, cl
+                code.bytes({ 0x0f, 0x94, 0xc0, 0x0f, 0x9b, 0xc1, 0x20, 0xc8, 0x0f, 0xb6, 0xc0 });
+            } else if (op == opcode::FCMP_NE) {
+                // setne al, setp cl, or al, cl
+                code.bytes({ 0x0f, 0x95, 0xc0, 0x0f, 0x9a, 0xc1, 0x08, 0xc8, 0x0f, 0xb6, 0xc0 });
+            } else {
+                compare(op == opcode::FCMP_LT || op == opcode::FCMP_GT ? 0x97 : 0x93);
+            }
+
+            code.store(c, EAX);
+            break;
+        }
+        case opcode::ADDI:
+            code.load(EAX, a);
+            code.bytes({ 0x05 });
+            code.dword(b);
+            code.store(c, EAX);
+            break;
+        case opcode::MULTI:
+            code.frame({ 0x69 }, EAX, slot(a));
+            code.dword(b);
+            code.store(c, EAX);
+            break;
+        case opcode::RSUBI:
+            code.bytes({ 0xb8 });
+            code.dword(b);
+            code.frame({ 0x2b }, EAX, slot(a));
+            code.store(c, EAX);
+            break;
+        case opcode::LOADI:
+        case opcode::LOADF:
+            code.frame({ 0xc7 }, 0, slot(c));
+            code.dword(a);
+            break;
+        case opcode::I2I:
+            code.load(EAX, a);
+            code.store(c, EAX);
+            break;
+        case opcode::I2F:
+            code.sse(0xf3, 0x2a, slot(a));
+            code.sse(0xf3, 0x11, slot(c));
+            break;
+        case opcode::F2I:
+            code.sse(0xf3, 0x2c, slot(a));
+            code.store(c, EAX);
+            break;
+        case opcode::LOADAI:
+            // mov eax, [moffs64]
+            code.bytes({ 0xa1 });
+            code.qword(this->memory.data() + b);
+            code.store(c, EAX);
+            break;
+        case opcode::LOADAO:
+            element(b);
+            code.bytes({ 0x8b, 0x04, 0x82 });
+            code.store(c, EAX);
+            break;
+        case opcode::STOREAI:
+            // mov [moffs64], eax
+            code.load(EAX, c);
+            code.bytes({ 0xa3 });
+            code.qword(this->memory.data() + b);
+            break;
+        case opcode::STOREAO:
+            element(b);
+            code.load(ECX, c);
+            code.bytes({ 0x89, 0x0c, 0x82 });
+            break;
+        case opcode::JUMPI:
+            code.bytes({ 0xe9 });
+            jump_to(a);
+            break;
+        case opcode::CBR:
+            // cmp dword [a], 0, jne b, jmp c
+            code.frame({ 0x83 }, 7, slot(a));
+            code.bytes({ 0x00, 0x0f, 0x85 });
+            jump_to(b);
+            code.bytes({ 0xe9 });
+            jump_to(c);
+            break;
+        case opcode::LABEL:
+            labels[static_cast<std::size_t>(a)] = code.position();
+            break;
+        case opcode::CALL: {
+            auto const& arguments = function.arguments;
+
+            auto const count   = static_cast<std::size_t>(arguments[static_cast<std::size_t>(b)]);
+            auto const first   = static_cast<std::size_t>(b) + 1;
+            auto const passed  = std::min(count, std::size(argument_registers));
+            auto const stacked = count - passed;
+            auto const padding = stacked % 2 == 1 ? 8 : 0;
+
+            if (padding != 0)
+                code.bytes({ 0x48, 0x83, 0xec, 0x08 });
+
+            for (auto i = count; i-- > passed;) {
+                code.load(EAX, arguments[first + i]);
+                code.bytes({ 0x50 });
+            }
+
+            for (std::size_t i = 0; i < passed; ++i)
+                code.load(argument_registers[i], arguments[first + i]);
+
+            // straight to the callee if it was translated, to its stub if not
+            auto const callee = static_cast<std::size_t>(a);
+
+            code.bytes({ 0xe8 });
+            code.relative(this->entries[callee] != nullptr ? this->entries[callee] : this->stubs[callee]);
+
+            if (stacked > 0 || padding != 0) {
+                code.bytes({ 0x48, 0x81, 0xc4 });
+                code.dword(static_cast<std::int32_t>(8 * stacked + padding));
+            }
+
+            code.store(c, EAX);
+            break;
+        }
+        case opcode::RET:
+            code.load(EAX, a);
+            code.bytes({ 0xc9, 0xc3 });
+            break;
+        case opcode::INPUT:
+        case opcode::FINPUT:
+            code.address(EDI, this);
+            code.call(op == opcode::INPUT ? reinterpret_cast<void const*>(&input)
+                                          : reinterpret_cast<void const*>(&float_input));
+            code.store(c, EAX);
+            break;
+        case opcode::OUTPUT:
+        case opcode::FOUTPUT:
+            code.address(EDI, this);
+            code.load(ESI, a);
+            code.call(op == opcode::OUTPUT ? reinterpret_cast<void const*>(&output)
+                                           : reinterpret_cast<void const*>(&float_output));
+            break;
+        }
+    }
+
+    for (auto const& [where, label] : jumps)
+        writer(where).relative(labels[static_cast<std::size_t>(label)]);
+
+    this->used = static_cast<std::size_t>(code.position() - this->code);
+
+    ++this->statistics.translated;
+    this->statistics.code_bytes = this->used;
+}
+
+jit::jit(iloc_program program)
+    : self(std::make_unique<state>())
+{
+    auto& functions = program.functions;
+
+    // everything that could go wrong is checked here, as nothing can be
+    // complained about once translating is under way
+    auto bytes = stub_bytes * (functions.size() + NO_INPUT);
+
+    for (auto& function : functions) {
+        std::vector<bool> placed(function.labels, false);
+
+        for (auto const& code : function.code) {
+            if (code.op == opcode::LABEL)
+                placed[static_cast<std::size_t>(code.a)] = true;
+
+            if ((code.op == opcode::LOADAI || code.op == opcode::STOREAI || code.op == opcode::LOADAO
+                    || code.op == opcode::STOREAO)
+                && code.a != rbss)
+                fail("function \"{}\": memory can only be addressed from rbss, not r{}", function.name, code.a);
+
+            if ((code.op == opcode::LOADAI || code.op == opcode::STOREAI)
+                && (code.b < 0 || static_cast<std::uint32_t>(code.b) >= program.globals))
+                fail("function \"{}\": rbss + {} is outside of the globals", function.name, code.b);
+
+            if (code.op == opcode::CALL) {
+                auto const count = function.arguments[static_cast<std::size_t>(code.b)];
+                auto const& callee = functions[static_cast<std::size_t>(code.a)];
+
+                if (static_cast<std::uint32_t>(count) != callee.parameters)
+                    fail("function \"{}\" calls \"{}\" with {} arguments, but it takes {}", function.name, callee.name,
+                        count, callee.parameters);
+
+                bytes += 16 * static_cast<std::size_t>(count);
+            }
+        }
+
+        for (auto const& code : function.code) {
+            auto const jumps_to = [&](std::int32_t label) {
+                return label < 0 || static_cast<std::uint32_t>(label) >= function.labels
+                    || !placed[static_cast<std::size_t>(label)];
+            };
+
+            if ((code.op == opcode::JUMPI && jumps_to(code.a))
+                || (code.op == opcode::CBR && (jumps_to(code.b) || jumps_to(code.c))))
+                fail("function \"{}\" jumps to a label which is nowhere", function.name);
+        }
+
+        if (function.code.empty() || (function.code.back().op != opcode::RET && function.code.back().op != opcode::JUMPI))
+            fail("function \"{}\" runs off its end, which must be a ret or a jumpI", function.name);
+
+        function.registers = std::max(function.registers, used_registers(function));
+        bytes += function_bytes + 16 * function.parameters + instruction_bytes * function.code.size();
+    }
+
+    auto const page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+    self->program  = std::move(program);
+    self->capacity = (bytes + page - 1) / page * page;
+    self->memory.assign(self->program.globals, 0);
+    self->entries.assign(self->program.functions.size(), nullptr);
+
+    auto const region = mmap(nullptr, self->capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (region == MAP_FAILED)
+        fail("could not map {} bytes for the code", self->capacity);
+
+    self->code = static_cast<std::uint8_t*>(region);
+
+    writer code(self->code);
+
+    // each trap calls stop with its reason, which never returns
+    for (auto const why : { DIVISION, ADDRESS, DEPTH }) {
+        self->traps[why] = code.position();
+
+        code.address(EDI, self.get());
+        code.bytes({ 0xbe });
+        code.dword(why);
+        code.call(reinterpret_cast<void const*>(&stop));
+    }
+
+    // each stub keeps the arguments in the registers, aligns the stack and
+    // asks resolve where to go, given the call that got it there
+    for (std::size_t i = 0; i < self->program.functions.size(); ++i) {
+        self->stubs.push_back(code.position());
+
+        code.bytes({ 0x57, 0x56, 0x52, 0x51, 0x41, 0x50, 0x41, 0x51, 0x48, 0x83, 0xec, 0x08 });
+        code.address(EDI, self.get());
+        code.bytes({ 0xbe });
+        code.dword(static_cast<std::int32_t>(i));
+        code.bytes({ 0x48, 0x8b, 0x54, 0x24, 0x38 });
+        code.call(reinterpret_cast<void const*>(&resolve));
+        code.bytes({ 0x48, 0x83, 0xc4, 0x08, 0x41, 0x59, 0x41, 0x58, 0x59, 0x5a, 0x5e, 0x5f, 0xff, 0xe0 });
+    }
+
+    self->used = static_cast<std::size_t>(code.position() - self->code);
+    self->writable(false);
+}
+
+jit::~jit()
+{
+    if (self->code != nullptr)
+        munmap(self->code, self->capacity);
+}
+
+auto jit::run(std::FILE* in, std::FILE* out) -> std::int32_t
+{
+    auto const& functions = self->program.functions;
+
+    auto const found = std::ranges::find(functions, "main", &iloc_function::name);
+
+    if (found == functions.end())
+        fail("there is no function \"main\" to run");
+
+    if (found->parameters != 0)
+        fail("\"main\" takes {} arguments, but is run with none", found->parameters);
+
+    std::ranges::fill(self->memory, 0);
+
+    self->in    = in;
+    self->out   = out;
+    // finding the stack may mean reading /proc, so it's done once per thread
+    thread_local auto const lowest = lowest_stack_address();
+
+    self->limit = lowest + stack_margin;
+
+    auto const entry = resolve(self.get(), static_cast<std::uint32_t>(found - functions.begin()), nullptr);
+
+    switch (enter(self.get(), reinterpret_cast<std::int32_t (*)()>(entry))) {
+    case DIVISION:
+        fail("the program divides by zero");
+    case ADDRESS:
+        fail("the program reads or writes out of its {} words of memory", self->program.globals);
+    case DEPTH:
+        fail("the program calls too deep for the stack");
+    case NO_INPUT:
+        fail("the program reads a number, but the input has none");
+    default:
+        return self->returned;
+    }
+}
+
+auto jit::statistics() const -> jit_statistics
+{
+    return self->statistics;
+}
+
+}
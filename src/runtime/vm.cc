@@ -0,0 +1,360 @@
+/** @file vm.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "vm.hh"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace hcpsilva {
+
+namespace {
+
+    struct frame {
+        std::intptr_t const* resume; // where the caller goes on from
+        std::size_t          base;
+        std::uint32_t        size;
+        std::uint32_t        function;
+        std::int32_t         result; // register of the caller
+    };
+
+    template <typename... arguments>
+    [[noreturn]] auto fail(fmt::format_string<arguments...> format, arguments&&... values) -> void
+    {
+        throw std::runtime_error(fmt::format("vm error, {}\n", fmt::format(format, std::forward<arguments>(values)...)));
+    }
+
+    // wrapping around, as the hardware does
+    auto wrap(std::int64_t value) -> std::int32_t
+    {
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(value));
+    }
+
+    auto real(std::int32_t bits) -> float
+    {
+        return std::bit_cast<float>(bits);
+    }
+
+    auto word(float value) -> std::int32_t
+    {
+        return std::bit_cast<std::int32_t>(value);
+    }
+
+    // towards zero, giving what cvttss2si does for what doesn't fit an int
+    auto truncate(float value) -> std::int32_t
+    {
+        if (!(value >= -2147483648.0f && value < 2147483648.0f))
+            return std::numeric_limits<std::int32_t>::min();
+
+        return static_cast<std::int32_t>(value);
+    }
+
+}
+
+virtual_machine::virtual_machine(bytecode_program program)
+    : program(std::move(program))
+{
+}
+
+auto virtual_machine::thread(void* const* handlers) -> void
+{
+    auto const& code = this->program.code;
+
+    this->threaded.assign(code.begin(), code.end());
+
+    for (std::size_t i = 0; i < code.size(); i += instruction_size(&code[i])) {
+        auto const op = static_cast<bytecode_op>(code[i]);
+
+        this->threaded[i] = reinterpret_cast<std::intptr_t>(handlers[code[i]]);
+
+        // jumps go straight to where they land in the threaded code
+        if (op == bytecode_op::JUMP) {
+            this->threaded[i + 1] = reinterpret_cast<std::intptr_t>(&this->threaded[code[i + 1]]);
+        } else if (op == bytecode_op::BRANCH) {
+            this->threaded[i + 2] = reinterpret_cast<std::intptr_t>(&this->threaded[code[i + 2]]);
+            this->threaded[i + 3] = reinterpret_cast<std::intptr_t>(&this->threaded[code[i + 3]]);
+        }
+    }
+}
+
+// computed gotos are GNU C, which pedantic warnings are all about
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+auto virtual_machine::run(std::string_view entry, std::FILE* in, std::FILE* out) -> std::int32_t
+{
+    // in the order of bytecode_op
+    static void* const handlers[] = {
+        &&op_add,
+        &&op_sub,
+        &&op_mult,
+        &&op_div,
+        &&op_mod,
+        &&op_cmp_lt,
+        &&op_cmp_le,
+        &&op_cmp_eq,
+        &&op_cmp_ge,
+        &&op_cmp_gt,
+        &&op_cmp_ne,
+        &&op_fadd,
+        &&op_fsub,
+        &&op_fmult,
+        &&op_fdiv,
+        &&op_fcmp_lt,
+        &&op_fcmp_le,
+        &&op_fcmp_eq,
+        &&op_fcmp_ge,
+        &&op_fcmp_gt,
+        &&op_fcmp_ne,
+        &&op_addi,
+        &&op_multi,
+        &&op_rsubi,
+        &&op_loadi,
+        &&op_move,
+        &&op_i2f,
+        &&op_f2i,
+        &&op_load,
+        &&op_loadx,
+        &&op_store,
+        &&op_storex,
+        &&op_jump,
+        &&op_branch,
+        &&op_call,
+        &&op_ret,
+        &&op_input,
+        &&op_output,
+        &&op_finput,
+        &&op_foutput,
+    };
+
+    if (this->threaded.size() != this->program.code.size())
+        this->thread(handlers);
+
+    auto const& functions = this->program.functions;
+
+    auto const found = std::ranges::find(functions, entry, &bytecode_function::name);
+
+    if (found == functions.end())
+        fail("there is no function \"{}\" to run", entry);
+
+    if (found->parameters != 0)
+        fail("\"{}\" takes {} arguments, but is run with none", entry, found->parameters);
+
+    this->memory.assign(this->program.memory, 0);
+    this->registers.assign(std::max<std::size_t>(found->registers, 1 << 12), 0);
+
+    std::vector<frame> frames;
+
+    auto  function = static_cast<std::uint32_t>(found - functions.begin());
+    auto  base     = std::size_t { 0 };
+    auto  size     = found->registers;
+    auto* r        = this->registers.data();
+    auto* m        = this->memory.data();
+    auto  words    = static_cast<std::uint32_t>(this->memory.size());
+
+    std::intptr_t const* pc = &this->threaded[found->entry];
+
+    std::int32_t value = 0;
+
+#define NEXT(length) \
+    pc += (length);  \
+    goto* reinterpret_cast<void*>(*pc)
+
+#define BINARY(label, expression)     \
+    label : {                         \
+        auto const a = r[pc[1]];      \
+        auto const b = r[pc[2]];      \
+                                      \
+        r[pc[3]] = (expression);      \
+        NEXT(4);                      \
+    }
+
+#define CHECK_ADDRESS(address)                        \
+    if (static_cast<std::uint32_t>(address) >= words) \
+        fail("\"{}\" reads or writes address {}, but memory has {} words", functions[function].name, (address), words)
+
+    goto* reinterpret_cast<void*>(*pc);
+
+    BINARY(op_add, wrap(std::int64_t { a } + b))
+    BINARY(op_sub, wrap(std::int64_t { a } - b))
+    BINARY(op_mult, wrap(std::int64_t { a } * b))
+    BINARY(op_cmp_lt, a < b)
+    BINARY(op_cmp_le, a <= b)
+    BINARY(op_cmp_eq, a == b)
+    BINARY(op_cmp_ge, a >= b)
+    BINARY(op_cmp_gt, a > b)
+    BINARY(op_cmp_ne, a != b)
+    BINARY(op_fadd, word(real(a) + real(b)))
+    BINARY(op_fsub, word(real(a) - real(b)))
+    BINARY(op_fmult, word(real(a) * real(b)))
+    BINARY(op_fdiv, word(real(a) / real(b)))
+    BINARY(op_fcmp_lt, real(a) < real(b))
+    BINARY(op_fcmp_le, real(a) <= real(b))
+    BINARY(op_fcmp_eq, real(a) == real(b))
+    BINARY(op_fcmp_ge, real(a) >= real(b))
+    BINARY(op_fcmp_gt, real(a) > real(b))
+    BINARY(op_fcmp_ne, real(a) != real(b))
+
+#define DIVISION(label, symbol)                                         \
+    label : {                                                           \
+        auto const a = r[pc[1]];                                        \
+        auto const b = r[pc[2]];                                        \
+                                                                        \
+        if (b == 0)                                                     \
+            fail("\"{}\" divides by zero", functions[function].name);  \
+                                                                        \
+        r[pc[3]] = wrap(std::int64_t { a } symbol b);                   \
+        NEXT(4);                                                        \
+    }
+
+    DIVISION(op_div, /)
+    DIVISION(op_mod, %)
+
+op_addi:
+    r[pc[3]] = wrap(std::int64_t { r[pc[1]] } + pc[2]);
+    NEXT(4);
+
+op_multi:
+    r[pc[3]] = wrap(std::int64_t { r[pc[1]] } * pc[2]);
+    NEXT(4);
+
+op_rsubi:
+    r[pc[3]] = wrap(pc[2] - std::int64_t { r[pc[1]] });
+    NEXT(4);
+
+op_loadi:
+    r[pc[2]] = static_cast<std::int32_t>(pc[1]);
+    NEXT(3);
+
+op_move:
+    r[pc[2]] = r[pc[1]];
+    NEXT(3);
+
+op_i2f:
+    r[pc[2]] = word(static_cast<float>(r[pc[1]]));
+    NEXT(3);
+
+op_f2i:
+    r[pc[2]] = truncate(real(r[pc[1]]));
+    NEXT(3);
+
+op_load:
+    r[pc[2]] = m[pc[1]];
+    NEXT(3);
+
+op_loadx:
+    CHECK_ADDRESS(r[pc[1]]);
+    r[pc[2]] = m[r[pc[1]]];
+    NEXT(3);
+
+op_store:
+    m[pc[2]] = r[pc[1]];
+    NEXT(3);
+
+op_storex:
+    CHECK_ADDRESS(r[pc[2]]);
+    m[r[pc[2]]] = r[pc[1]];
+    NEXT(3);
+
+op_jump:
+    pc = reinterpret_cast<std::intptr_t const*>(pc[1]);
+    goto* reinterpret_cast<void*>(*pc);
+
+op_branch:
+    pc = reinterpret_cast<std::intptr_t const*>(r[pc[1]] != 0 ? pc[2] : pc[3]);
+    goto* reinterpret_cast<void*>(*pc);
+
+op_call : {
+    auto const& callee = functions[pc[1]];
+    auto const  count  = static_cast<std::size_t>(pc[3]);
+    auto const  next   = base + size;
+
+    if (frames.size() == max_depth)
+        fail("\"{}\" calls \"{}\" deeper than {} calls", functions[function].name, callee.name, max_depth);
+
+    if (next + callee.registers > this->registers.size()) {
+        this->registers.resize(std::max(next + callee.registers, 2 * this->registers.size()));
+        r = this->registers.data() + base;
+    }
+
+    auto* const arguments = this->registers.data() + next;
+
+    for (std::size_t i = 0; i < count; ++i)
+        arguments[i] = r[pc[4 + i]];
+
+    std::fill(arguments + count, arguments + callee.registers, 0);
+
+    frames.push_back({ pc + 4 + count, base, size, function, static_cast<std::int32_t>(pc[2]) });
+
+    function = static_cast<std::uint32_t>(pc[1]);
+    base     = next;
+    size     = callee.registers;
+    r        = arguments;
+    pc       = &this->threaded[callee.entry];
+    goto* reinterpret_cast<void*>(*pc);
+}
+
+op_ret:
+    value = r[pc[1]];
+
+    if (frames.empty())
+        return value;
+
+    base     = frames.back().base;
+    size     = frames.back().size;
+    function = frames.back().function;
+    r        = this->registers.data() + base;
+    pc       = frames.back().resume;
+
+    r[frames.back().result] = value;
+    frames.pop_back();
+    goto* reinterpret_cast<void*>(*pc);
+
+op_input:
+    if (std::fscanf(in, "%d", &value) != 1)
+        fail("\"{}\" reads a number, but the input has none", functions[function].name);
+
+    r[pc[1]] = value;
+    NEXT(2);
+
+op_output:
+    fmt::print(out, "{}\n", r[pc[1]]);
+    NEXT(2);
+
+op_finput : {
+    float read = 0;
+
+    if (std::fscanf(in, "%f", &read) != 1)
+        fail("\"{}\" reads a number, but the input has none", functions[function].name);
+
+    r[pc[1]] = word(read);
+    NEXT(2);
+}
+
+op_foutput:
+    fmt::print(out, "{:g}\n", real(r[pc[1]]));
+    NEXT(2);
+
+#undef CHECK_ADDRESS
+#undef DIVISION
+#undef BINARY
+#undef NEXT
+}
+
+#pragma GCC diagnostic pop
+
+}
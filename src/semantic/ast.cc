@@ -5,4 +5,22 @@
 
 namespace hcpsilva {
 
+auto branches_of(ast_node const& node) -> if_branches
+{
+    auto const condition = node.children.first;
+
+    if (condition == nullptr || condition->sibling == nullptr)
+        return {};
+
+    auto const first = condition->sibling;
+
+    if (first->sibling != nullptr)
+        return { first, first->sibling };
+
+    if (first->value.location.begin < node.value.location.end)
+        return { first, nullptr };
+
+    return { nullptr, first };
+}
+
 }
@@ -0,0 +1,407 @@
+/** @file ast_binary.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "ast_binary.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <fmt/core.h>
+#include <magic_enum.hpp>
+
+namespace hcpsilva {
+
+namespace {
+
+    constexpr char          magic[8]   = { 'c', 'p', 'p', '-', 'a', 's', 't', '\0' };
+    constexpr std::uint32_t byte_order = 0x01020304;
+    constexpr std::uint32_t none       = std::numeric_limits<std::uint32_t>::max();
+
+    struct file_header {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t node_count;
+        std::uint64_t name_count;
+        std::uint64_t names_offset; // name_count name_entry
+        std::uint64_t text_offset;
+        std::uint64_t text_size;
+        std::uint64_t nodes_offset; // node_count node_record
+        std::uint32_t source_name_offset; // into the text
+        std::uint32_t source_name_length;
+    };
+
+    struct name_entry {
+        std::uint32_t offset; // into the text
+        std::uint32_t length;
+    };
+
+    struct node_record {
+        std::uint8_t    kind; // index of the alternative of the lexic_value
+        std::uint8_t    type; // of what the node computes
+        std::uint8_t    padding[2];
+        std::uint32_t   first_child;
+        std::uint32_t   last_child;
+        std::uint32_t   sibling;
+        std::uint32_t   next;
+        std::uint32_t   reserved;
+        std::uint64_t   payload; // the value itself, or the index of its name
+        std::uint32_t   begin;   // byte offsets into the source
+        std::uint32_t   end;
+    };
+
+    static_assert(sizeof(file_header) == 72);
+    static_assert(sizeof(node_record) == 40);
+    static_assert(std::variant_size_v<lexic_value> < 256);
+
+    // nodes are built in place and never destroyed one by one
+    static_assert(std::is_trivially_destructible_v<ast_node>);
+
+    auto align(std::uint64_t offset) -> std::uint64_t { return (offset + 7) & ~std::uint64_t(7); }
+
+    auto corrupt(std::string_view reason) -> std::runtime_error
+    {
+        return std::runtime_error(fmt::format("ast error, corrupt tree file: {}\n", reason));
+    }
+
+    template <typename E>
+    auto decode_enum(std::uint64_t payload) -> E
+    {
+        if (payload >= magic_enum::enum_count<E>())
+            throw corrupt("enum value out of range");
+
+        return static_cast<E>(payload);
+    }
+
+    /** @brief the names a tree uses, numbered in the order they show up */
+    class name_table {
+    public:
+        explicit name_table(string_pool const& strings)
+            : strings(strings)
+            , indices(strings.size(), none)
+        {
+        }
+
+        auto index(identifier name) -> std::uint32_t
+        {
+            auto& slot = this->indices[name.id];
+
+            if (slot == none) {
+                auto const text = this->strings.name(name);
+
+                slot = static_cast<std::uint32_t>(this->entries.size());
+
+                this->entries.push_back({ static_cast<std::uint32_t>(this->text.size()), static_cast<std::uint32_t>(text.size()) });
+                this->text.append(text);
+            }
+
+            return slot;
+        }
+
+        string_pool const&         strings;
+        std::vector<std::uint32_t> indices; // by identifier
+        std::vector<name_entry>    entries;
+        std::string                text;
+    };
+
+    auto encode(lexic_value const& value, name_table& names) -> std::uint64_t
+    {
+        return std::visit(
+            [&](auto const& v) -> std::uint64_t {
+                using type = std::decay_t<decltype(v)>;
+
+                if constexpr (std::is_same_v<type, std::monostate>)
+                    return 0;
+                else if constexpr (std::is_enum_v<type>)
+                    return static_cast<std::uint64_t>(v);
+                else if constexpr (std::is_same_v<type, int>)
+                    return static_cast<std::uint64_t>(static_cast<std::int64_t>(v));
+                else if constexpr (std::is_same_v<type, double>)
+                    return std::bit_cast<std::uint64_t>(v);
+                else if constexpr (std::is_same_v<type, bool> || std::is_same_v<type, char>)
+                    return static_cast<unsigned char>(v);
+                else if constexpr (std::is_same_v<type, identifier>)
+                    return names.index(v);
+                else
+                    return names.index(v.callee);
+            },
+            value);
+    }
+
+    auto decode(std::uint8_t kind, std::uint64_t payload, std::vector<identifier> const& names) -> lexic_value
+    {
+        auto const name = [&] {
+            if (payload >= names.size())
+                throw corrupt("name out of range");
+
+            return names[payload];
+        };
+
+        switch (kind) {
+        case 0:
+            return std::monostate {};
+        case 1:
+            return decode_enum<types>(payload);
+        case 2:
+            return decode_enum<keywords>(payload);
+        case 3:
+            return decode_enum<operations>(payload);
+        case 4:
+            return static_cast<int>(static_cast<std::int64_t>(payload));
+        case 5:
+            return payload != 0;
+        case 6:
+            return std::bit_cast<double>(payload);
+        case 7:
+            return static_cast<char>(payload);
+        case 8:
+            return name();
+        case 9:
+            return function_call { name() };
+        default:
+            throw corrupt("unknown kind of value");
+        }
+    }
+
+    // the alternatives above are numbered by their position in lexic_value
+    static_assert(std::is_same_v<std::variant_alternative_t<1, lexic_value>, types>);
+    static_assert(std::is_same_v<std::variant_alternative_t<3, lexic_value>, operations>);
+    static_assert(std::is_same_v<std::variant_alternative_t<9, lexic_value>, function_call>);
+    static_assert(std::variant_size_v<lexic_value> == 10);
+
+}
+
+auto save_ast(std::string const& path, ast_node const* root, string_pool const& strings, std::string_view source_name)
+    -> void
+{
+    // a node to encode, and the one it's linked from (as a child or as the
+    // next of its chain)
+    struct pending {
+        ast_node const* node;
+        std::uint32_t   from;
+        bool            child;
+    };
+
+    name_table               names(strings);
+    std::vector<node_record> records;
+    std::vector<pending>     stack;
+
+    if (root != nullptr)
+        stack.push_back({ root, none, false });
+
+    // depth first, children before the chain that follows, so the children
+    // of a node are reached in order and can be linked as they come
+    while (!stack.empty()) {
+        auto const [node, from, child] = stack.back();
+        auto const index               = static_cast<std::uint32_t>(records.size());
+
+        stack.pop_back();
+
+        node_record record {};
+
+        record.kind        = static_cast<std::uint8_t>(node->value.value.index());
+        record.type        = static_cast<std::uint8_t>(node->value.type);
+        record.first_child = none;
+        record.last_child  = none;
+        record.sibling     = none;
+        record.next        = none;
+        record.payload     = encode(node->value.value, names);
+        record.begin       = node->value.location.begin;
+        record.end         = node->value.location.end;
+
+        records.push_back(record);
+
+        if (from != none && child) {
+            auto& parent = records[from];
+
+            if (parent.last_child == none)
+                parent.first_child = index;
+            else
+                records[parent.last_child].sibling = index;
+
+            parent.last_child = index;
+        } else if (from != none) {
+            records[from].next = index;
+        }
+
+        if (node->next != nullptr)
+            stack.push_back({ node->next, index, false });
+
+        auto const first_child = stack.size();
+
+        for (auto const& child_node : node->children)
+            stack.push_back({ &child_node, index, true });
+
+        std::reverse(stack.begin() + static_cast<std::ptrdiff_t>(first_child), stack.end());
+    }
+
+    auto const source_name_offset = names.text.size();
+
+    names.text.append(source_name);
+
+    file_header header {};
+
+    std::memcpy(header.magic, magic, sizeof(magic));
+
+    header.version            = ast_file::version;
+    header.byte_order         = byte_order;
+    header.node_count         = records.size();
+    header.name_count         = names.entries.size();
+    header.names_offset       = align(sizeof(file_header));
+    header.text_offset        = align(header.names_offset + names.entries.size() * sizeof(name_entry));
+    header.text_size          = names.text.size();
+    header.nodes_offset       = align(header.text_offset + header.text_size);
+    header.source_name_offset = static_cast<std::uint32_t>(source_name_offset);
+    header.source_name_length = static_cast<std::uint32_t>(source_name.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+
+    auto const pad_to = [&out](std::uint64_t offset) {
+        while (static_cast<std::uint64_t>(out.tellp()) < offset)
+            out.put('\0');
+    };
+
+    out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    pad_to(header.names_offset);
+    out.write(reinterpret_cast<char const*>(names.entries.data()), static_cast<std::streamsize>(names.entries.size() * sizeof(name_entry)));
+    pad_to(header.text_offset);
+    out.write(names.text.data(), static_cast<std::streamsize>(names.text.size()));
+    pad_to(header.nodes_offset);
+    out.write(reinterpret_cast<char const*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(node_record)));
+
+    if (!out.flush())
+        throw std::runtime_error(fmt::format("ast error, could not write \"{}\"\n", path));
+}
+
+auto ast_file::open(std::string const& path) -> ast_file
+{
+    ast_file file;
+
+    file.contents = source_buffer::open(path);
+
+    auto const size = file.contents.size();
+
+    file_header header;
+
+    if (size < sizeof(header))
+        throw corrupt("too short");
+
+    std::memcpy(&header, file.contents.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+        throw std::runtime_error(fmt::format("ast error, \"{}\" is not a tree file\n", path));
+
+    if (header.byte_order != byte_order)
+        throw std::runtime_error(fmt::format("ast error, \"{}\" was written with another byte order\n", path));
+
+    if (header.version != version)
+        throw std::runtime_error(fmt::format("ast error, \"{}\" has version {}, expected {}\n", path, header.version, version));
+
+    auto const fits = [size](std::uint64_t offset, std::uint64_t count, std::uint64_t element) {
+        return offset <= size && count <= (size - offset) / element;
+    };
+
+    if (!fits(header.names_offset, header.name_count, sizeof(name_entry)) || !fits(header.text_offset, header.text_size, 1)
+        || !fits(header.nodes_offset, header.node_count, sizeof(node_record)) || header.node_count >= none
+        || header.names_offset % 8 != 0 || header.nodes_offset % 8 != 0
+        || std::uint64_t(header.source_name_offset) + header.source_name_length > header.text_size)
+        throw corrupt("sections out of bounds");
+
+    file.nodes = header.node_count;
+
+    return file;
+}
+
+auto ast_file::source_name() const -> std::string_view
+{
+    file_header header;
+
+    std::memcpy(&header, this->contents.data(), sizeof(header));
+
+    return this->contents.view().substr(header.text_offset + header.source_name_offset, header.source_name_length);
+}
+
+auto ast_file::load(arena& storage, string_pool& strings, yy::location::file_type file) const -> ast_node*
+{
+    file_header header;
+
+    std::memcpy(&header, this->contents.data(), sizeof(header));
+
+    if (header.node_count == 0)
+        return nullptr;
+
+    auto const base = this->contents.data();
+    auto const text = this->contents.view().substr(header.text_offset, header.text_size);
+
+    // names are interned once each, nodes then refer to them by index
+    std::vector<identifier> names;
+
+    names.reserve(header.name_count);
+
+    for (std::uint64_t i = 0; i < header.name_count; ++i) {
+        name_entry entry;
+
+        std::memcpy(&entry, base + header.names_offset + i * sizeof(name_entry), sizeof(entry));
+
+        if (std::uint64_t(entry.offset) + entry.length > text.size())
+            throw corrupt("name out of bounds");
+
+        names.push_back(strings.intern(text.substr(entry.offset, entry.length)));
+    }
+
+    // every node comes out of this one block, and the records are read
+    // straight from the mapping
+    auto const count = header.node_count;
+    auto const nodes = static_cast<ast_node*>(storage.allocate(count * sizeof(ast_node), alignof(ast_node)));
+
+    // nodes are in the order they are reached, so every link points further
+    // ahead. anything else would make a corrupt file loop forever
+    auto const link = [&](std::uint32_t index, std::uint64_t from) -> ast_node* {
+        if (index == none)
+            return nullptr;
+
+        if (index >= count || index <= from)
+            throw corrupt("link out of range");
+
+        return &nodes[index];
+    };
+
+    for (std::uint64_t i = 0; i < count; ++i) {
+        node_record record;
+
+        std::memcpy(&record, base + header.nodes_offset + i * sizeof(node_record), sizeof(record));
+
+        auto node = ::new (&nodes[i]) ast_node(ast_value {
+            decode(record.kind, record.payload, names),
+            yy::location(file, record.begin, record.end),
+            decode_enum<types>(record.type),
+        });
+
+        node->children.first = link(record.first_child, i);
+        node->children.last  = link(record.last_child, i);
+        node->sibling        = link(record.sibling, i);
+        node->next           = link(record.next, i);
+    }
+
+    return &nodes[0];
+}
+
+}
@@ -0,0 +1,259 @@
+/** @file ast_emitter.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "ast_emitter.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include <magic_enum.hpp>
+
+namespace hcpsilva {
+
+namespace {
+
+    // labels of every enum member, in declaration order. these are what the
+    // fmt formatters print, minus the work of getting there on every node
+    template <typename E, std::size_t N>
+    constexpr auto label_table(std::array<std::string_view, N> labels)
+    {
+        static_assert(N == magic_enum::enum_count<E>(), "a label is missing from the table");
+
+        return labels;
+    }
+
+    constexpr auto keyword_labels = label_table<keywords>(std::to_array<std::string_view>({
+        "if",
+        "while",
+        "input",
+        "output",
+        "return",
+    }));
+
+    constexpr auto type_labels = label_table<types>(std::to_array<std::string_view>({
+        "int",
+        "float",
+        "char",
+        "bool",
+    }));
+
+    constexpr auto operation_labels = label_table<operations>(std::to_array<std::string_view>({
+        "=",
+        "<=",
+        "/",
+        "*",
+        "%",
+        "<",
+        ">",
+        "<=",
+        ">=",
+        "==",
+        "!=",
+        "&&",
+        "||",
+        "!",
+        "+",
+        "-",
+        "[]",
+        "^",
+    }));
+
+    // the output is written out whenever this much of it piles up
+    constexpr std::size_t flush_threshold = 1 << 20;
+
+    auto append(fmt::memory_buffer& buffer, std::string_view text) -> void
+    {
+        buffer.append(text.data(), text.data() + text.size());
+    }
+
+    auto append(fmt::memory_buffer& buffer, std::uint32_t number) -> void
+    {
+        fmt::format_int const digits(number);
+
+        buffer.append(digits.data(), digits.data() + digits.size());
+    }
+
+    auto write(fmt::memory_buffer& buffer, std::FILE* out) -> void
+    {
+        std::fwrite(buffer.data(), 1, buffer.size(), out);
+
+        buffer.clear();
+    }
+
+    /** @brief a label made safe for the given format, which escapes quotes in
+     * dot and whitespace in the edge list */
+    auto append_escaped(fmt::memory_buffer& buffer, std::string_view text, ast_format format) -> void
+    {
+        for (auto const c : text) {
+            if (format == ast_format::DOT && (c == '"' || c == '\\'))
+                buffer.push_back('\\');
+
+            if (format == ast_format::EDGES && c == '\t')
+                append(buffer, "\\t");
+            else
+                buffer.push_back(c);
+        }
+    }
+
+}
+
+auto parse_ast_format(std::string_view name) -> std::optional<ast_format>
+{
+    if (name == "legacy")
+        return ast_format::LEGACY;
+
+    if (name == "dot")
+        return ast_format::DOT;
+
+    if (name == "edges")
+        return ast_format::EDGES;
+
+    return std::nullopt;
+}
+
+auto ast_emitter::label(lexic_value const& value, fmt::memory_buffer& buffer) const -> void
+{
+    auto const out = std::back_inserter(buffer);
+
+    std::visit(
+        [&](auto const& v) {
+            using type = std::decay_t<decltype(v)>;
+
+            if constexpr (std::is_same_v<type, keywords>)
+                append(buffer, keyword_labels[static_cast<std::size_t>(v)]);
+            else if constexpr (std::is_same_v<type, types>)
+                append(buffer, type_labels[static_cast<std::size_t>(v)]);
+            else if constexpr (std::is_same_v<type, operations>)
+                append(buffer, operation_labels[static_cast<std::size_t>(v)]);
+            else if constexpr (std::is_same_v<type, identifier>)
+                append(buffer, this->strings.name(v));
+            else if constexpr (std::is_same_v<type, function_call>) {
+                append(buffer, "call ");
+                append(buffer, this->strings.name(v.callee));
+            } else if constexpr (std::is_same_v<type, std::monostate>)
+                append(buffer, "monostate");
+            else
+                fmt::format_to(out, "{}", v);
+        },
+        value);
+}
+
+auto ast_emitter::emit(ast_node const* root, std::FILE* out) -> void
+{
+    // a node to visit and the id of the one it hangs from, if any
+    struct pending {
+        ast_node const* node;
+        std::uint32_t   parent;
+    };
+
+    constexpr auto no_parent = ~std::uint32_t(0);
+
+    // both legacy and the edge list have every edge after every node, so
+    // their edges are held back until the end. dot is written as it goes
+    fmt::memory_buffer nodes, edges, label_text;
+
+    std::vector<pending> stack;
+    std::uint32_t        next_id = 0;
+
+    if (this->format == ast_format::DOT)
+        append(nodes, "digraph ast {\n");
+
+    if (root != nullptr)
+        stack.push_back({ root, no_parent });
+
+    while (!stack.empty()) {
+        auto const [node, parent] = stack.back();
+        auto const id             = next_id++;
+
+        stack.pop_back();
+
+        // the chain that follows goes after the children, so it's pushed first
+        if (node->next != nullptr)
+            stack.push_back({ node->next, id });
+
+        auto const first_child = stack.size();
+
+        for (auto const& child : node->children)
+            stack.push_back({ &child, id });
+
+        std::reverse(stack.begin() + first_child, stack.end());
+
+        label_text.clear();
+        this->label(node->value.value, label_text);
+
+        std::string_view const text(label_text.data(), label_text.size());
+
+        switch (this->format) {
+        case ast_format::LEGACY:
+            append(nodes, id);
+            append(nodes, " [label=\"");
+            append(nodes, text);
+            append(nodes, "\"]\n");
+
+            if (parent != no_parent) {
+                append(edges, parent);
+                append(edges, ", ");
+                append(edges, id);
+                edges.push_back('\n');
+            }
+            break;
+        case ast_format::DOT:
+            append(nodes, "  n");
+            append(nodes, id);
+            append(nodes, " [label=\"");
+            append_escaped(nodes, text, this->format);
+            append(nodes, "\"];\n");
+
+            if (parent != no_parent) {
+                append(nodes, "  n");
+                append(nodes, parent);
+                append(nodes, " -> n");
+                append(nodes, id);
+                append(nodes, ";\n");
+            }
+            break;
+        case ast_format::EDGES:
+            append(nodes, id);
+            nodes.push_back('\t');
+            append_escaped(nodes, text, this->format);
+            nodes.push_back('\n');
+
+            if (parent != no_parent) {
+                append(edges, parent);
+                edges.push_back('\t');
+                append(edges, id);
+                edges.push_back('\n');
+            }
+            break;
+        }
+
+        if (nodes.size() >= flush_threshold)
+            write(nodes, out);
+    }
+
+    if (this->format == ast_format::DOT)
+        append(nodes, "}\n");
+
+    if (this->format == ast_format::EDGES)
+        nodes.push_back('\n');
+
+    write(nodes, out);
+    write(edges, out);
+}
+
+}
@@ -0,0 +1,436 @@
+/** @file ast_folder.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "ast_folder.hh"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace hcpsilva {
+
+namespace {
+
+    // a literal as C takes it in an operation
+    struct number {
+        bool         floating = false;
+        std::int64_t integer  = 0;
+        double       real     = 0;
+
+        auto truth() const -> bool { return this->floating ? this->real != 0 : this->integer != 0; }
+    };
+
+    auto literal_of(ast_node const* node) -> std::optional<number>
+    {
+        if (node == nullptr)
+            return std::nullopt;
+
+        return std::visit(
+            [](auto const& value) -> std::optional<number> {
+                using type = std::decay_t<decltype(value)>;
+
+                if constexpr (std::is_same_v<type, double>)
+                    return number { true, 0, value };
+                else if constexpr (type_in<type, int, bool, char>)
+                    return number { false, value, static_cast<double>(value) };
+                else
+                    return std::nullopt;
+            },
+            node->value.value);
+    }
+
+    auto operation_of(ast_node const* node) -> std::optional<operations>
+    {
+        if (auto const op = std::get_if<operations>(&node->value.value))
+            return *op;
+
+        return std::nullopt;
+    }
+
+    // a literal equal to value, which a float converted to is as well
+    auto is_integer(ast_node const* node, int value) -> bool
+    {
+        if (auto const real = std::get_if<double>(&node->value.value))
+            return *real == value;
+
+        auto const integer = std::get_if<int>(&node->value.value);
+
+        return integer != nullptr && *integer == value;
+    }
+
+    // whether node can only be true or false, so negating it twice or
+    // anding it with true gives it back as it is
+    auto is_boolean(ast_node const* node) -> bool
+    {
+        if (std::holds_alternative<bool>(node->value.value))
+            return true;
+
+        auto const op = operation_of(node);
+
+        return op.has_value() && *op >= operations::LESS_THAN && *op <= operations::NEGATION;
+    }
+
+    // ints wrap around, as they would at run time
+    auto wrap(std::int64_t value) -> int
+    {
+        return static_cast<int>(static_cast<std::uint32_t>(value));
+    }
+
+    auto evaluate(operations op, number operand) -> std::optional<lexic_value>
+    {
+        switch (op) {
+        case operations::NEGATION:
+            return !operand.truth();
+        case operations::NEGATIVE:
+            return operand.floating ? lexic_value { -operand.real } : lexic_value { wrap(-operand.integer) };
+        case operations::POSITIVE:
+            return operand.floating ? lexic_value { operand.real } : lexic_value { wrap(operand.integer) };
+        default:
+            return std::nullopt;
+        }
+    }
+
+    auto evaluate(operations op, number lhs, number rhs) -> std::optional<lexic_value>
+    {
+        auto const floating = lhs.floating || rhs.floating;
+
+        auto const arithmetic = [&](auto integer, auto real) -> lexic_value {
+            if (floating)
+                return real(lhs.real, rhs.real);
+
+            return wrap(integer(lhs.integer, rhs.integer));
+        };
+
+        auto const comparison = [&](auto compare) -> lexic_value {
+            return floating ? compare(lhs.real, rhs.real) : compare(lhs.integer, rhs.integer);
+        };
+
+        switch (op) {
+        case operations::DIVISION:
+            return arithmetic(std::divides {}, std::divides {});
+        case operations::MULTIPLICATION:
+            return arithmetic(std::multiplies {}, std::multiplies {});
+        case operations::POSITIVE:
+            return arithmetic(std::plus {}, std::plus {});
+        case operations::NEGATIVE:
+            return arithmetic(std::minus {}, std::minus {});
+        case operations::REST:
+            if (floating)
+                return std::nullopt;
+            return wrap(lhs.integer % rhs.integer);
+        case operations::LESS_THAN:
+            return comparison(std::less {});
+        case operations::GREATER_THAN:
+            return comparison(std::greater {});
+        case operations::LESS_EQUAL:
+            return comparison(std::less_equal {});
+        case operations::GREATER_EQUAL:
+            return comparison(std::greater_equal {});
+        case operations::EQUAL:
+            return comparison(std::equal_to {});
+        case operations::NOT_EQUAL:
+            return comparison(std::not_equal_to {});
+        case operations::AND:
+            return lhs.truth() && rhs.truth();
+        case operations::OR:
+            return lhs.truth() || rhs.truth();
+        default:
+            return std::nullopt;
+        }
+    }
+
+    // the nodes under an operand, and whether evaluating it calls anything
+    struct operand_shape {
+        std::size_t nodes = 0;
+        bool        pure  = true;
+    };
+
+    auto shape_of(ast_node const* node) -> operand_shape
+    {
+        operand_shape result;
+
+        if (node == nullptr)
+            return result;
+
+        for (auto const& inner : node->preorder()) {
+            ++result.nodes;
+            result.pure = result.pure && !std::holds_alternative<function_call>(inner.value.value);
+        }
+
+        return result;
+    }
+
+    // what's left of a node removed from the tree, until it's unlinked
+    auto is_removed(ast_node const* node) -> bool
+    {
+        return node != nullptr && std::holds_alternative<std::monostate>(node->value.value);
+    }
+
+}
+
+auto ast_folder::fold(ast_node* root) -> void
+{
+    if (root == nullptr)
+        return;
+
+    // each node is done after everything under it, so its operands are
+    // already as folded as they get. nodes are only ever changed in place,
+    // which leaves the links the walk goes by as they were
+    for (auto& node : root->postorder()) {
+        if (std::holds_alternative<operations>(node.value.value)) {
+            this->fold_operation(node);
+        } else if (std::holds_alternative<types>(node.value.value)) {
+            this->fold_conversion(node);
+        } else if (auto const keyword = std::get_if<keywords>(&node.value.value)) {
+            if (*keyword == keywords::IF)
+                this->prune_if(node);
+            else if (*keyword == keywords::WHILE)
+                this->prune_while(node);
+        }
+    }
+
+    if (this->counts.pruned != 0)
+        this->remove_empty(root);
+}
+
+auto ast_folder::fold_operation(ast_node& node) -> void
+{
+    auto const op  = std::get<operations>(node.value.value);
+    auto const lhs = node.children.first;
+
+    if (lhs == nullptr)
+        return;
+
+    switch (op) {
+    case operations::ATTRIBUTION:
+    case operations::INITIALIZATION:
+    case operations::INDEX:
+    case operations::INDEX_SEP:
+        return;
+    default:
+        break;
+    }
+
+    auto const rhs = lhs->sibling;
+
+    auto const to_value = [&](lexic_value value, std::size_t removed) {
+        node.value.value = std::move(value);
+        node.children    = {};
+
+        ++this->counts.folded;
+        this->counts.removed += removed;
+    };
+
+    auto const to_operand = [&](ast_node* operand) {
+        this->replace(node, operand);
+
+        ++this->counts.simplified;
+        this->counts.removed += 2;
+    };
+
+    if (rhs == nullptr) {
+        if (auto const operand = literal_of(lhs)) {
+            if (auto const result = evaluate(op, *operand))
+                to_value(*result, 1);
+        } else if (op == operations::NEGATION && operation_of(lhs) == operations::NEGATION && is_boolean(lhs->children.first)) {
+            to_operand(lhs->children.first);
+        }
+
+        return;
+    }
+
+    auto const left  = literal_of(lhs);
+    auto const right = literal_of(rhs);
+
+    if (left && right) {
+        if ((op == operations::DIVISION || op == operations::REST) && !right->truth()) {
+            this->found.push_back({ node.value.location, "division by zero, left to happen at run time" });
+            return;
+        }
+
+        if (auto const result = evaluate(op, *left, *right))
+            to_value(*result, 2);
+
+        return;
+    }
+
+    switch (op) {
+    case operations::MULTIPLICATION:
+        if (is_integer(rhs, 1))
+            to_operand(lhs);
+        else if (is_integer(lhs, 1))
+            to_operand(rhs);
+        break;
+    case operations::DIVISION:
+        if (is_integer(rhs, 1))
+            to_operand(lhs);
+        break;
+    case operations::POSITIVE:
+        if (is_integer(rhs, 0))
+            to_operand(lhs);
+        else if (is_integer(lhs, 0))
+            to_operand(rhs);
+        break;
+    case operations::NEGATIVE:
+        if (is_integer(rhs, 0))
+            to_operand(lhs);
+        break;
+    case operations::AND:
+    case operations::OR: {
+        if (!left && !right)
+            break;
+
+        // the side deciding the result by itself, for and a false, for or a true
+        auto const decisive = op == operations::OR;
+
+        auto const [constant, other] = left ? std::pair { *left, rhs } : std::pair { *right, lhs };
+
+        if (constant.truth() != decisive) {
+            if (is_boolean(other))
+                to_operand(other);
+        } else if (auto const shape = shape_of(other); shape.pure) {
+            to_value(decisive, 1 + shape.nodes);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+auto ast_folder::fold_conversion(ast_node& node) -> void
+{
+    auto const operand = literal_of(node.children.first);
+
+    if (!operand)
+        return;
+
+    lexic_value value;
+
+    switch (std::get<types>(node.value.value)) {
+    case types::FLOAT:
+        value = operand->real;
+        break;
+    case types::INT: {
+        // as the conversion would at run time, from a single precision float
+        auto const real = static_cast<float>(operand->real);
+
+        if (!(real >= -2147483648.0f && real < 2147483648.0f))
+            return;
+
+        value = static_cast<int>(real);
+        break;
+    }
+    case types::BOOL:
+        value = operand->truth();
+        break;
+    default:
+        return;
+    }
+
+    node.value.value = value;
+    node.children    = {};
+
+    ++this->counts.folded;
+    ++this->counts.removed;
+}
+
+auto ast_folder::prune_if(ast_node& node) -> void
+{
+    auto const condition = node.children.first;
+    auto const constant  = literal_of(condition);
+
+    if (!constant)
+        return;
+
+    auto const [then_block, else_block] = branches_of(node);
+    auto const [taken, dropped]         = constant->truth() ? std::pair { then_block, else_block } : std::pair { else_block, then_block };
+
+    ++this->counts.pruned;
+    this->counts.removed += 2 + shape_of(dropped).nodes;
+
+    this->replace(node, taken);
+}
+
+auto ast_folder::prune_while(ast_node& node) -> void
+{
+    auto const condition = node.children.first;
+    auto const constant  = literal_of(condition);
+
+    // a loop that never ends is left as it is
+    if (!constant || constant->truth())
+        return;
+
+    ++this->counts.pruned;
+    this->counts.removed += 2 + shape_of(condition->sibling).nodes;
+
+    this->replace(node, nullptr);
+}
+
+auto ast_folder::replace(ast_node& node, ast_node* replacement) -> void
+{
+    if (replacement == nullptr) {
+        node.value.value = std::monostate {};
+        node.children    = {};
+        return;
+    }
+
+    node.value    = replacement->value;
+    node.children = replacement->children;
+
+    // the rest of a block goes between the node and what came after it
+    if (replacement->next != nullptr) {
+        auto last = replacement->next;
+
+        while (last->next != nullptr)
+            last = last->next;
+
+        last->next = node.next;
+        node.next  = replacement->next;
+    }
+}
+
+auto ast_folder::remove_empty(ast_node* root) -> void
+{
+    auto const first_kept = [](ast_node* node) {
+        while (is_removed(node))
+            node = node->next;
+
+        return node;
+    };
+
+    // a removed node is either in a chain or heads one hanging as a child,
+    // in which case the rest of its chain takes its place
+    for (auto& node : root->preorder()) {
+        decltype(node.children) kept;
+
+        for (auto child = node.children.first; child != nullptr;) {
+            auto const sibling = child->sibling;
+
+            if (auto const first = first_kept(child); first != nullptr) {
+                first->sibling = nullptr;
+                kept.push_back(first);
+            }
+
+            child = sibling;
+        }
+
+        node.children = kept;
+        node.next     = first_kept(node.next);
+    }
+}
+
+}
@@ -0,0 +1,198 @@
+/** @file flat_ast.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "flat_ast.hh"
+
+#include <bit>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+#include <magic_enum.hpp>
+
+namespace hcpsilva {
+
+namespace {
+
+    // the enums are laid out in node_kind from these, in their own order
+    template <typename E>
+    constexpr auto first_kind = node_kind::NONE;
+
+    template <>
+    constexpr auto first_kind<types> = node_kind::INT;
+
+    template <>
+    constexpr auto first_kind<keywords> = node_kind::IF;
+
+    template <>
+    constexpr auto first_kind<operations> = node_kind::ATTRIBUTION;
+
+    constexpr auto distance(node_kind from, node_kind to) -> std::size_t
+    {
+        return static_cast<std::size_t>(to) - static_cast<std::size_t>(from);
+    }
+
+    static_assert(distance(node_kind::INT, node_kind::IF) == magic_enum::enum_count<types>());
+    static_assert(distance(node_kind::IF, node_kind::ATTRIBUTION) == magic_enum::enum_count<keywords>());
+    static_assert(distance(node_kind::ATTRIBUTION, node_kind::INTEGER) == magic_enum::enum_count<operations>());
+
+    constexpr auto limit = std::numeric_limits<std::uint32_t>::max();
+
+    template <typename E>
+    auto enum_of(node_kind kind) -> E
+    {
+        return static_cast<E>(distance(first_kind<E>, kind));
+    }
+
+}
+
+auto kind_of(lexic_value const& value) -> node_kind
+{
+    return std::visit(
+        [](auto const& alternative) {
+            using type = std::decay_t<decltype(alternative)>;
+
+            if constexpr (std::is_enum_v<type>)
+                return static_cast<node_kind>(static_cast<std::size_t>(first_kind<type>) + static_cast<std::size_t>(alternative));
+            else if constexpr (std::is_same_v<type, int>)
+                return node_kind::INTEGER;
+            else if constexpr (std::is_same_v<type, bool>)
+                return node_kind::BOOLEAN;
+            else if constexpr (std::is_same_v<type, double>)
+                return node_kind::FLOATING_POINT;
+            else if constexpr (std::is_same_v<type, char>)
+                return node_kind::CHARACTER;
+            else if constexpr (std::is_same_v<type, identifier>)
+                return node_kind::IDENTIFIER;
+            else if constexpr (std::is_same_v<type, function_call>)
+                return node_kind::CALL;
+            else
+                return node_kind::NONE;
+        },
+        value);
+}
+
+auto flat_ast::from(ast_node const* root, std::size_t nodes) -> flat_ast
+{
+    flat_ast result;
+
+    if (root == nullptr)
+        return result;
+
+    result.kinds.reserve(nodes);
+    result.ranges.reserve(nodes);
+    result.payloads.reserve(nodes);
+    result.locations.reserve(nodes);
+
+    // the nodes in the order they are numbered, which doubles as the queue
+    // of the breadth first walk
+    std::vector<ast_node const*> order;
+
+    order.reserve(nodes);
+    order.push_back(root);
+
+    for (std::size_t index = 0; index < order.size(); ++index) {
+        auto const node  = order[index];
+        auto const first = order.size();
+
+        for (auto const& child : node->children)
+            order.push_back(&child);
+
+        if (node->next != nullptr)
+            order.push_back(node->next);
+
+        if (order.size() > limit || order.size() - first > std::numeric_limits<std::uint16_t>::max())
+            throw std::runtime_error("ast error, tree too large to be laid out flat\n");
+
+        auto const kind = kind_of(node->value.value);
+
+        std::uint32_t payload = 0;
+
+        std::visit(
+            [&](auto const& alternative) {
+                using type = std::decay_t<decltype(alternative)>;
+
+                if constexpr (std::is_same_v<type, double>) {
+                    payload = static_cast<std::uint32_t>(result.floats.size());
+                    result.floats.push_back(alternative);
+                } else if constexpr (std::is_same_v<type, int>) {
+                    payload = std::bit_cast<std::uint32_t>(alternative);
+                } else if constexpr (std::is_same_v<type, bool> || std::is_same_v<type, char>) {
+                    payload = static_cast<unsigned char>(alternative);
+                } else if constexpr (std::is_same_v<type, identifier>) {
+                    payload = alternative.id;
+                } else if constexpr (std::is_same_v<type, function_call>) {
+                    payload = alternative.callee.id;
+                }
+            },
+            node->value.value);
+
+        result.kinds.push_back(kind);
+        result.payloads.push_back(payload);
+        result.locations.push_back(node->value.location);
+        result.ranges.push_back(child_range {
+            static_cast<std::uint32_t>(first),
+            static_cast<std::uint16_t>(order.size() - first),
+            static_cast<std::uint16_t>(node->next != nullptr),
+        });
+    }
+
+    return result;
+}
+
+auto flat_ast::value(std::size_t node) const -> lexic_value
+{
+    auto const kind    = this->kinds[node];
+    auto const payload = this->payloads[node];
+
+    switch (kind) {
+    case node_kind::NONE:
+        return std::monostate {};
+    case node_kind::INTEGER:
+        return std::bit_cast<int>(payload);
+    case node_kind::BOOLEAN:
+        return payload != 0;
+    case node_kind::FLOATING_POINT:
+        return this->floats[payload];
+    case node_kind::CHARACTER:
+        return static_cast<char>(payload);
+    case node_kind::IDENTIFIER:
+        return identifier { payload };
+    case node_kind::CALL:
+        return function_call { identifier { payload } };
+    default:
+        break;
+    }
+
+    if (kind < node_kind::IF)
+        return enum_of<types>(kind);
+
+    if (kind < node_kind::ATTRIBUTION)
+        return enum_of<keywords>(kind);
+
+    return enum_of<operations>(kind);
+}
+
+auto flat_ast::hot_bytes() const -> std::size_t
+{
+    return this->kinds.capacity() * sizeof(node_kind) + this->ranges.capacity() * sizeof(child_range)
+        + this->payloads.capacity() * sizeof(std::uint32_t) + this->floats.capacity() * sizeof(double);
+}
+
+auto flat_ast::bytes() const -> std::size_t
+{
+    return this->hot_bytes() + this->locations.capacity() * sizeof(yy::location);
+}
+
+}
@@ -0,0 +1,133 @@
+/** @file symbol.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "symbol.hh"
+
+#include <new>
+
+namespace hcpsilva {
+
+namespace {
+
+    constexpr std::uint32_t initial_capacity = 8;
+
+}
+
+symbol_table::symbol_table()
+{
+    this->scopes.push_back(scope { .mark = this->storage.mark() });
+}
+
+auto symbol_table::enter() -> void
+{
+    this->scopes.push_back(scope { .mark = this->storage.mark() });
+}
+
+auto symbol_table::leave() -> void
+{
+    if (this->scopes.size() == 1)
+        return;
+
+    auto const& current = this->scopes.back();
+
+    if (current.count != 0)
+        this->populated.pop_back();
+
+    // scopes open and close as a stack, and so does everything they allocate
+    this->storage.rewind(current.mark);
+    this->scopes.pop_back();
+}
+
+auto symbol_table::clear() -> void
+{
+    this->scopes.clear();
+    this->populated.clear();
+    this->storage.reset();
+
+    this->scopes.push_back(scope { .mark = this->storage.mark() });
+}
+
+auto symbol_table::slot_of(identifier name, std::uint32_t capacity) -> std::uint32_t
+{
+    // ids are handed out in sequence, multiplying spreads them over the table
+    return static_cast<std::uint32_t>((name.id * 0x9e3779b97f4a7c15) >> 32) & (capacity - 1);
+}
+
+auto symbol_table::grow(scope& current) -> void
+{
+    auto const capacity = current.capacity == 0 ? initial_capacity : current.capacity * 2;
+    auto const slots    = static_cast<entry*>(this->storage.allocate(capacity * sizeof(entry), alignof(entry)));
+
+    for (std::uint32_t i = 0; i < capacity; ++i)
+        ::new (slots + i) entry {};
+
+    // only the current scope ever grows, so the old slots are simply left
+    // behind in the arena until the scope closes
+    for (std::uint32_t i = 0; i < current.capacity; ++i) {
+        auto const& old = current.slots[i];
+
+        if (old.key == 0)
+            continue;
+
+        auto slot = slot_of(identifier { old.key - 1 }, capacity);
+
+        while (slots[slot].key != 0)
+            slot = (slot + 1) & (capacity - 1);
+
+        slots[slot] = old;
+    }
+
+    current.slots    = slots;
+    current.capacity = capacity;
+}
+
+auto symbol_table::declare(identifier name, symbol const& value) -> symbol const*
+{
+    auto& current = this->scopes.back();
+
+    // kept at most half full
+    if ((current.count + 1) * 2 > current.capacity)
+        this->grow(current);
+
+    auto slot = slot_of(name, current.capacity);
+
+    for (; current.slots[slot].key != 0; slot = (slot + 1) & (current.capacity - 1)) {
+        if (current.slots[slot].key == name.id + 1)
+            return &current.slots[slot].value;
+    }
+
+    current.slots[slot] = entry { name.id + 1, value };
+
+    if (current.count++ == 0)
+        this->populated.push_back(static_cast<std::uint32_t>(this->scopes.size() - 1));
+
+    return nullptr;
+}
+
+auto symbol_table::find(identifier name) const -> symbol const*
+{
+    for (auto index = this->populated.rbegin(); index != this->populated.rend(); ++index) {
+        auto const& current = this->scopes[*index];
+
+        auto slot = slot_of(name, current.capacity);
+
+        for (; current.slots[slot].key != 0; slot = (slot + 1) & (current.capacity - 1)) {
+            if (current.slots[slot].key == name.id + 1)
+                return &current.slots[slot].value;
+        }
+    }
+
+    return nullptr;
+}
+
+}
@@ -0,0 +1,294 @@
+/** @file type_checker.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "type_checker.hh"
+
+#include <string>
+#include <type_traits>
+#include <variant>
+
+#include <fmt/core.h>
+
+#include "parser.hh"
+
+namespace hcpsilva {
+
+namespace {
+
+    constexpr auto index(types type) -> std::size_t
+    {
+        return static_cast<std::size_t>(type);
+    }
+
+    // an operation over operands of given types
+    struct typing {
+        bool  valid    = false;
+        bool  converts = false; // the operands to the type below
+        types operands = types::INT;
+        types result   = types::INT;
+    };
+
+    using typing_table = std::array<std::array<std::array<typing, type_count>, type_count>, operand_rules.size()>;
+
+    // every operator over every pair of types (an operand twice for unary
+    // ones), worked out of the tables of the header once and for all
+    consteval auto make_typings() -> typing_table
+    {
+        typing_table table {};
+
+        for (std::size_t op = 0; op < operand_rules.size(); ++op) {
+            for (std::size_t lhs = 0; lhs < type_count; ++lhs) {
+                for (std::size_t rhs = 0; rhs < type_count; ++rhs) {
+                    auto const common = common_types[lhs][rhs];
+                    auto const number = common.has_value() && *common != types::CHAR;
+                    auto const truth  = conversions[lhs][index(types::BOOL)] != conversion::INVALID
+                        && conversions[rhs][index(types::BOOL)] != conversion::INVALID;
+
+                    auto& entry = table[op][lhs][rhs];
+
+                    switch (operand_rules[op]) {
+                    case operand_rule::NONE:
+                        break;
+                    case operand_rule::ARITHMETIC:
+                        entry = { number, true, common.value_or(types::INT), common.value_or(types::INT) };
+                        break;
+                    case operand_rule::INTEGER:
+                        entry = { number, true, types::INT, types::INT };
+                        break;
+                    case operand_rule::ORDER:
+                        entry = { common.has_value(), true, common.value_or(types::INT), types::BOOL };
+                        break;
+                    case operand_rule::TRUTH:
+                        entry = { truth, false, types::BOOL, types::BOOL };
+                        break;
+                    }
+                }
+            }
+        }
+
+        return table;
+    }
+
+    constexpr auto typings = make_typings();
+
+    constexpr auto typing_of(operations op, types lhs, types rhs) -> typing const&
+    {
+        return typings[static_cast<std::size_t>(op)][index(lhs)][index(rhs)];
+    }
+
+    static_assert(typing_of(operations::POSITIVE, types::INT, types::FLOAT).operands == types::FLOAT);
+    static_assert(typing_of(operations::NEGATIVE, types::BOOL, types::BOOL).result == types::INT);
+    static_assert(typing_of(operations::REST, types::FLOAT, types::INT).result == types::INT);
+    static_assert(typing_of(operations::EQUAL, types::CHAR, types::CHAR).result == types::BOOL);
+    static_assert(!typing_of(operations::LESS_THAN, types::CHAR, types::INT).valid);
+    static_assert(!typing_of(operations::AND, types::CHAR, types::BOOL).valid);
+    static_assert(!typing_of(operations::INDEX, types::INT, types::INT).valid);
+
+    // the type of a literal
+    template <typename T>
+    constexpr auto literal_type = std::is_same_v<T, double> ? types::FLOAT
+        : std::is_same_v<T, bool>                          ? types::BOOL
+        : std::is_same_v<T, char>                          ? types::CHAR
+                                                           : types::INT;
+
+    auto semantic_error(ast_node const& node, std::string const& message) -> yy::parser::syntax_error
+    {
+        return yy::parser::syntax_error(node.value.location, "semantic error, " + message);
+    }
+
+}
+
+type_checker::type_checker(arena& storage, string_pool const& strings, symbol_table const& symbols,
+    program_bindings const& bindings)
+    : storage(storage)
+    , strings(strings)
+    , symbols(symbols)
+    , bindings(bindings)
+{
+}
+
+auto type_checker::check(ast_node& function) -> void
+{
+    this->returned      = this->symbols.find(std::get<identifier>(function.value.value))->type;
+    function.value.type = this->returned;
+
+    // the functions after this one hang from its next link, so the walk
+    // starts at its body
+    if (function.children.first == nullptr)
+        return;
+
+    // each node is done after its operands, which only ever get converted
+    // once done, leaving the links the walk goes by as they were
+    for (auto& node : function.children.first->postorder()) {
+        std::visit(
+            [&](auto const& value) {
+                using type = std::decay_t<decltype(value)>;
+
+                if constexpr (std::is_same_v<type, operations>)
+                    this->check_operation(node, value);
+                else if constexpr (std::is_same_v<type, function_call>)
+                    this->check_call(node, value.callee);
+                else if constexpr (std::is_same_v<type, keywords>)
+                    this->check_keyword(node, value);
+                else if constexpr (type_in<type, int, double, bool, char>)
+                    node.value.type = literal_type<type>;
+            },
+            node.value.value);
+    }
+}
+
+auto type_checker::check_operation(ast_node& node, operations op) -> void
+{
+    auto const lhs = node.children.first;
+
+    switch (op) {
+    case operations::ATTRIBUTION:
+    case operations::INITIALIZATION:
+        this->convert(node, lhs->sibling, lhs->value.type);
+        node.value.type = lhs->value.type;
+        return;
+    case operations::INDEX:
+        this->check_index(node);
+        return;
+    case operations::INDEX_SEP:
+        // the last of its children is an index, any other the separator
+        // before it
+        this->convert(node, lhs->sibling != nullptr ? lhs->sibling : node.children.first, types::INT);
+        node.value.type = types::INT;
+        return;
+    default:
+        break;
+    }
+
+    auto const rhs    = lhs->sibling;
+    auto const unary  = rhs == nullptr;
+    auto const right  = unary ? lhs->value.type : rhs->value.type;
+    auto const& entry = typing_of(op, lhs->value.type, right);
+
+    if (!entry.valid) {
+        if (unary)
+            throw semantic_error(node, fmt::format("\"{}\" can't be applied to {}", op, lhs->value.type));
+
+        throw semantic_error(node, fmt::format("\"{}\" can't be applied to {} and {}", op, lhs->value.type, right));
+    }
+
+    if (entry.converts) {
+        this->convert(node, node.children.first, entry.operands);
+
+        if (!unary)
+            this->convert(node, node.children.first->sibling, entry.operands);
+    }
+
+    node.value.type = entry.result;
+}
+
+auto type_checker::check_index(ast_node& node) -> void
+{
+    auto const name    = node.children.first;
+    auto const array   = this->symbols.find(std::get<identifier>(name->value.value));
+    auto const& global = this->bindings.globals[array->variable.number];
+
+    // a[i ^ j ^ k] is sep(sep(sep(i), j), k)
+    std::size_t count = 0;
+
+    for (auto separator = name->sibling; separator != nullptr; ++count)
+        separator = separator->children.first->sibling != nullptr ? separator->children.first : nullptr;
+
+    if (count != global.dimensions.size())
+        throw semantic_error(node, fmt::format("\"{}\" has {} dimensions, but is indexed with {}",
+            this->strings.name(global.name), global.dimensions.size(), count));
+
+    node.value.type = name->value.type = array->type;
+}
+
+auto type_checker::check_call(ast_node& node, identifier callee) -> void
+{
+    auto const& function = this->bindings.functions[this->symbols.find(callee)->variable.number];
+
+    std::size_t count = 0;
+
+    for (auto argument = node.children.first; argument != nullptr; argument = argument->next)
+        ++count;
+
+    if (count != function.parameters)
+        throw semantic_error(node, fmt::format("\"{}\" takes {} arguments, but is given {}",
+            this->strings.name(callee), function.parameters, count));
+
+    // the arguments are chained, the first being the only child
+    auto link = &node.children.first;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        this->convert(node, *link, function.variables[i]);
+        link = &(*link)->next;
+    }
+
+    node.value.type = function.type;
+}
+
+auto type_checker::check_keyword(ast_node& node, keywords keyword) -> void
+{
+    auto const first = node.children.first;
+
+    switch (keyword) {
+    case keywords::IF:
+    case keywords::WHILE: {
+        // taken as a bool, which needs no conversion of its own
+        auto const type = first->value.type;
+
+        if (conversions[index(type)][index(types::BOOL)] == conversion::INVALID)
+            throw semantic_error(*first, fmt::format("{} can't be converted to {}", type, types::BOOL));
+        break;
+    }
+    case keywords::RETURN:
+        this->convert(node, node.children.first, this->returned);
+        break;
+    case keywords::INPUT:
+    case keywords::OUTPUT:
+        break;
+    }
+}
+
+auto type_checker::convert(ast_node& parent, ast_node*& link, types type) -> void
+{
+    auto const operand = link;
+    auto const from    = operand->value.type;
+
+    switch (conversions[index(from)][index(type)]) {
+    case conversion::NONE:
+        return;
+    case conversion::INVALID:
+        throw semantic_error(*operand, fmt::format("{} can't be converted to {}", from, type));
+    case conversion::NODE:
+        break;
+    }
+
+    auto const sibling = operand->sibling;
+    auto const next    = operand->next;
+
+    operand->sibling = nullptr;
+    operand->next    = nullptr;
+
+    auto const converted = this->storage.make<ast_node>(ast_value { type, operand->value.location, type }, operand);
+
+    converted->sibling = sibling;
+    converted->next    = next;
+
+    if (parent.children.last == operand)
+        parent.children.last = converted;
+
+    link = converted;
+
+    ++this->added_nodes;
+}
+
+}
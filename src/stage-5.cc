@@ -0,0 +1,26 @@
+/*
+ * Função principal para realização da E5.
+ */
+
+#include <cstdio>
+#include <exception>
+
+#include "driver.hh"
+
+auto main(void) -> int
+{
+    hcpsilva::driver driver;
+
+    int ret = driver.parse();
+
+    if (ret == 0) {
+        try {
+            driver.print_iloc();
+        } catch (std::exception const& error) {
+            std::fputs(error.what(), stderr);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,35 @@
+/*
+ * Função principal para realização da E6.
+ *
+ * Executa o programa dado, lendo sua entrada da entrada padrão:
+ *
+ *     stage-6 programa.txt < entrada.txt
+ */
+
+#include <cstdio>
+#include <exception>
+
+#include "driver.hh"
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc != 2) {
+        std::fputs("usage: stage-6 FILE\n", stderr);
+        return 1;
+    }
+
+    hcpsilva::driver driver(argv[1]);
+
+    int ret = driver.parse();
+
+    if (ret == 0) {
+        try {
+            ret = driver.run();
+        } catch (std::exception const& error) {
+            std::fputs(error.what(), stderr);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
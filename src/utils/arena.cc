@@ -0,0 +1,150 @@
+/** @file arena.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "arena.hh"
+
+namespace hcpsilva {
+
+arena::~arena()
+{
+    this->finalize();
+
+    release(this->chunks);
+    release(this->oversized);
+}
+
+auto arena::release(chunk* chunks) -> void
+{
+    for (auto current = chunks; current != nullptr;) {
+        auto previous = current->previous;
+
+        ::operator delete(current);
+
+        current = previous;
+    }
+}
+
+auto arena::finalize() -> void
+{
+    // objects are destroyed in the reverse order of their construction
+    for (auto current = this->finalizers; current != nullptr; current = current->previous)
+        current->destroy(current->object);
+
+    this->finalizers = nullptr;
+}
+
+auto arena::reset() -> void
+{
+    this->finalize();
+
+    release(this->oversized);
+
+    this->oversized = nullptr;
+
+    if (this->chunks == nullptr) {
+        this->used     = 0;
+        this->reserved = 0;
+        return;
+    }
+
+    release(this->chunks->previous);
+
+    this->chunks->previous = nullptr;
+
+    this->cursor   = reinterpret_cast<std::byte*>(this->chunks + 1);
+    this->limit    = reinterpret_cast<std::byte*>(this->chunks) + this->chunks->size;
+    this->used     = 0;
+    this->reserved = this->chunks->size;
+}
+
+auto arena::rewind(marker const& mark) -> void
+{
+    auto const last = static_cast<finalizer*>(mark.finalizers);
+
+    for (; this->finalizers != last; this->finalizers = this->finalizers->previous)
+        this->finalizers->destroy(this->finalizers->object);
+
+    // chunks grown since are dropped, the one the mark was in stays put
+    while (this->chunks != mark.chunk) {
+        auto previous = this->chunks->previous;
+
+        this->reserved -= this->chunks->size;
+
+        ::operator delete(this->chunks);
+
+        this->chunks = previous;
+    }
+
+    while (this->oversized != mark.oversized) {
+        auto previous = this->oversized->previous;
+
+        this->reserved -= this->oversized->size;
+
+        ::operator delete(this->oversized);
+
+        this->oversized = previous;
+    }
+
+    this->cursor = mark.cursor;
+    this->limit  = this->chunks ? reinterpret_cast<std::byte*>(this->chunks) + this->chunks->size : nullptr;
+    this->used   = mark.used;
+}
+
+auto arena::grow(std::size_t size, std::size_t alignment) -> void*
+{
+    if (size + alignment > this->chunk_size)
+        return this->allocate_oversized(size, alignment);
+
+    // what was left of the current chunk is given up on, it's too small
+    auto const total = sizeof(chunk) + this->chunk_size;
+
+    auto new_chunk = static_cast<chunk*>(::operator new(total));
+
+    new_chunk->previous = this->chunks;
+    new_chunk->size     = total;
+
+    this->chunks = new_chunk;
+    this->reserved += total;
+
+    this->cursor = reinterpret_cast<std::byte*>(new_chunk + 1);
+    this->limit  = reinterpret_cast<std::byte*>(new_chunk) + total;
+
+    return this->allocate(size, alignment);
+}
+
+auto arena::allocate_oversized(std::size_t size, std::size_t alignment) -> void*
+{
+    auto const total = sizeof(chunk) + size + alignment;
+
+    auto new_chunk = static_cast<chunk*>(::operator new(total));
+
+    new_chunk->previous = this->oversized;
+    new_chunk->size     = total;
+
+    this->oversized = new_chunk;
+    this->reserved += total;
+    this->used += size;
+
+    auto const address = reinterpret_cast<std::uintptr_t>(new_chunk + 1);
+
+    return reinterpret_cast<void*>((address + alignment - 1) & ~(alignment - 1));
+}
+
+auto arena::register_finalizer(void* object, void (*destroy)(void*)) -> void
+{
+    auto entry = ::new (this->allocate(sizeof(finalizer), alignof(finalizer))) finalizer { destroy, object, this->finalizers };
+
+    this->finalizers = entry;
+}
+
+}
@@ -0,0 +1,206 @@
+/** @file instrumentation.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "instrumentation.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+
+#include <fmt/core.h>
+#include <sys/resource.h>
+
+#ifdef INSTRUMENTATION
+
+namespace {
+
+// bytes allocated through operator new by each thread, which is all it costs
+thread_local std::size_t allocated_so_far = 0;
+
+// what the default operator new does: asks the new handler, if any, to make
+// room until the allocation succeeds
+template <typename Allocation>
+auto allocate_or_handle(Allocation allocation) -> void*
+{
+    while (true) {
+        if (auto* const memory = allocation())
+            return memory;
+
+        auto const handler = std::get_new_handler();
+
+        if (handler == nullptr)
+            throw std::bad_alloc();
+
+        handler();
+    }
+}
+
+auto allocate(std::size_t size) -> void*
+{
+    allocated_so_far += size;
+
+    return allocate_or_handle([=] { return std::malloc(size == 0 ? 1 : size); });
+}
+
+auto allocate(std::size_t size, std::align_val_t alignment) -> void*
+{
+    allocated_so_far += size;
+
+    auto const align = static_cast<std::size_t>(alignment);
+
+    // aligned_alloc takes sizes in (nonzero) multiples of the alignment only
+    auto const rounded = std::max(align, (size + align - 1) / align * align);
+
+    return allocate_or_handle([=] { return std::aligned_alloc(align, rounded); });
+}
+
+}
+
+// the rest of the operators (array, nothrow) come to these
+auto operator new(std::size_t size) -> void* { return allocate(size); }
+auto operator new[](std::size_t size) -> void* { return allocate(size); }
+auto operator new(std::size_t size, std::align_val_t alignment) -> void* { return allocate(size, alignment); }
+auto operator new[](std::size_t size, std::align_val_t alignment) -> void* { return allocate(size, alignment); }
+
+auto operator delete(void* memory) noexcept -> void { std::free(memory); }
+auto operator delete[](void* memory) noexcept -> void { std::free(memory); }
+auto operator delete(void* memory, std::size_t) noexcept -> void { std::free(memory); }
+auto operator delete[](void* memory, std::size_t) noexcept -> void { std::free(memory); }
+auto operator delete(void* memory, std::align_val_t) noexcept -> void { std::free(memory); }
+auto operator delete[](void* memory, std::align_val_t) noexcept -> void { std::free(memory); }
+auto operator delete(void* memory, std::size_t, std::align_val_t) noexcept -> void { std::free(memory); }
+auto operator delete[](void* memory, std::size_t, std::align_val_t) noexcept -> void { std::free(memory); }
+
+#endif
+
+namespace hcpsilva {
+
+auto phase_name(phase which) -> std::string_view
+{
+    constexpr std::string_view names[phase_count] = { "scan", "parse", "semantic", "ast", "fold", "code", "print", "run" };
+
+    return names[static_cast<std::size_t>(which)];
+}
+
+auto compile_report::operator+=(compile_report const& other) -> compile_report&
+{
+    for (std::size_t i = 0; i < phase_count; ++i) {
+        this->phases[i].wall_seconds += other.phases[i].wall_seconds;
+        this->phases[i].cpu_seconds += other.phases[i].cpu_seconds;
+        this->phases[i].allocated += other.phases[i].allocated;
+    }
+
+    this->tokens += other.tokens;
+    this->nodes += other.nodes;
+
+    return *this;
+}
+
+auto thread_cpu_seconds() -> double
+{
+    timespec now {};
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+}
+
+auto allocated_bytes() -> std::size_t
+{
+#ifdef INSTRUMENTATION
+    return allocated_so_far;
+#else
+    return 0;
+#endif
+}
+
+auto peak_rss() -> std::size_t
+{
+    rusage usage {};
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+}
+
+auto print_time_report(compile_report const& report, std::size_t files, std::FILE* out) -> void
+{
+    double wall = 0, cpu = 0;
+
+    std::size_t allocated = 0;
+
+    fmt::print(out, "{:<12} {:>12} {:>12} {:>14}\n", "phase", "wall ms", "cpu ms", "allocated");
+
+    auto const print_phase = [&](phase which) {
+        auto const& measure = report[which];
+
+        fmt::print(out, "{:<12} {:>12.3f} {:>12.3f} {:>14}\n", phase_name(which), measure.wall_seconds * 1e3,
+            measure.cpu_seconds * 1e3, measure.allocated);
+
+        wall += measure.wall_seconds;
+        cpu += measure.cpu_seconds;
+        allocated += measure.allocated;
+    };
+
+    // the parts of the parse go under it, already counted in its time
+    auto const print_part = [&](phase which) {
+        auto const name = fmt::format("  {} ~", phase_name(which));
+
+        fmt::print(out, "{:<12} {:>12.3f} {:>12} {:>14}\n", name, report[which].wall_seconds * 1e3, "-", "-");
+    };
+
+    print_phase(phase::PARSE);
+
+    for (std::size_t i = 0; i < phase_count; ++i)
+        if (part_of_parse(static_cast<phase>(i)))
+            print_part(static_cast<phase>(i));
+
+    for (std::size_t i = 0; i < phase_count; ++i)
+        if (static_cast<phase>(i) != phase::PARSE && !part_of_parse(static_cast<phase>(i)))
+            print_phase(static_cast<phase>(i));
+
+    fmt::print(out, "{:<12} {:>12.3f} {:>12.3f} {:>14}\n", "total", wall * 1e3, cpu * 1e3, allocated);
+
+    auto const& scan = report[phase::SCAN];
+
+    fmt::print(out,
+        "{} files, {} tokens (~{:.0f} per second scanning), {} nodes, peak RSS of {} bytes\n"
+        "(~ parts of the parse, estimated and in wall time only)\n",
+        files, report.tokens, scan.wall_seconds == 0 ? 0 : static_cast<double>(report.tokens) / scan.wall_seconds,
+        report.nodes, peak_rss());
+}
+
+auto print_stats(compile_report const& report, std::size_t files, std::FILE* out) -> void
+{
+    fmt::print(out, "{{\"files\": {}, \"tokens\": {}, \"nodes\": {}, \"peak_rss\": {}, \"phases\": {{", files,
+        report.tokens, report.nodes, peak_rss());
+
+    for (std::size_t i = 0; i < phase_count; ++i) {
+        auto const  which   = static_cast<phase>(i);
+        auto const& measure = report.phases[i];
+
+        fmt::print(out, "{}\"{}\": {{\"wall_seconds\": {:.9f}", i == 0 ? "" : ", ", phase_name(which),
+            measure.wall_seconds);
+
+        // parts of the parse have no time of their own to add up, just a share of it
+        if (part_of_parse(which))
+            fmt::print(out, ", \"part_of\": \"parse\", \"estimated\": true}}");
+        else
+            fmt::print(out, ", \"cpu_seconds\": {:.9f}, \"allocated\": {}}}", measure.cpu_seconds, measure.allocated);
+    }
+
+    fmt::print(out, "}}}}\n");
+}
+
+}
@@ -0,0 +1,50 @@
+/** @file line_index.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "line_index.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace hcpsilva {
+
+auto line_index::at(std::string_view text, std::uint32_t offset) -> line_column
+{
+    // only what was added since the last call is gone over
+    while (this->indexed < text.size()) {
+        auto const from  = text.data() + this->indexed;
+        auto const found = static_cast<char const*>(std::memchr(from, '\n', text.size() - this->indexed));
+
+        if (found == nullptr) {
+            this->indexed = text.size();
+            break;
+        }
+
+        this->indexed = static_cast<std::size_t>(found - text.data()) + 1;
+        this->starts.push_back(static_cast<std::uint32_t>(this->indexed));
+    }
+
+    // the last line starting at or before offset
+    auto const line  = std::upper_bound(this->starts.begin(), this->starts.end(), offset) - 1;
+    auto const start = *line;
+
+    return { static_cast<int>(line - this->starts.begin()) + 1, static_cast<int>(offset - start) + 1 };
+}
+
+auto line_index::clear() -> void
+{
+    this->starts.assign(1, 0);
+    this->indexed = 0;
+}
+
+}
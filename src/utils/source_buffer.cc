@@ -0,0 +1,193 @@
+/** @file source_buffer.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "source_buffer.hh"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+namespace hcpsilva {
+
+source_buffer::source_buffer(source_buffer&& other) noexcept
+    : bytes(std::exchange(other.bytes, nullptr))
+    , length(std::exchange(other.length, 0))
+    , mapping_size(std::exchange(other.mapping_size, 0))
+{
+}
+
+auto source_buffer::operator=(source_buffer&& other) noexcept -> source_buffer&
+{
+    if (this != &other) {
+        this->release();
+
+        this->bytes        = std::exchange(other.bytes, nullptr);
+        this->length       = std::exchange(other.length, 0);
+        this->mapping_size = std::exchange(other.mapping_size, 0);
+    }
+
+    return *this;
+}
+
+source_buffer::~source_buffer()
+{
+    this->release();
+}
+
+auto source_buffer::release() -> void
+{
+    if (this->mapping_size != 0)
+        munmap(this->bytes, this->mapping_size);
+    else
+        std::free(this->bytes);
+
+    this->bytes        = nullptr;
+    this->length       = 0;
+    this->mapping_size = 0;
+}
+
+auto source_buffer::open(std::string const& file_name) -> source_buffer
+{
+    auto const descriptor = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (descriptor < 0)
+        throw std::runtime_error(fmt::format("driver error, could not open \"{}\": {}\n", file_name, std::strerror(errno)));
+
+    try {
+        auto buffer = open(descriptor);
+
+        ::close(descriptor);
+
+        return buffer;
+    } catch (...) {
+        ::close(descriptor);
+        throw;
+    }
+}
+
+auto source_buffer::open(int descriptor) -> source_buffer
+{
+    struct stat status;
+
+    if (fstat(descriptor, &status) != 0)
+        throw std::runtime_error(fmt::format("driver error, could not stat input: {}\n", std::strerror(errno)));
+
+    if (S_ISREG(status.st_mode) && status.st_size > 0)
+        return map(descriptor, static_cast<std::size_t>(status.st_size));
+
+    return read(descriptor);
+}
+
+auto source_buffer::mappable(int descriptor) -> bool
+{
+    struct stat status;
+
+    return fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode);
+}
+
+auto source_buffer::map(int descriptor, std::size_t size) -> source_buffer
+{
+    auto const page  = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto const total = (size + padding + page - 1) / page * page;
+
+    // reserve room for the padding first: the file is then mapped over the
+    // start of this zeroed region, so the bytes past its end read as NUL even
+    // when the file size is a multiple of the page size
+    auto region = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (region == MAP_FAILED)
+        throw std::runtime_error(fmt::format("driver error, could not reserve memory: {}\n", std::strerror(errno)));
+
+    if (mmap(region, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, descriptor, 0) == MAP_FAILED) {
+        auto const error = errno;
+
+        munmap(region, total);
+
+        throw std::runtime_error(fmt::format("driver error, could not map input: {}\n", std::strerror(error)));
+    }
+
+    madvise(region, size, MADV_SEQUENTIAL);
+
+    source_buffer buffer;
+
+    buffer.bytes        = static_cast<char*>(region);
+    buffer.length       = size;
+    buffer.mapping_size = total;
+
+    return buffer;
+}
+
+auto source_buffer::read(int descriptor) -> source_buffer
+{
+    std::size_t capacity = 64 * 1024;
+    std::size_t size     = 0;
+
+    auto bytes = static_cast<char*>(std::malloc(capacity));
+
+    if (bytes == nullptr)
+        throw std::runtime_error("driver error, could not reserve memory for the input\n");
+
+    for (;;) {
+        if (capacity - size < padding + 1) {
+            // the old block is still ours until the new one is there
+            auto const grown = static_cast<char*>(std::realloc(bytes, capacity * 2));
+
+            if (grown == nullptr) {
+                std::free(bytes);
+
+                throw std::runtime_error("driver error, could not reserve memory for the input\n");
+            }
+
+            bytes = grown;
+            capacity *= 2;
+        }
+
+        auto const count = ::read(descriptor, bytes + size, capacity - size - padding);
+
+        if (count == 0)
+            break;
+
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+
+            auto const error = errno;
+
+            std::free(bytes);
+
+            throw std::runtime_error(fmt::format("driver error, could not read input: {}\n", std::strerror(error)));
+        }
+
+        size += static_cast<std::size_t>(count);
+    }
+
+    std::memset(bytes + size, '\0', padding);
+
+    source_buffer buffer;
+
+    buffer.bytes  = bytes;
+    buffer.length = size;
+
+    return buffer;
+}
+
+}
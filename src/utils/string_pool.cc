@@ -0,0 +1,80 @@
+/** @file string_pool.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "string_pool.hh"
+
+#include <cstring>
+
+namespace hcpsilva {
+
+auto string_pool::hash(std::string_view text) -> std::uint64_t
+{
+    // 64 bit FNV-1a, identifiers are short so this is hard to beat
+    std::uint64_t value = 14695981039346656037ull;
+
+    for (auto const c : text) {
+        value ^= static_cast<unsigned char>(c);
+        value *= 1099511628211ull;
+    }
+
+    return value;
+}
+
+auto string_pool::intern(std::string_view text) -> identifier
+{
+    // keep the load factor under 1/2
+    if (2 * (this->names.size() + 1) > this->slots.size())
+        this->rehash(this->slots.empty() ? 256 : 2 * this->slots.size());
+
+    auto const value = hash(text);
+    auto const mask  = this->slots.size() - 1;
+
+    for (auto slot = value & mask;; slot = (slot + 1) & mask) {
+        auto const entry = this->slots[slot];
+
+        if (entry == empty_slot) {
+            auto const id      = static_cast<std::uint32_t>(this->names.size());
+            auto       storage = static_cast<char*>(this->characters.allocate(text.size() + 1, 1));
+
+            std::memcpy(storage, text.data(), text.size());
+            storage[text.size()] = '\0';
+
+            this->names.emplace_back(storage, text.size());
+            this->hashes.push_back(value);
+            this->slots[slot] = id + 1;
+
+            return identifier { id };
+        }
+
+        if (this->hashes[entry - 1] == value && this->names[entry - 1] == text)
+            return identifier { entry - 1 };
+    }
+}
+
+auto string_pool::rehash(std::size_t capacity) -> void
+{
+    this->slots.assign(capacity, empty_slot);
+
+    auto const mask = capacity - 1;
+
+    for (std::uint32_t id = 0; id < this->names.size(); ++id) {
+        auto slot = this->hashes[id] & mask;
+
+        while (this->slots[slot] != empty_slot)
+            slot = (slot + 1) & mask;
+
+        this->slots[slot] = id + 1;
+    }
+}
+
+}
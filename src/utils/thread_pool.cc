@@ -0,0 +1,171 @@
+/** @file thread_pool.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ */
+
+#include "thread_pool.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace hcpsilva {
+
+namespace {
+
+    // which pool and worker the current thread belongs to, if any
+    thread_local thread_pool const* current_pool   = nullptr;
+    thread_local std::size_t        current_worker = 0;
+
+}
+
+thread_pool::thread_pool(std::size_t threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (std::size_t i = 0; i < threads; ++i)
+        this->queues.push_back(std::make_unique<queue>());
+
+    for (std::size_t i = 0; i < threads; ++i)
+        this->workers.emplace_back([this, i] { this->run(i); });
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::unique_lock lock(this->state_lock);
+
+        this->all_done.wait(lock, [this] { return this->unfinished == 0; });
+
+        this->stopping = true;
+    }
+
+    this->work_available.notify_all();
+
+    for (auto& worker : this->workers)
+        worker.join();
+}
+
+auto thread_pool::submit(task work) -> void
+{
+    std::size_t index;
+
+    if (current_pool == this) {
+        index = current_worker;
+    } else {
+        std::lock_guard lock(this->state_lock);
+
+        index = this->next_queue++ % this->queues.size();
+    }
+
+    // the task is in a queue before it's counted, so whoever is woken up by
+    // the count is sure to find something to run
+    {
+        std::lock_guard lock(this->queues[index]->lock);
+
+        this->queues[index]->tasks.push_back(std::move(work));
+    }
+
+    {
+        std::lock_guard lock(this->state_lock);
+
+        ++this->queued;
+        ++this->unfinished;
+    }
+
+    this->work_available.notify_one();
+}
+
+auto thread_pool::wait() -> void
+{
+    std::unique_lock lock(this->state_lock);
+
+    this->all_done.wait(lock, [this] { return this->unfinished == 0; });
+
+    if (this->failure)
+        std::rethrow_exception(std::exchange(this->failure, nullptr));
+}
+
+auto thread_pool::take(std::size_t index) -> std::optional<task>
+{
+    auto const count = this->queues.size();
+
+    // newest from our own queue, then the oldest of the others
+    for (std::size_t offset = 0; offset < count; ++offset) {
+        auto& victim = *this->queues[(index + offset) % count];
+
+        std::lock_guard lock(victim.lock);
+
+        if (victim.tasks.empty())
+            continue;
+
+        task work;
+
+        if (offset == 0) {
+            work = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        } else {
+            work = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+
+        return work;
+    }
+
+    return std::nullopt;
+}
+
+auto thread_pool::run(std::size_t index) -> void
+{
+    current_pool   = this;
+    current_worker = index;
+
+    for (;;) {
+        {
+            std::unique_lock lock(this->state_lock);
+
+            this->work_available.wait(lock, [this] { return this->queued != 0 || this->stopping; });
+
+            if (this->queued == 0)
+                return;
+
+            // claims one of the queued tasks, which is then looked for below
+            --this->queued;
+        }
+
+        std::optional<task> work;
+
+        // every claim is backed by a task in some queue, but another worker
+        // may take the one we saw first, so keep looking until one is found
+        while (!(work = this->take(index)))
+            std::this_thread::yield();
+
+        std::exception_ptr error;
+
+        try {
+            (*work)(index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard lock(this->state_lock);
+
+            if (error && !this->failure)
+                this->failure = error;
+
+            if (--this->unfinished == 0)
+                this->all_done.notify_all();
+        }
+    }
+}
+
+}
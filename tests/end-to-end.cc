@@ -0,0 +1,151 @@
+/** @file end-to-end.cc
+ *
+ * @copyright (C) 2022 Henrique Silva
+ *
+ *
+ * @author Henrique Silva <hcpsilva@inf.ufrgs.br>
+ *
+ * @section LICENSE
+ *
+ * This file is subject to the terms and conditions defined in the file
+ * 'LICENSE', which is part of this source code package.
+ *
+ * @section DESCRIPTION
+ *
+ * Runs a program of the corpus both ways it can be run: on the virtual machine
+ * (stage-6) and as a native executable, assembled and linked by the system C
+ * compiler out of what stage-7 writes. Both are given PROGRAM.in as input, if
+ * there is one, must print what is in PROGRAM.out and must exit with the same
+ * status. Takes the paths of stage-6, stage-7 and the C compiler, and then the
+ * program.
+ */
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+namespace {
+
+// runs arguments to completion, its standard input and output redirected to
+// the given files (if any), giving its exit status
+auto run(std::vector<std::string> const& arguments, std::string const& input, std::string const& output) -> int
+{
+    std::fflush(stdout);
+
+    auto const child = fork();
+
+    if (child < 0)
+        throw std::runtime_error("test error, could not fork\n");
+
+    if (child == 0) {
+        auto const in = open(input.empty() ? "/dev/null" : input.c_str(), O_RDONLY);
+
+        dup2(in, STDIN_FILENO);
+        close(in);
+
+        auto const out = open(output.empty() ? "/dev/null" : output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+        dup2(out, STDOUT_FILENO);
+        close(out);
+
+        std::vector<char*> argv;
+
+        for (auto const& argument : arguments)
+            argv.push_back(const_cast<char*>(argument.c_str()));
+
+        argv.push_back(nullptr);
+
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+
+    waitpid(child, &status, 0);
+
+    if (!WIFEXITED(status))
+        throw std::runtime_error(fmt::format("test error, {} did not exit\n", arguments.front()));
+
+    return WEXITSTATUS(status);
+}
+
+auto read_file(std::string const& path) -> std::string
+{
+    std::ifstream      in(path);
+    std::ostringstream text;
+
+    text << in.rdbuf();
+
+    return text.str();
+}
+
+auto check_output(std::string_view how, std::string const& printed, std::string const& expected) -> void
+{
+    if (printed != expected)
+        throw std::runtime_error(
+            fmt::format("test error, run {} it printed\n{}but was expected to print\n{}", how, printed, expected));
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc != 5) {
+        fmt::print(stderr, "usage: end-to-end STAGE-6 STAGE-7 CC PROGRAM\n");
+        return 2;
+    }
+
+    std::string const vm = argv[1], native = argv[2], compiler = argv[3], program = argv[4];
+
+    auto const stem  = std::filesystem::path(program).stem().string();
+    auto const input = std::filesystem::exists(program + ".in") ? program + ".in" : std::string();
+
+    // everything built and printed goes in a directory of its own
+    auto const directory = std::filesystem::temp_directory_path() / fmt::format("end-to-end-{}-{}", stem, getpid());
+    auto const path      = [&](std::string_view suffix) { return (directory / (stem + std::string(suffix))).string(); };
+
+    auto status = 0;
+
+    try {
+        std::filesystem::create_directories(directory);
+
+        auto const expected = read_file(program + ".out");
+
+        auto const vm_status = run({ vm, program }, input, path(".vm"));
+
+        check_output("on the virtual machine", read_file(path(".vm")), expected);
+
+        if (run({ native }, program, path(".s")) != 0)
+            throw std::runtime_error(fmt::format("test error, stage-7 could not translate \"{}\"\n", program));
+
+        if (run({ compiler, path(".s"), "-o", path("") }, "", "") != 0)
+            throw std::runtime_error(fmt::format("test error, the assembly of \"{}\" did not build\n", program));
+
+        auto const native_status = run({ path("") }, input, path(".native"));
+
+        check_output("natively", read_file(path(".native")), expected);
+
+        if (native_status != vm_status)
+            throw std::runtime_error(fmt::format("test error, run natively it exited with {}, but with {} on the "
+                                                 "virtual machine\n",
+                native_status, vm_status));
+    } catch (std::exception const& error) {
+        fmt::print(stderr, "{}", error.what());
+        status = 1;
+    }
+
+    std::filesystem::remove_all(directory);
+
+    return status;
+}